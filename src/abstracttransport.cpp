@@ -15,11 +15,12 @@
  */
 
 #include "private/transportprivate.hpp"
+#include "private/metrics.hpp"
 #include "nuria/abstracttransport.hpp"
 #include <nuria/logger.hpp>
 
+#include <QCoreApplication>
 #include <QMetaEnum>
-#include <QTimer>
 
 Nuria::AbstractTransport::AbstractTransport (QObject *parent)
         : AbstractTransport (new AbstractTransportPrivate, parent)
@@ -30,10 +31,8 @@ Nuria::AbstractTransport::AbstractTransport (QObject *parent)
 Nuria::AbstractTransport::AbstractTransport (AbstractTransportPrivate *d, QObject *parent)
         : QObject (parent), d_ptr (d)
 {
-	
-	// Timeout timer
-	this->d_ptr->timeoutTimer = new QTimer (this);
-	connect (this->d_ptr->timeoutTimer, &QTimer::timeout, this, &AbstractTransport::triggerTimeout);
+	this->d_ptr->q_ptr = this;
+	Internal::Metrics::add (Internal::Metrics::OpenTransports);
 }
 
 void Nuria::AbstractTransport::handleTimeout (Timeout timeout) {
@@ -47,6 +46,7 @@ void Nuria::AbstractTransport::handleTimeout (Timeout timeout) {
 }
 
 Nuria::AbstractTransport::~AbstractTransport () {
+	Internal::Metrics::subtract (Internal::Metrics::OpenTransports);
 	delete this->d_ptr;
 }
 
@@ -143,22 +143,72 @@ void Nuria::AbstractTransport::addBytesSent (uint64_t bytes) {
 	this->d_ptr->trafficSent += bytes;
 }
 
+static QEvent::Type rearmTimeoutEvent () {
+	static const QEvent::Type type = QEvent::Type (QEvent::registerEventType ());
+	return type;
+}
+
+bool Nuria::AbstractTransport::event (QEvent *event) {
+	
+	// The timer wheel belongs to the old thread. Arm the timeout again
+	// once we're in the new one, posted events are moved along.
+	if (event->type () == QEvent::ThreadChange && this->d_ptr->isArmed ()) {
+		Internal::TimerWheel::cancel (this->d_ptr);
+		QCoreApplication::postEvent (this, new QEvent (rearmTimeoutEvent ()));
+	} else if (event->type () == rearmTimeoutEvent ()) {
+		if (this->d_ptr->currentTimeoutMode != Disabled && this->d_ptr->timeoutInterval >= 0) {
+			Internal::TimerWheel::current ()->arm (this->d_ptr, this->d_ptr->timeoutInterval);
+		}
+		
+		return true;
+	}
+	
+	return QObject::event (event);
+}
+
 void Nuria::AbstractTransport::startTimeout (Timeout mode) {
 	this->d_ptr->trafficReceivedLast = this->d_ptr->trafficReceived;
 	this->d_ptr->currentTimeoutMode = mode;
 	int msec = timeout (mode);
 	
+	this->d_ptr->timeoutInterval = msec;
 	if (msec < 0) {
-		this->d_ptr->timeoutTimer->stop ();
+		Internal::TimerWheel::cancel (this->d_ptr);
 	} else {
-		this->d_ptr->timeoutTimer->start (msec);
+		Internal::TimerWheel::current ()->arm (this->d_ptr, msec);
 	}
 	
 }
 
 void Nuria::AbstractTransport::disableTimeout () {
 	this->d_ptr->currentTimeoutMode = Disabled;
-	this->d_ptr->timeoutTimer->stop ();
+	Internal::TimerWheel::cancel (this->d_ptr);
+}
+
+void Nuria::AbstractTransportPrivate::expired () {
+	
+	// Like the QTimer used before, check again after the same interval.
+	Internal::TimerWheel::current ()->arm (this, this->timeoutInterval);
+	this->q_ptr->triggerTimeout ();
+}
+
+static void countTimeout (Nuria::AbstractTransport::Timeout mode) {
+	using namespace Nuria::Internal;
+	
+	switch (mode) {
+	case Nuria::AbstractTransport::ConnectTimeout:
+		Metrics::add (Metrics::ConnectTimeouts);
+		break;
+	case Nuria::AbstractTransport::DataTimeout:
+		Metrics::add (Metrics::DataTimeouts);
+		break;
+	case Nuria::AbstractTransport::KeepAliveTimeout:
+		Metrics::add (Metrics::KeepAliveTimeouts);
+		break;
+	case Nuria::AbstractTransport::Disabled:
+		break;
+	}
+	
 }
 
 void Nuria::AbstractTransport::triggerTimeout () {
@@ -174,6 +224,7 @@ void Nuria::AbstractTransport::triggerTimeout () {
 	}
 	
 	// Timeout!
+	countTimeout (this->d_ptr->currentTimeoutMode);
 	handleTimeout (this->d_ptr->currentTimeoutMode);
 	emit connectionTimedout (this->d_ptr->currentTimeoutMode);
 }
@@ -16,10 +16,13 @@
 
 #include "nuria/httpclient.hpp"
 
+#include <QCoreApplication>
+#include <QMetaMethod>
 #include <QSslSocket>
 #include <QTcpSocket>
 #include <QDateTime>
 #include <QProcess>
+#include <QFile>
 #include <QDir>
 
 #include <nuria/temporarybufferdevice.hpp>
@@ -34,18 +37,27 @@
 #include "nuria/httpnode.hpp"
 #include <nuria/logger.hpp>
 
+#include "private/httpbodyproducerdevice.hpp"
 #include "private/standardfilters.hpp"
 #include "private/websocketreader.hpp"
 #include "private/httpprivate.hpp"
+#include "private/httpthread.hpp"
+#include "private/metrics.hpp"
+
+// Records the first time \a phase is reached, if phase timing is enabled.
+static inline void markPhase (Nuria::HttpClientPrivate *d, Nuria::HttpRequestTimings::Phase phase) {
+	if (d->timings && d->timings->timestamps[phase] < 0) {
+		d->timings->timestamps[phase] = d->timer.nsecsElapsed ();
+	}
+	
+}
 
 Nuria::HttpClient::HttpClient (HttpTransport *transport, HttpServer *server)
 	: QIODevice (transport), d_ptr (new HttpClientPrivate)
 {
 	
 	// Initialize
-	this->d_ptr->bufferDevice = new TemporaryBufferDevice (this);
-	this->d_ptr->transport = transport;
-	this->d_ptr->server = server;
+	initialize (transport, server, nullptr);
 	
 	// 
 	setOpenMode (QIODevice::ReadWrite);
@@ -54,9 +66,85 @@ Nuria::HttpClient::HttpClient (HttpTransport *transport, HttpServer *server)
 }
 
 Nuria::HttpClient::~HttpClient () {
+	Internal::CompressionFilter::destroyStream (this->d_ptr->deflateStream);
+	delete this->d_ptr->timings;
 	delete this->d_ptr;
 }
 
+void Nuria::HttpClient::initialize (HttpTransport *transport, HttpServer *server, QIODevice *buffer) {
+	if (buffer) {
+		buffer->reset ();
+	} else {
+		buffer = new TemporaryBufferDevice (this);
+	}
+	
+	this->d_ptr->bufferDevice = buffer;
+	this->d_ptr->transport = transport;
+	this->d_ptr->server = server;
+	this->d_ptr->timer.start ();
+	
+	if (server && server->phaseTimingEnabled ()) {
+		this->d_ptr->timings = new HttpRequestTimings;
+	}
+	
+}
+
+bool Nuria::HttpClient::isReusable () const {
+	if (!this->d_ptr->server || !this->d_ptr->server->clientPoolingEnabled () ||
+	    this->d_ptr->keepConnectionOpen || this->d_ptr->sendingFile) {
+		return false;
+	}
+	
+	// Someone who is still connected to us would notice the re-use. The
+	// only expected connection is the one made in the constructor.
+	static const QMetaMethod disconnectedSignal = QMetaMethod::fromSignal (&HttpClient::disconnected);
+	const QMetaObject *meta = metaObject ();
+	
+	for (int i = 0; i < meta->methodCount (); i++) {
+		QMetaMethod method = meta->method (i);
+		if (method.methodType () != QMetaMethod::Signal || !isSignalConnected (method)) {
+			continue;
+		}
+		
+		if (method != disconnectedSignal || receivers (SIGNAL(disconnected())) > 1) {
+			return false;
+		}
+		
+	}
+	
+	return true;
+}
+
+void Nuria::HttpClient::reuse (HttpTransport *transport, HttpServer *server) {
+	QCoreApplication::removePostedEvents (this);
+	
+	// Keep the post body buffer if it hasn't been used
+	QIODevice *buffer = this->d_ptr->bufferDevice;
+	if (!children ().contains (buffer) || !qobject_cast< TemporaryBufferDevice * > (buffer) ||
+	    buffer->size () > 0) {
+		buffer = nullptr;
+	}
+	
+	// Destroy everything else the previous request owned
+	const QObjectList objects = children ();
+	for (QObject *object : objects) {
+		if (object != buffer) {
+			delete object;
+		}
+		
+	}
+	
+	Internal::CompressionFilter::destroyStream (this->d_ptr->deflateStream);
+	delete this->d_ptr->timings;
+	*this->d_ptr = HttpClientPrivate ();
+	
+	// 
+	setParent (transport);
+	initialize (transport, server, buffer);
+	QIODevice::open (QIODevice::ReadWrite);
+	
+}
+
 Nuria::HttpTransport *Nuria::HttpClient::transport () const {
 	return this->d_ptr->transport;
 }
@@ -162,7 +250,7 @@ void Nuria::HttpClient::updateRequestedUrl () {
 }
 
 void Nuria::HttpClient::bytesSent (qint64 bytes) {
-	if (this->d_ptr->pipeDevice && this->d_ptr->pipeDevice->isReadable ()) {
+	if (this->d_ptr->pipeDevice && !this->d_ptr->sendingFile && !this->d_ptr->connectionClosed) {
 		QMetaObject::invokeMethod (this, "pipeToClientReadyRead", Qt::QueuedConnection);
 	}
 	
@@ -234,58 +322,28 @@ bool Nuria::HttpClient::send100ContinueIfClientExpectsIt () {
 	return true;
 }
 
-static inline bool byteArrayCanReadLine (const QByteArray &data) {
-	return data.contains ("\r\n");
-}
-
-static inline QByteArray byteArrayReadLine (QByteArray &data) {
-	enum { MaxLength = 4096 };
-	
-	int idx = data.indexOf ("\r\n");
-	if (idx > MaxLength) {
-		return QByteArray ();
-	}
-	
-	// 
-	QByteArray line = data.left (idx + 2);
-	data = data.mid (idx + 2);
-	return line;
-}
-
 bool Nuria::HttpClient::readAllAvailableHeaderLines (QByteArray &data) {
 	HttpParser parser;
 	
-	while (byteArrayCanReadLine (data)) {
-		QByteArray raw = byteArrayReadLine (data);
-		
-		// A line should end in \r\n, but also check for \n.
-		if (!parser.removeTrailingNewline (raw)) {
-			// Line too long, kill connection
-			killConnection (400);
-			return false;
-			
-		} else if (raw.isEmpty ()) {
-			this->d_ptr->headerReady = true;
-			
-			// If the line is empty, the header is complete.
-			return postProcessRequestHeader ();
-			
-		} else if (this->d_ptr->requestVersion == HttpUnknown) {
-			// This is the first line.
-			if (!readFirstLine (raw)) {
-				killConnection (400);
-				return false;
-			}
-			
-		} else if (!readHeader (raw)) {
-			killConnection (400);
-			return false;
-		}
-		
+	// The parser resumes where it stopped the last time. Incomplete data
+	// is left in the buffer of the transport.
+	switch (parser.parseRequestHeader (data, this->d_ptr->parserState)) {
+	case HttpParser::NeedMoreData:
+		return true;
+	case HttpParser::InvalidRequest:
+		killConnection (400);
+		return false;
+	case HttpParser::HeaderComplete:
+		break;
 	}
 	
+	// Take the header out of the buffer, leaving the body (if any).
+	readParsedHeader (data);
+	data.remove (0, this->d_ptr->parserState.offset);
+	
 	// 
-	return true;
+	this->d_ptr->headerReady = true;
+	return postProcessRequestHeader ();
 }
 
 void Nuria::HttpClient::initPath (QByteArray path) {
@@ -299,33 +357,20 @@ void Nuria::HttpClient::initPath (QByteArray path) {
 	this->d_ptr->path = QUrl::fromEncoded (path);	
 }
 
-bool Nuria::HttpClient::readFirstLine (const QByteArray &line) {
+void Nuria::HttpClient::readParsedHeader (const QByteArray &data) {
 	HttpParser parser;
+	const HttpParser::RequestState &state = this->d_ptr->parserState;
 	
-	QByteArray path;
-	bool success = false;
-	
-	success = parser.parseFirstLineFull (line, this->d_ptr->requestType,
-					     path, this->d_ptr->requestVersion);
+	this->d_ptr->requestType = state.verb;
+	this->d_ptr->requestVersion = state.version;
+	initPath (state.path.toByteArray (data));
 	
-	// 
-	initPath(path);
-	return success;
-}
-
-bool Nuria::HttpClient::readHeader (const QByteArray &line) {
-	HttpParser parser;
-	QByteArray key;
-	QByteArray value;
-	
-	if (!parser.parseHeaderLine (line, key, value)) {
-		killConnection (400);
-		return false;
+	// Store
+	for (const HttpParser::HeaderField &field : state.headers) {
+		QByteArray key = parser.correctHeaderKeyCase (field.name.toByteArray (data));
+		this->d_ptr->requestHeaders.insert (key, field.value.toByteArray (data));
 	}
 	
-	// Store
-	this->d_ptr->requestHeaders.insert (parser.correctHeaderKeyCase (key), value);
-	return true;
 }
 
 bool Nuria::HttpClient::isReceivedHeaderHttp11Compliant () {
@@ -511,6 +556,8 @@ bool Nuria::HttpClient::redirectClient (const QUrl &remoteUrl, int statusCode) {
 }
 
 bool Nuria::HttpClient::postProcessRequestHeader () {
+	markPhase (this->d_ptr, HttpRequestTimings::HeaderReceived);
+	
 	if (verifyCompleteHeader () &&
 	    readPostBodyContentLength () &&
 	    readConnectionHeader () &&
@@ -597,8 +644,89 @@ bool Nuria::HttpClient::sendPipeChunkToClient () {
 	return !this->d_ptr->pipeDevice->atEnd ();
 }
 
+bool Nuria::HttpClient::pipeIsThrottled () {
+	qint64 pending = this->d_ptr->transport->bytesToWrite (this);
+	
+	// Hysteresis: Once paused, wait until most of the data has been sent.
+	if (this->d_ptr->pipePaused) {
+		this->d_ptr->pipePaused = (pending > this->d_ptr->transport->lowWaterMark ());
+	} else {
+		this->d_ptr->pipePaused = (pending > this->d_ptr->transport->highWaterMark ());
+	}
+	
+	return this->d_ptr->pipePaused;
+}
+
+bool Nuria::HttpClient::sendPipeFileToClient (bool &failed) {
+	QFile *file = qobject_cast< QFile * > (this->d_ptr->pipeDevice);
+	
+	// Only unfiltered files with a known length
+	if (!file || file->handle () == -1 || !this->d_ptr->filters.isEmpty () ||
+	    this->d_ptr->outBuffer || this->d_ptr->headerSent ||
+	    (this->d_ptr->contentLength < 0 &&
+	     !this->d_ptr->responseHeaders.contains (httpHeaderName (HeaderContentLength)))) {
+		return false;
+	}
+	
+	// Respect maxLen
+	qint64 offset = file->pos ();
+	qint64 length = file->size () - offset;
+	if (this->d_ptr->pipeMaxlen >= 0 && this->d_ptr->pipeMaxlen < length) {
+		length = this->d_ptr->pipeMaxlen;
+	}
+	
+	// The length is known, so there's no need for chunked encoding.
+	this->d_ptr->transferMode = Streaming;
+	// If the transport refused the header, the response is broken.
+	if (!sendResponseHeader ()) {
+		failed = this->d_ptr->headerSent;
+		return false;
+	}
+	
+	// 
+	this->d_ptr->sendingFile = true;
+	if (!this->d_ptr->transport->sendFileToRemote (this, file, offset, length)) {
+		this->d_ptr->sendingFile = false;
+		return false;
+	}
+	
+	return true;
+}
+
+void Nuria::HttpClient::sendFileFinished (bool success) {
+	this->d_ptr->sendingFile = false;
+	
+	if (this->d_ptr->pipeDevice) {
+		disconnect (this->d_ptr->pipeDevice, 0, this, 0);
+		this->d_ptr->pipeDevice->close ();
+	}
+	
+	// The promised Content-Length wasn't met, don't re-use the connection.
+	if (!success) {
+		this->d_ptr->connectionMode = ConnectionClose;
+	}
+	
+	closeInternal ();
+}
+
+void Nuria::HttpClient::sendNotModified () {
+	delete this->d_ptr->outBuffer;
+	this->d_ptr->outBuffer = nullptr;
+	this->d_ptr->filters.clear ();
+	
+	// A 304 response has no body, so the connection can be kept alive.
+	this->d_ptr->transferMode = Streaming;
+	this->d_ptr->responseCode = 304;
+	this->d_ptr->responseName.clear ();
+	close ();
+}
+
 bool Nuria::HttpClient::invokeRequestedPath () {
-	if (!resolveUrl (this->d_ptr->path)) {
+	markPhase (this->d_ptr, HttpRequestTimings::RoutingStarted);
+	bool success = resolveUrl (this->d_ptr->path);
+	markPhase (this->d_ptr, HttpRequestTimings::RoutingFinished);
+	
+	if (!success) {
 	        killConnection (403);
 	        return false;
 	}
@@ -682,12 +810,35 @@ qint64 Nuria::HttpClient::writeDataInternal (QByteArray data) {
 
 bool Nuria::HttpClient::sendData (const QByteArray &data) {
 	if (this->d_ptr->transferMode == ChunkedStreaming) {
-		return sendChunkedData (data);
+		return sendChunkedData ({ data });
 	}
 	
 	return this->d_ptr->transport->sendToRemote (this, data);
 }
 
+bool Nuria::HttpClient::writeSlices (const QVector< QByteArray > &slices) {
+	
+	// Filters and the out-buffer need the data in one piece.
+	if (!this->d_ptr->headerSent || this->d_ptr->outBuffer || this->d_ptr->pipeDevice ||
+	    !this->d_ptr->filters.isEmpty () || !isWritable ()) {
+		for (const QByteArray &slice : slices) {
+			if (write (slice) != slice.length ()) {
+				return false;
+			}
+			
+		}
+		
+		return true;
+	}
+	
+	// 
+	if (this->d_ptr->transferMode == ChunkedStreaming) {
+		return sendChunkedData (slices);
+	}
+	
+	return this->d_ptr->transport->sendToRemote (this, slices);
+}
+
 bool Nuria::HttpClient::resolveUrl (const QUrl &url) {
 	return this->d_ptr->server->invokeByPath (this, url.path ());
 }
@@ -709,9 +860,10 @@ bool Nuria::HttpClient::bufferPostBody (QByteArray &data) {
 		this->d_ptr->postBodyTransferred += toRead;
 	}
 	
-	// Write the received data into the buffer
-	this->d_ptr->bufferDevice->write (data.left (toRead));
-	data = data.mid (toRead);
+	// Write the received data into the buffer. Consume it in place, so the
+	// transport can keep using the memory of its receive buffer.
+	this->d_ptr->bufferDevice->write (data.constData (), toRead);
+	data.remove (0, toRead);
 	
 	// Emit postBodyComplete() when the transfer is complete
 	if (this->d_ptr->postBodyTransferred == this->d_ptr->postBodyLength) {
@@ -723,6 +875,7 @@ bool Nuria::HttpClient::bufferPostBody (QByteArray &data) {
 			process->closeWriteChannel ();
 		}
 		
+		markPhase (this->d_ptr, HttpRequestTimings::BodyReceived);
 		emit postBodyComplete ();
 	}
 	
@@ -744,10 +897,12 @@ void Nuria::HttpClient::clientDisconnected () {
 }
 
 void Nuria::HttpClient::processData (QByteArray &data) {
+	markPhase (this->d_ptr, HttpRequestTimings::DataReceived);
 	
 	// Has the HTTP header been received from the client?
 	if (!this->d_ptr->headerReady) {
-		if (!readAllAvailableHeaderLines (data) || data.isEmpty ()) {
+		if (!readAllAvailableHeaderLines (data) || !this->d_ptr->headerReady ||
+		    data.isEmpty ()) {
 			return;
 		}
 		
@@ -790,39 +945,59 @@ void Nuria::HttpClient::processData (QByteArray &data) {
 	
 }
 
-bool Nuria::HttpClient::sendChunkedData (const QByteArray &data) {
-	QByteArray chunk = QByteArray::number (data.length (), 16);
-	chunk.append ("\r\n", 2);
-	chunk.append (data);
-	chunk.append ("\r\n", 2);
+bool Nuria::HttpClient::sendChunkedData (const QVector< QByteArray > &slices) {
+	static const QByteArray newline = QByteArrayLiteral("\r\n");
+	
+	int length = 0;
+	for (const QByteArray &slice : slices) {
+		length += slice.length ();
+	}
+	
+	QByteArray head = QByteArray::number (length, 16);
+	head.append ("\r\n", 2);
+	
+	// Frame the slices without copying them
+	QVector< QByteArray > chunk;
+	chunk.reserve (slices.length () + 2);
+	chunk.append (head);
+	chunk += slices;
+	chunk.append (newline);
 	
-	// 
 	return this->d_ptr->transport->sendToRemote (this, chunk);
 }
 
 void Nuria::HttpClient::pipeToClientReadyRead () {
+	if (this->d_ptr->sendingFile) {
+		return;
+	}
 	
-	// 
-	if (!sendPipeChunkToClient ()) {
-		
-		// Special case for QProcess: Don't kill the connection while the
-		// process is starting up.
-		QProcess *process = qobject_cast< QProcess * > (this->d_ptr->pipeDevice);
-		if (process && process->state () != QProcess::NotRunning)
-			return;
-		
-		// Disconnect aboutToClose() as it may lead to infinite recursion
-		if (this->d_ptr->pipeDevice) {
-			disconnect (this->d_ptr->pipeDevice, 0, this, 0);
-			this->d_ptr->pipeDevice->close ();
-		}
-		
-		// Send response header. This is important to do if the user
-		// piped an empty buffer.
-		sendResponseHeader ();
-		closeInternal ();
+	// The device is about to close, so send everything left in it right
+	// away. Else, bytesSent() calls us again once the transport caught up.
+	if (this->d_ptr->pipeClosing) {
+		while (sendPipeChunkToClient ()) { }
+	} else if (this->d_ptr->pipeDevice && this->d_ptr->pipeDevice->isReadable () && pipeIsThrottled ()) {
+		return;
+	} else if (sendPipeChunkToClient ()) {
+		return;
 	}
 	
+	// Special case for QProcess: Don't kill the connection while the
+	// process is starting up.
+	QProcess *process = qobject_cast< QProcess * > (this->d_ptr->pipeDevice);
+	if (process && process->state () != QProcess::NotRunning)
+		return;
+	
+	// Disconnect aboutToClose() as it may lead to infinite recursion
+	if (this->d_ptr->pipeDevice) {
+		disconnect (this->d_ptr->pipeDevice, 0, this, 0);
+		this->d_ptr->pipeDevice->close ();
+	}
+	
+	// Send response header. This is important to do if the user
+	// piped an empty buffer.
+	sendResponseHeader ();
+	closeInternal ();
+	
 }
 
 bool Nuria::HttpClient::isHeaderReady () const {
@@ -928,7 +1103,10 @@ bool Nuria::HttpClient::pipeToClient (QIODevice *device, qint64 maxlen) {
 	
 	// Connect to readyRead() and aboutToClose() signals
 	connect (device, &QIODevice::readyRead, this, &HttpClient::pipeToClientReadyRead);
-	connect (device, &QIODevice::aboutToClose, this, &HttpClient::pipeToClientReadyRead);
+	connect (device, &QIODevice::aboutToClose, this, [this]() {
+		this->d_ptr->pipeClosing = true;
+		pipeToClientReadyRead ();
+	});
 	
 	// If it is a QProcess, connect to its finished() signal
 	QProcess *process = qobject_cast< QProcess * > (device);
@@ -956,6 +1134,17 @@ bool Nuria::HttpClient::pipeToClient (QIODevice *device, qint64 maxlen) {
 		
 	}
 	
+	// Send files from the kernel if the transport supports it
+	bool failed = false;
+	if (sendPipeFileToClient (failed)) {
+		return true;
+	} else if (failed) {
+		disconnect (device, 0, this, 0);
+		this->d_ptr->pipeDevice = nullptr;
+		device->close ();
+		return false;
+	}
+	
 	// Read currently available data
 	if (!device->isSequential () || device->bytesAvailable () > 0) {
 		pipeToClientReadyRead ();
@@ -964,6 +1153,17 @@ bool Nuria::HttpClient::pipeToClient (QIODevice *device, qint64 maxlen) {
 	return true;
 }
 
+bool Nuria::HttpClient::streamToClient (HttpBodyProducer *producer) {
+	if (!producer || this->d_ptr->pipeDevice) {
+		return false;
+	}
+	
+	// The device has no data yet, so pipeToClient() doesn't read from it.
+	pipeToClient (new Internal::HttpBodyProducerDevice (producer, this));
+	pipeToClientReadyRead ();
+	return true;
+}
+
 bool Nuria::HttpClient::pipeFromPostBody (QIODevice *device, bool takeOwnership) {
 	Q_CHECK_PTR(device);
 	
@@ -1069,6 +1269,28 @@ void Nuria::HttpClient::closeInternal () {
 		this->d_ptr->transport->sendToRemote (this, chunkedEnd);
 	}
 	
+	// Tell the processing thread and the metrics how long this request took.
+	if (this->d_ptr->headerReady) {
+		Internal::HttpThread *thread = qobject_cast< Internal::HttpThread * > (this->thread ());
+		qint64 usec = this->d_ptr->timer.nsecsElapsed () / 1000;
+		
+		if (thread) {
+			thread->recordLatency (usec);
+		}
+		
+		Internal::Metrics::requestFinished (this->d_ptr->responseCode, usec);
+	}
+	
+	// Hand the phase timings to the access logger
+	if (this->d_ptr->timings) {
+		HttpRequestTimings *timings = this->d_ptr->timings;
+		markPhase (this->d_ptr, HttpRequestTimings::Closed);
+		timings->path = this->d_ptr->path.path ();
+		timings->statusCode = this->d_ptr->responseCode;
+		
+		emit this->d_ptr->server->requestTimed (*timings);
+	}
+	
 	// 
 	this->d_ptr->transport->close (this);
 }
@@ -1096,16 +1318,24 @@ QByteArray Nuria::HttpClient::filterDeinit () {
 }
 
 bool Nuria::HttpClient::filterData (QByteArray &data) {
-	for (int i = 0, total = this->d_ptr->filters.length (); i < total; ++i) {
+	if (this->d_ptr->filters.isEmpty ()) {
+		return true;
+	}
+	
+	// 
+	qint64 start = (this->d_ptr->timings) ? this->d_ptr->timer.nsecsElapsed () : 0;
+	bool success = true;
+	
+	for (int i = 0, total = this->d_ptr->filters.length (); i < total && success; ++i) {
 		HttpFilter *filter = this->d_ptr->filters.at (i);
-		if (!filter->filterData (this, data)) {
-			return false;
-		}
-		
+		success = filter->filterData (this, data);
 	}
 	
-	// Done.
-	return true;
+	if (this->d_ptr->timings) {
+		this->d_ptr->timings->filterTime += this->d_ptr->timer.nsecsElapsed () - start;
+	}
+	
+	return success;
 }
 
 bool Nuria::HttpClient::filterHeaders (HeaderMap &headers) {
@@ -1323,6 +1553,10 @@ Nuria::HttpPostBodyReader *Nuria::HttpClient::postBodyReader () {
 	return reader;
 }
 
+Nuria::HttpRequestTimings Nuria::HttpClient::requestTimings () const {
+	return (this->d_ptr->timings) ? *this->d_ptr->timings : HttpRequestTimings ();
+}
+
 Nuria::HttpClient::TransferMode Nuria::HttpClient::transferMode () const {
 	return this->d_ptr->transferMode;
 }
@@ -1477,19 +1711,54 @@ bool Nuria::HttpClient::sendResponseHeader () {
 	writer.addTransferEncodingHeader (this->d_ptr->transferMode, this->d_ptr->responseHeaders);
 	
 	// Construct header data
-	QByteArray header;
-	header.append (writer.writeResponseLine (this->d_ptr->requestVersion,
-	                                         this->d_ptr->responseCode,
-	                                         this->d_ptr->responseName.toLatin1 ()));
-	header.append (writer.writeHttpHeaders (this->d_ptr->responseHeaders));
-	header.append (writer.writeSetCookies (this->d_ptr->responseCookies));
-	header.append ("\r\n");
+	QByteArray fixedHeaders = fixedResponseHeaders ();
+	QByteArray header = writer.writeResponseHeader (this->d_ptr->requestVersion,
+	                                                this->d_ptr->responseCode,
+	                                                this->d_ptr->responseName.toLatin1 (),
+	                                                this->d_ptr->responseHeaders,
+	                                                this->d_ptr->responseCookies,
+	                                                fixedHeaders);
 	
 	// Send header
 	this->d_ptr->headerSent = true;
+	markPhase (this->d_ptr, HttpRequestTimings::HeaderSent);
 	return this->d_ptr->transport->sendToRemote (this, header);
 }
 
+QByteArray Nuria::HttpClient::fixedResponseHeaders () {
+	if (!this->d_ptr->slotInfo.isValid ()) {
+		return QByteArray ();
+	}
+	
+	// Use the pre-rendered block if no header of it has been overridden
+	const SlotInfoPrivate *info = this->d_ptr->slotInfo.d.constData ();
+	auto it = info->fixedHeaders.constBegin ();
+	auto end = info->fixedHeaders.constEnd ();
+	
+	bool overridden = false;
+	for (; it != end && !overridden; ++it) {
+		overridden = this->d_ptr->responseHeaders.contains (it.key ());
+	}
+	
+	if (!overridden) {
+		return info->fixedHeaderData;
+	}
+	
+	// Merge the remaining fixed headers into the response headers
+	for (const QByteArray &key : info->fixedHeaders.uniqueKeys ()) {
+		if (this->d_ptr->responseHeaders.contains (key)) {
+			continue;
+		}
+		
+		for (const QByteArray &value : info->fixedHeaders.values (key)) {
+			this->d_ptr->responseHeaders.insert (key, value);
+		}
+		
+	}
+	
+	return QByteArray ();
+}
+
 bool Nuria::HttpClient::killConnection (int error, const QString &cause) {
 	
 	if (!this->d_ptr->transport->isOpen () || this->d_ptr->headerSent) {
@@ -1610,6 +1879,8 @@ QByteArray Nuria::HttpClient::httpHeaderName (HttpClient::HttpHeader header) {
 	case HeaderOrigin: return QByteArrayLiteral("Origin");
 	case HeaderSecWebSocketKey: return QByteArrayLiteral("Sec-WebSocket-Key");
 	case HeaderSecWebSocketVersion: return QByteArrayLiteral("Sec-WebSocket-Version");
+	case HeaderIfNoneMatch: return QByteArrayLiteral("If-None-Match");
+	case HeaderIfModifiedSince: return QByteArrayLiteral("If-Modified-Since");
 	case HeaderContentEncoding: return QByteArrayLiteral("Content-Encoding");
 	case HeaderContentLanguage: return QByteArrayLiteral("Content-Language");
 	case HeaderContentDisposition: return QByteArrayLiteral("Content-Disposition");
@@ -1620,6 +1891,8 @@ QByteArray Nuria::HttpClient::httpHeaderName (HttpClient::HttpHeader header) {
 	case HeaderTransferEncoding: return QByteArrayLiteral("Transfer-Encoding");
 	case HeaderLocation: return QByteArrayLiteral("Location");
 	case HeaderSecWebSocketAccept: return QByteArrayLiteral("Sec-WebSocket-Accept");
+	case HeaderVary: return QByteArrayLiteral("Vary");
+	case HeaderETag: return QByteArrayLiteral("ETag");
 	};
 	
 	// We should never reach this.
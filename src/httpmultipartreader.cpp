@@ -19,10 +19,13 @@
 #include <nuria/temporarybufferdevice.hpp>
 #include "nuria/httpclient.hpp"
 #include "nuria/httpparser.hpp"
+#include "private/bytescanner.hpp"
 #include <nuria/logger.hpp>
 #include <QIODevice>
 #include <QMap>
 
+#include <algorithm>
+
 struct FieldInfo {
 	qint64 totalLength = -1;
 	qint64 transferred = 0;
@@ -44,13 +47,14 @@ public:
 	
 	QIODevice *device;
 	QByteArray boundary;
+	QByteArray delimiter; // "\r\n--<boundary>"
 	
 	QMap< QString, FieldInfo > fields;
 	HttpClient::HeaderMap currentHeaders;
 	QByteArray chunkBuffer;
 	
 	State state = FirstLine;
-	bool lastWasNewline = false; // For processContent()
+	bool fieldStart = false; // For processContent()
 	TemporaryBufferDevice *currentBuffer = nullptr;
 	qint64 currentBufferWritePos = 0;
 	QString currentField;
@@ -64,6 +68,7 @@ Nuria::HttpMultiPartReader::HttpMultiPartReader (QIODevice *device, const QByteA
 	this->d_ptr->device = device;
 	this->d_ptr->boundary = boundary;
 	this->d_ptr->boundary.prepend ("--");
+	this->d_ptr->delimiter = "\r\n" + this->d_ptr->boundary;
 	
 	// 
 	connect (device, &QIODevice::readyRead, this, &HttpMultiPartReader::processData);
@@ -213,13 +218,15 @@ int Nuria::HttpMultiPartReader::processAllHeaders () {
 
 int Nuria::HttpMultiPartReader::processHeaders (int offset) {
 	QByteArray &chunk = this->d_ptr->chunkBuffer;
-	int idx = chunk.indexOf ("\r\n", offset);
+	int idx = Internal::ByteScanner::findCrLf (chunk.constData () + offset, chunk.length () - offset);
 	
 	// No end of line in sight?
 	if (idx == -1) {
 		return 0;
 	}
 	
+	idx += offset;
+	
 	// Empty line?
 	if (idx == offset) {
 		return parseHeaders () ? 2 : -1;
@@ -325,49 +332,53 @@ QString Nuria::HttpMultiPartReader::parseContentDispositionFormDataValue (const
 }
 
 int Nuria::HttpMultiPartReader::processContent () {
-	int result = 0;
+	const QByteArray &chunk = this->d_ptr->chunkBuffer;
+	const QByteArray &delimiter = this->d_ptr->delimiter;
 	
-	// End of content?
-	int idx = this->d_ptr->chunkBuffer.indexOf ("\r\n");
-	if (this->d_ptr->lastWasNewline) {
-		
-		// Buffer more data for now if the current buffer is shorter
-		// than the bounding line length.
-		if (this->d_ptr->chunkBuffer.length () < boundingLineLength ()) {
+	// An empty field: The boundary directly follows the headers.
+	if (this->d_ptr->fieldStart) {
+		if (chunk.length () < boundingLineLength ()) {
 			return 0;
 		}
 		
-		// 
-		result = processContentBoundary (idx);
+		this->d_ptr->fieldStart = false;
+		int result = processContentBoundary (0);
 		if (result != 0) {
 			return result;
 		}
 		
-		// No boundary line, append '\r\n' to the buffer if this is not
-		// the first invocation of this method.
-		if (this->d_ptr->currentBufferWritePos > 0) {
-			appendToCurrentBuffer (QByteArrayLiteral("\r\n"), 2);
-		}
-		
 	}
 	
-	// Read until '\r\n' (Or till the end)
+	// Search for the next "\r\n<boundary>"
+	int idx = Internal::ByteScanner::findSubstring (chunk.constData (), chunk.length (),
+	                                                delimiter.constData (), delimiter.length ());
+	
+	// Not found: A partial delimiter at the end can only start with a
+	// '\r', keep everything from there on.
 	if (idx == -1) {
-		this->d_ptr->lastWasNewline = false;
-		
-		appendToCurrentBuffer (this->d_ptr->chunkBuffer, this->d_ptr->chunkBuffer.length ());
-		this->d_ptr->chunkBuffer.clear ();
+		int tail = std::max (0, chunk.length () - delimiter.length () + 1);
+		int cr = Internal::ByteScanner::findByte (chunk.constData () + tail, chunk.length () - tail, '\r');
+		int length = (cr == -1) ? chunk.length () : tail + cr;
 		
-		result = 0;
-	} else {
-		this->d_ptr->lastWasNewline = true;
-		
-		result = appendToCurrentBuffer (this->d_ptr->chunkBuffer, idx);
-		result += 2;
+		return (length > 0) ? appendToCurrentBuffer (chunk, length) : 0;
+	}
+	
+	// Need the complete bounding line to decide.
+	if (chunk.length () < idx + 2 + boundingLineLength ()) {
+		return (idx > 0) ? appendToCurrentBuffer (chunk, idx) : 0;
 	}
 	
 	// 
-	return result;
+	appendToCurrentBuffer (chunk, idx);
+	int result = processContentBoundary (idx + 2);
+	if (result > 0) {
+		return result;
+	}
+	
+	// The delimiter is followed by something else, so it's part of the
+	// content.
+	appendToCurrentBuffer (QByteArray::fromRawData (chunk.constData () + idx, 1), 1);
+	return idx + 1;
 }
 
 int Nuria::HttpMultiPartReader::isBoundingLine (const QByteArray &buffer, bool &last, int offset) {
@@ -421,12 +432,11 @@ int Nuria::HttpMultiPartReader::appendToCurrentBuffer (const QByteArray &data, i
 	return length;
 }
 
-int Nuria::HttpMultiPartReader::processContentBoundary (int idxOfNewline) {
+int Nuria::HttpMultiPartReader::processContentBoundary (int offset) {
 	bool last = false;
-	int boundaryOffset = (idxOfNewline == 0) ? 2 : 0;
-	int offset = isBoundingLine (this->d_ptr->chunkBuffer, last, boundaryOffset);
+	int result = isBoundingLine (this->d_ptr->chunkBuffer, last, offset);
 	
-	if (offset > 0) {
+	if (result > 0) {
 		FieldInfo &info = this->d_ptr->fields[this->d_ptr->currentField];
 		info.totalLength = info.transferred = this->d_ptr->currentBuffer->size ();
 		
@@ -434,14 +444,14 @@ int Nuria::HttpMultiPartReader::processContentBoundary (int idxOfNewline) {
 		setState (last ? Complete : Headers);
 	}
 	
-	return offset;
+	return result;
 }
 
 void Nuria::HttpMultiPartReader::initCurrentBuffer (const QString &name, TemporaryBufferDevice *device) {
 	this->d_ptr->currentField = name;
 	this->d_ptr->currentBuffer = device;
 	
-	this->d_ptr->lastWasNewline = true;
+	this->d_ptr->fieldStart = true;
 	this->d_ptr->currentBufferWritePos = 0;
 	
 }
@@ -15,11 +15,24 @@
  */
 
 #include "nuria/httpnode.hpp"
+#include <QCryptographicHash>
 #include <QMimeDatabase>
+#include <QThreadPool>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QRunnable>
+#include <QMutex>
+#include <QSet>
 #include <QDir>
+#include <typeinfo>
+#include <cstring>
+#include <zlib.h>
 
+#include "private/staticresourcecache.hpp"
+#include "private/standardfilters.hpp"
 #include "private/httpprivate.hpp"
 #include "nuria/httpserver.hpp"
+#include "nuria/httpwriter.hpp"
 #include <nuria/logger.hpp>
 
 // Note: HttpNodePrivate and SlotInfoPrivate are defined in private/httpprivate.hpp!
@@ -87,6 +100,15 @@ void Nuria::SlotInfo::setForceEncrypted (bool force) {
 	this->d->forceEncrypted = force;
 }
 
+Nuria::HttpClient::HeaderMap Nuria::SlotInfo::fixedResponseHeaders () const {
+	return this->d->fixedHeaders;
+}
+
+void Nuria::SlotInfo::setFixedResponseHeaders (const HttpClient::HeaderMap &headers) {
+	this->d->fixedHeaders = headers;
+	this->d->fixedHeaderData = HttpWriter ().writeHttpHeaders (headers);
+}
+
 Nuria::HttpNode::HttpNode (const QString &resourceName, HttpNode *parent)
 	: QObject (parent), d_ptr (new HttpNodePrivate)
 {
@@ -113,6 +135,7 @@ Nuria::HttpNode::HttpNode (QObject *parent)
 }
 
 Nuria::HttpNode::~HttpNode () {
+	delete this->d_ptr->resourceCache;
 	delete this->d_ptr;
 	
 }
@@ -134,6 +157,7 @@ Nuria::SlotInfo Nuria::HttpNode::connectSlot (const QString &name, const Nuria::
 	// Create binding
 	SlotInfo info (callback);
 	this->d_ptr->mySlots.insert (name, info);
+	this->d_ptr->slotIndex.insert (name.toUtf8 (), info);
 	
 	return info;
 }
@@ -155,6 +179,7 @@ Nuria::SlotInfo Nuria::HttpNode::connectSlot (const QString &name, QObject *rece
 	// Create binding
 	SlotInfo info (Callback (receiver, slot, false, Qt::DirectConnection));
 	this->d_ptr->mySlots.insert (name, info);
+	this->d_ptr->slotIndex.insert (name.toUtf8 (), info);
 	
 	return info;
 }
@@ -170,6 +195,7 @@ bool Nuria::HttpNode::disconnectSlot (const QString &name) {
 	
 	// Free internal data and erase the entry
 	this->d_ptr->mySlots.erase (it);
+	this->d_ptr->slotIndex.remove (name.toUtf8 ());
 	
 	return true;
 	
@@ -194,6 +220,7 @@ bool Nuria::HttpNode::addNode (HttpNode *node) {
 	
 	// Add as subnode
 	this->d_ptr->nodes.append (node);
+	this->d_ptr->nodeIndex.insert (res.toUtf8 (), node);
 	
 	// Reparent node
 	node->setParent (this);
@@ -230,6 +257,13 @@ bool Nuria::HttpNode::setResourceName (const QString &name) {
 		
 	}
 	
+	// Update the index of the parent
+	HttpNode *parent = this->d_ptr->parent;
+	if (parent) {
+		parent->d_ptr->nodeIndex.remove (this->d_ptr->resourceName.toUtf8 ());
+		parent->d_ptr->nodeIndex.insert (name.toUtf8 (), this);
+	}
+	
 	// 
 	this->d_ptr->resourceName = name;
 	return true;
@@ -249,32 +283,54 @@ void Nuria::HttpNode::setStaticResourceMode (Nuria::HttpNode::StaticResourcesMod
 	this->d_ptr->resourceMode = mode;
 }
 
-bool Nuria::HttpNode::hasNode (const QString &name) {
+bool Nuria::HttpNode::servePrecompressedResources () const {
+	return this->d_ptr->servePrecompressed;
+}
+
+void Nuria::HttpNode::setServePrecompressedResources (bool enable) {
+	this->d_ptr->servePrecompressed = enable;
+}
+
+QString Nuria::HttpNode::precompressedCacheDir () const {
+	return this->d_ptr->precompressedCacheDir;
+}
+
+void Nuria::HttpNode::setPrecompressedCacheDir (const QString &path) {
+	this->d_ptr->precompressedCacheDir = path;
 	
-	for (int i = 0; i < this->d_ptr->nodes.length (); i++) {
-		if (this->d_ptr->nodes.at (i)->d_ptr->resourceName == name)
-			return true;
+	if (!path.isEmpty ()) {
+		this->d_ptr->servePrecompressed = true;
+		QDir ().mkpath (path);
 	}
 	
-	return false;
 }
 
-bool Nuria::HttpNode::hasSlot (const QString &name) {
-	return this->d_ptr->mySlots.contains (name);
+qint64 Nuria::HttpNode::staticResourceCacheSize () const {
+	return (this->d_ptr->resourceCache) ? this->d_ptr->resourceCache->maxMemory () : 0;
 }
 
-Nuria::HttpNode *Nuria::HttpNode::findNode (const QString &name) const {
+void Nuria::HttpNode::setStaticResourceCacheSize (qint64 bytes) {
+	delete this->d_ptr->resourceCache;
+	this->d_ptr->resourceCache = nullptr;
 	
-	// Iterate over subnodes. Return it if the resource name matches
-	// If nothing is found, return 0.
-	for (int i = 0; i < this->d_ptr->nodes.length (); i++) {
-		if (this->d_ptr->nodes.at (i)->resourceName () == name) {
-			return this->d_ptr->nodes.at (i);
-		}
-		
+	if (bytes > 0) {
+		this->d_ptr->resourceCache = new Internal::StaticResourceCache (bytes);
 	}
 	
-	return 0;
+}
+
+bool Nuria::HttpNode::hasNode (const QString &name) {
+	return (findNode (name) != nullptr);
+}
+
+bool Nuria::HttpNode::hasSlot (const QString &name) {
+	return this->d_ptr->mySlots.contains (name);
+}
+
+Nuria::HttpNode *Nuria::HttpNode::findNode (const QString &name) const {
+	QByteArray utf8 = name.toUtf8 ();
+	HttpNode * const *node = this->d_ptr->nodeIndex.find (utf8.constData (), utf8.length ());
+	return (node) ? *node : nullptr;
 }
 
 bool Nuria::HttpNode::invokePath (const QString &path, const QStringList &parts,
@@ -319,6 +375,77 @@ bool Nuria::HttpNode::invokePath (const QString &path, const QStringList &parts,
 	
 }
 
+static const char *nextSegment (const char *cur, const char *end, const char *&segmentEnd) {
+	while (cur < end && *cur == '/') {
+		cur++;
+	}
+	
+	segmentEnd = static_cast< const char * > (::memchr (cur, '/', size_t (end - cur)));
+	if (!segmentEnd) {
+		segmentEnd = end;
+	}
+	
+	return cur;
+}
+
+bool Nuria::HttpNode::invokeUtf8Path (const QString &path, const QByteArray &utf8, HttpClient *client) {
+	const char *end = utf8.constData () + utf8.length ();
+	const char *segmentEnd = nullptr;
+	const char *cur = nextSegment (utf8.constData (), end, segmentEnd);
+	HttpNode *node = this;
+	int index = 0;
+	
+	// Nodes which re-implement invokePath() may do anything. Walk through
+	// the others the same way invokePath() would.
+	while (typeid (*node) == typeid (HttpNode)) {
+		const Internal::NameIndex< SlotInfo > &nodeSlots = node->d_ptr->slotIndex;
+		
+		// Index page?
+		if (cur == end) {
+			static const char indexSlot[] = "index";
+			const SlotInfo *info = nodeSlots.find (indexSlot, sizeof(indexSlot) - 1);
+			
+			if (info && node->invokeSlot (*info, client)) {
+				return true;
+			}
+			
+			return node->sendStaticResource (QStringList (), 0, client);
+		}
+		
+		// Sub-node?
+		int length = int (segmentEnd - cur);
+		HttpNode * const *child = node->d_ptr->nodeIndex.find (cur, length);
+		if (child) {
+			node = *child;
+			cur = nextSegment (segmentEnd, end, segmentEnd);
+			index++;
+			continue;
+		}
+		
+		// Slot, but only if this is the last segment
+		const char *segmentBegin = cur;
+		cur = nextSegment (segmentEnd, end, segmentEnd);
+		if (cur == end) {
+			const SlotInfo *info = nodeSlots.find (segmentBegin, length);
+			if (info && node->invokeSlot (*info, client)) {
+				return true;
+			}
+			
+		}
+		
+		// Static resource
+		if (node->d_ptr->resourceMode == NoStaticResources) {
+			return false;
+		}
+		
+		return node->sendStaticResource (path.split (QLatin1Char ('/'), QString::SkipEmptyParts), index, client);
+	}
+	
+	// 
+	QStringList parts = path.split (QLatin1Char ('/'), QString::SkipEmptyParts);
+	return node->invokePath (path, parts, index, client);
+}
+
 bool Nuria::HttpNode::allowAccessToClient (const QString &path, const QStringList &parts,
 					   int index, Nuria::HttpClient *client) {
 	Q_UNUSED(path)
@@ -338,8 +465,12 @@ bool Nuria::HttpNode::callSlotByName (const QString &name, HttpClient *client) {
 		return false;
 	}
 	
+	return invokeSlot (*it, client);
+}
+
+bool Nuria::HttpNode::invokeSlot (const SlotInfo &info, HttpClient *client) {
+	
 	// Host object invalid?
-	const SlotInfo &info = *it;
 	if (!info.d->callback.isValid ()) {
 		return false;
 	}
@@ -385,13 +516,223 @@ static void setMimeTypeHeaderForStaticResource (Nuria::HttpClient *client, const
 		return;
 	}
 	
-	// Set Content-Type
+	// Set Content-Type. The content of compressed files says nothing about
+	// the original file, so only the name is used for them.
 	QMimeDatabase database;
-	QMimeType mimeType = database.mimeTypeForFileNameAndData (name, device);
+	QMimeType mimeType = device
+	                     ? database.mimeTypeForFileNameAndData (name, device)
+	                     : database.mimeTypeForFile (name, QMimeDatabase::MatchExtension);
 	client->setResponseHeader (Nuria::HttpClient::HeaderContentType, mimeType.name ().toLatin1 ());
 	
 }
 
+static bool acceptsEncoding (const QByteArray &acceptEncoding, const char *coding) {
+	int wildcard = -1; // -1: Not given, 0: Not acceptable, 1: Acceptable
+	
+	// Accept-Encoding: gzip;q=1.0, br, *;q=0
+	for (const QByteArray &item : acceptEncoding.split (',')) {
+		int semicolon = item.indexOf (';');
+		QByteArray name = item.left (semicolon).trimmed ();
+		
+		bool acceptable = true;
+		if (semicolon != -1) {
+			QByteArray params = item.mid (semicolon + 1).trimmed ();
+			if (params.startsWith ("q=")) {
+				acceptable = (params.mid (2).toDouble () > 0.0);
+			}
+			
+		}
+		
+		if (qstricmp (name.constData (), coding) == 0) {
+			return acceptable;
+		} else if (name == "*") {
+			wildcard = acceptable ? 1 : 0;
+		}
+		
+	}
+	
+	return (wildcard == 1);
+}
+
+static QString precompressedCacheFile (const QString &cacheDir, const QString &path) {
+	QByteArray hash = QCryptographicHash::hash (path.toUtf8 (), QCryptographicHash::Sha1).toHex ();
+	return cacheDir + QLatin1Char ('/') + QString::fromLatin1 (hash) + QStringLiteral(".gz");
+}
+
+namespace {
+// Compresses a static resource file into the cache directory.
+class PrecompressJob : public QRunnable {
+public:
+	
+	PrecompressJob (const QString &source, const QString &target)
+		: m_source (source), m_target (target)
+	{ }
+	
+	~PrecompressJob () override {
+		QMutexLocker lock (&mutex ());
+		running ().remove (this->m_target);
+	}
+	
+	// Returns \c false if the job for \a target is already running
+	static bool acquire (const QString &target) {
+		QMutexLocker lock (&mutex ());
+		if (running ().contains (target)) {
+			return false;
+		}
+		
+		running ().insert (target);
+		return true;
+	}
+	
+	void run () override {
+		QFile input (this->m_source);
+		QSaveFile output (this->m_target);
+		
+		if (!input.open (QIODevice::ReadOnly) || !output.open (QIODevice::WriteOnly)) {
+			return;
+		}
+		
+		z_stream stream;
+		memset (&stream, 0, sizeof(z_stream));
+		if (deflateInit2 (&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 31, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+			return;
+		}
+		
+		// 
+		bool success = compress (stream, input, output);
+		deflateEnd (&stream);
+		
+		if (success) {
+			output.commit ();
+		}
+		
+	}
+	
+private:
+	
+	static bool compress (z_stream &stream, QFile &input, QSaveFile &output) {
+		enum { BlockSize = 64 * 1024 };
+		QByteArray inBuffer (BlockSize, Qt::Uninitialized);
+		QByteArray outBuffer (BlockSize, Qt::Uninitialized);
+		char *in = inBuffer.data ();
+		char *out = outBuffer.data ();
+		int flush = Z_NO_FLUSH;
+		
+		while (flush != Z_FINISH) {
+			qint64 len = input.read (in, BlockSize);
+			if (len < 0) {
+				return false;
+			}
+			
+			flush = input.atEnd () ? Z_FINISH : Z_NO_FLUSH;
+			stream.next_in = reinterpret_cast< Bytef * > (in);
+			stream.avail_in = uInt (len);
+			
+			do {
+				stream.next_out = reinterpret_cast< Bytef * > (out);
+				stream.avail_out = BlockSize;
+				
+				if (deflate (&stream, flush) == Z_STREAM_ERROR) {
+					return false;
+				}
+				
+				qint64 have = BlockSize - stream.avail_out;
+				if (output.write (out, have) != have) {
+					return false;
+				}
+				
+			} while (stream.avail_out == 0);
+			
+		}
+		
+		return true;
+	}
+	
+	static QMutex &mutex () {
+		static QMutex instance;
+		return instance;
+	}
+	
+	static QSet< QString > &running () {
+		static QSet< QString > instance;
+		return instance;
+	}
+	
+	QString m_source;
+	QString m_target;
+	
+};
+
+}
+
+static QFile *openPrecompressedResource (Nuria::HttpNodePrivate *d_ptr, const QString &path,
+                                         Nuria::HttpClient *client) {
+	struct Variant { const char *suffix; const char *coding; };
+	static const Variant variants[] = { { ".br", "br" }, { ".zst", "zstd" }, { ".gz", "gzip" } };
+	
+	QByteArray acceptEncoding = client->requestHeader (Nuria::HttpClient::HeaderAcceptEncoding);
+	QFile *handle = new QFile;
+	
+	// Pre-compressed sibling file?
+	const char *coding = nullptr;
+	for (const Variant &cur : variants) {
+		if (!acceptsEncoding (acceptEncoding, cur.coding)) {
+			continue;
+		}
+		
+		handle->setFileName (path + QLatin1String (cur.suffix));
+		if (handle->open (QIODevice::ReadOnly)) {
+			coding = cur.coding;
+			break;
+		}
+		
+	}
+	
+	// Generated one? Start the generation if there's none yet.
+	if (!coding && !d_ptr->precompressedCacheDir.isEmpty ()) {
+		QString cached = precompressedCacheFile (d_ptr->precompressedCacheDir, path);
+		QFileInfo cachedInfo (cached);
+		QFileInfo sourceInfo (path);
+		
+		if (cachedInfo.exists () && cachedInfo.lastModified () >= sourceInfo.lastModified ()) {
+			handle->setFileName (cached);
+			if (acceptsEncoding (acceptEncoding, "gzip") && handle->open (QIODevice::ReadOnly)) {
+				coding = "gzip";
+			}
+			
+		} else if (sourceInfo.isFile () && PrecompressJob::acquire (cached)) {
+			QThreadPool::globalInstance ()->start (new PrecompressJob (path, cached));
+		}
+		
+	}
+	
+	// 
+	if (!coding) {
+		delete handle;
+		return nullptr;
+	}
+	
+	client->setResponseHeader (Nuria::HttpClient::HeaderContentEncoding, QByteArray (coding));
+	return handle;
+}
+
+static bool canServePrecompressed (Nuria::HttpClient *client, const QVector< Nuria::HttpFilter * > &filters) {
+	if (client->verb () != Nuria::HttpClient::GET || client->rangeStart () >= 0) {
+		return false;
+	}
+	
+	// Other filters would change the data
+	for (Nuria::HttpFilter *filter : filters) {
+		if (filter != Nuria::Internal::DeflateFilter::instance () &&
+		    filter != Nuria::Internal::GzipFilter::instance ()) {
+			return false;
+		}
+		
+	}
+	
+	return true;
+}
+
 bool Nuria::HttpNode::sendStaticResource (const QStringList &path, int indexInPath, HttpClient *client) {
 	qint64 maxLen = -1; // For range requests
 	
@@ -430,16 +771,65 @@ bool Nuria::HttpNode::sendStaticResource (const QStringList &path, int indexInPa
 	}
 	
 	// Pipe the file if it exists
-	QFile *handle = new QFile (this->d_ptr->resourceDir.filePath (file));
+	QString filePath = this->d_ptr->resourceDir.filePath (file);
+	QFile *handle = nullptr;
+	
+	// Use a pre-compressed variant if possible
+	if (this->d_ptr->servePrecompressed && canServePrecompressed (client, client->d_ptr->filters) &&
+	    (handle = openPrecompressedResource (this->d_ptr, filePath, client))) {
+		client->removeFilter (HttpClient::DeflateFilter);
+		client->removeFilter (HttpClient::GzipFilter);
+		client->setResponseHeader (HttpClient::HeaderVary, QByteArrayLiteral("Accept-Encoding"));
+		setMimeTypeHeaderForStaticResource (client, file, nullptr);
+		client->pipeToClient (handle);
+		return true;
+	}
 	
-	// Open file
-	if (!handle->open (QIODevice::ReadOnly)) {
-		delete handle;
-		return false;
+	// Use the cached file if possible, else open it
+	QIODevice *device = nullptr;
+	Internal::StaticResourceCache::EntryPtr entry;
+	if (this->d_ptr->resourceCache) {
+		entry = this->d_ptr->resourceCache->lookup (filePath);
+	}
+	
+	if (entry) {
+		device = new Internal::CachedResourceDevice (entry);
+		device->open (QIODevice::ReadOnly);
+	} else {
+		handle = new QFile (filePath);
+		if (!handle->open (QIODevice::ReadOnly)) {
+			delete handle;
+			return false;
+		}
+		
+		device = handle;
+	}
+	
+	if (this->d_ptr->servePrecompressed) {
+		client->setResponseHeader (HttpClient::HeaderVary, QByteArrayLiteral("Accept-Encoding"));
 	}
 	
 	// Determine mime type
-	setMimeTypeHeaderForStaticResource (client, file, handle);
+	if (!entry) {
+		setMimeTypeHeaderForStaticResource (client, file, handle);
+	} else {
+		if (!client->hasResponseHeader (HttpClient::HeaderContentType)) {
+			client->setResponseHeader (HttpClient::HeaderContentType, entry->mimeType);
+		}
+		
+		client->setResponseHeader (HttpClient::HeaderETag, entry->etag);
+		client->setResponseHeader (HttpClient::HeaderLastModified, entry->lastModified);
+		
+		// Answer conditional requests without sending the file
+		if (client->verb () == HttpClient::GET &&
+		    Internal::StaticResourceCache::isNotModified (*entry, client->requestHeader (HttpClient::HeaderIfNoneMatch),
+		                                                  client->requestHeader (HttpClient::HeaderIfModifiedSince))) {
+			delete device;
+			client->sendNotModified ();
+			return true;
+		}
+		
+	}
 	
 	// Is the client only interested in a specific range?
 	if (client->rangeStart () >= 0) {
@@ -447,13 +837,14 @@ bool Nuria::HttpNode::sendStaticResource (const QStringList &path, int indexInPa
 		qint64 end = client->rangeEnd ();
 		
 		// Failed, respond with 416 - Requested Range Not Satisfiable
-		if (!handle->seek (start)) {
+		if (!device->seek (start)) {
+			delete device;
 			client->killConnection (416);
 			return false;
 		}
 		
 		if (end < 0) {
-			end = handle->bytesAvailable ();
+			end = device->bytesAvailable ();
 		}
 		
 		maxLen = end - start;
@@ -462,12 +853,12 @@ bool Nuria::HttpNode::sendStaticResource (const QStringList &path, int indexInPa
 	
 	// Check if the client used a GET request. If not, respond with a 405.
 	if (client->verb () == HttpClient::GET) {
-		client->pipeToClient (handle, maxLen);
+		client->pipeToClient (device, maxLen);
 		return true;
 	}
 	
 	// Failed.
-	delete handle;
+	delete device;
 	client->killConnection (405); // Method Not Allowed
 	
 	return false;
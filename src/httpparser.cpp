@@ -16,6 +16,20 @@
 
 #include "nuria/httpparser.hpp"
 
+#include "private/bytescanner.hpp"
+#include <QDateTime>
+#include <cstring>
+#include <cstdio>
+
+static inline int findChar (const char *data, int begin, int end, char c) {
+	int pos = Nuria::Internal::ByteScanner::findByte (data + begin, end - begin, c);
+	return (pos == -1) ? -1 : begin + pos;
+}
+
+static inline bool isWhitespace (char c) {
+	return (c == ' ' || c == '\t');
+}
+
 Nuria::HttpParser::HttpParser () {
 	
 }
@@ -76,7 +90,7 @@ bool Nuria::HttpParser::parseHeaderLine (const QByteArray &data, QByteArray &nam
 					 QByteArray &value) {
 	// Format: "<Name>: <Value>"
 	// Note: It's fine for us if there's no space after the colon.
-	int endOfName = data.indexOf (':');
+	int endOfName = findChar (data.constData (), 0, data.length (), ':');
 	int beginOfValue = endOfName + 1;
 	
 	// Sanity check
@@ -190,6 +204,39 @@ bool Nuria::HttpParser::parseRangeHeaderValue (const QByteArray &value, qint64 &
 	return (beginOk && endOk && begin >= 0 && end >= -1 && (begin < end || begin >= 0 && end == -1));
 }
 
+bool Nuria::HttpParser::parseHttpDateValue (const QByteArray &value, QDateTime &dateTime) {
+	// Format: "Sun, 06 Nov 1994 08:49:37 GMT" (RFC 7231, IMF-fixdate)
+	static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+	
+	if (value.length () != 29 || value.at (3) != ',' || !value.endsWith (" GMT")) {
+		return false;
+	}
+	
+	// 
+	char month[4] = { 0, 0, 0, 0 };
+	int day, year, hour, minute, second;
+	if (sscanf (value.constData () + 5, "%2d %3c %4d %2d:%2d:%2d",
+	            &day, month, &year, &hour, &minute, &second) != 6) {
+		return false;
+	}
+	
+	// Find month
+	const char *monthPos = strstr (months, month);
+	if (!monthPos || (monthPos - months) % 3 != 0) {
+		return false;
+	}
+	
+	// 
+	QDate date (year, int (monthPos - months) / 3 + 1, day);
+	QTime time (hour, minute, second);
+	if (!date.isValid () || !time.isValid ()) {
+		return false;
+	}
+	
+	dateTime = QDateTime (date, time, Qt::UTC);
+	return true;
+}
+
 QByteArray Nuria::HttpParser::correctHeaderKeyCase (QByteArray key) {
 	for (int i = 0; i < key.length (); i++) {
 		if (islower (key.at (i)) && (i == 0 || key.at (i - 1) == '-')) {
@@ -291,3 +338,119 @@ bool Nuria::HttpParser::parseFirstLineFull (const QByteArray &line, Nuria::HttpC
 	// Done
 	return true;
 }
+
+Nuria::HttpParser::RequestParseResult Nuria::HttpParser::parseRequestHeader (const QByteArray &buffer,
+                                                                             RequestState &state) {
+	const char *data = buffer.constData ();
+	int length = buffer.length ();
+	
+	while (state.state == RequestState::FirstLine || state.state == RequestState::Headers) {
+		int begin = state.offset;
+		int newline = findChar (data, begin, length, '\n');
+		
+		// Wait for the rest of the line, if it's not too long already.
+		if (newline == -1) {
+			if (length - begin > MaxLineLength) {
+				state.state = RequestState::Failed;
+			}
+			
+			break;
+		}
+		
+		// A line should end in \r\n, but also accept \n.
+		int end = newline;
+		if (end > begin && data[end - 1] == '\r') {
+			end--;
+		}
+		
+		state.offset = newline + 1;
+		if (end - begin > MaxLineLength) {
+			state.state = RequestState::Failed;
+		} else if (state.state == RequestState::FirstLine) {
+			if (end == begin) {
+				continue;
+			}
+			
+			state.state = (parseFirstLineRange (buffer, begin, end, state))
+			              ? RequestState::Headers : RequestState::Failed;
+			
+		} else if (end == begin) {
+			// An empty line ends the header.
+			state.state = RequestState::Complete;
+			
+		} else if (!parseHeaderLineRange (buffer, begin, end, state)) {
+			state.state = RequestState::Failed;
+		}
+		
+	}
+	
+	// 
+	switch (state.state) {
+	case RequestState::Complete: return HeaderComplete;
+	case RequestState::Failed: return InvalidRequest;
+	default: return NeedMoreData;
+	}
+	
+}
+
+bool Nuria::HttpParser::parseFirstLineRange (const QByteArray &buffer, int begin, int end,
+                                             RequestState &state) {
+	// Format: "<VERB> <Path> HTTP/<Version>"
+	static const char versionPrefix[] = "HTTP/";
+	enum { PrefixLength = sizeof(versionPrefix) - 1 };
+	
+	const char *data = buffer.constData ();
+	int endOfVerb = findChar (data, begin, end, ' ');
+	int endOfPath = (endOfVerb == -1) ? -1 : findChar (data, endOfVerb + 1, end, ' ');
+	
+	if (endOfVerb == -1 || endOfPath == -1) {
+		return false;
+	}
+	
+	// 
+	Range verb { begin, endOfVerb - begin };
+	Range version { endOfPath + 1 + PrefixLength, end - endOfPath - 1 - PrefixLength };
+	state.path = Range { endOfVerb + 1, endOfPath - endOfVerb - 1 };
+	
+	if (verb.length < 1 || state.path.length < 1 || version.length < 1 ||
+	    ::memcmp (data + endOfPath + 1, versionPrefix, PrefixLength) != 0) {
+		return false;
+	}
+	
+	// 
+	state.verb = parseVerb (verb.view (buffer));
+	state.version = parseVersion (version.view (buffer));
+	return (state.verb != HttpClient::InvalidVerb && state.version != HttpClient::HttpUnknown);
+}
+
+bool Nuria::HttpParser::parseHeaderLineRange (const QByteArray &buffer, int begin, int end,
+                                              RequestState &state) {
+	// Format: "<Name>: <Value>"
+	const char *data = buffer.constData ();
+	int endOfName = findChar (data, begin, end, ':');
+	
+	if (endOfName < begin + 1) {
+		return false;
+	}
+	
+	// Skip optional whitespace around the value
+	int beginOfValue = endOfName + 1;
+	while (beginOfValue < end && isWhitespace (data[beginOfValue])) {
+		beginOfValue++;
+	}
+	
+	while (end > beginOfValue && isWhitespace (data[end - 1])) {
+		end--;
+	}
+	
+	if (beginOfValue == end) {
+		return false;
+	}
+	
+	// 
+	HeaderField field;
+	field.name = Range { begin, endOfName - begin };
+	field.value = Range { beginOfValue, end - beginOfValue };
+	state.headers.append (field);
+	return true;
+}
@@ -18,6 +18,7 @@
 
 #include <QStringList>
 #include <QMutex>
+#include <random>
 
 #include "nuria/httptransport.hpp"
 #include "nuria/httpbackend.hpp"
@@ -42,12 +43,19 @@ public:
 	QVector< Internal::HttpThread * > threads;
 	int threadIndex = 0;
 	int activeThreads = 0;
+	HttpServer::SchedulingPolicy policy = HttpServer::RoundRobin;
+	bool reusePort = false;
+	bool phaseTiming = false;
+	bool clientPooling = false;
+	std::minstd_rand random;
 	
 	// 
 	int timeoutConnect = HttpTransport::DefaultConnectTimeout;
 	int timeoutData = HttpTransport::DefaultDataTimeout;
 	int timeoutKeepAlive = HttpTransport::DefaultKeepAliveTimeout;
 	int minBytesReceived = HttpTransport::DefaultMinimumBytesReceived;
+	qint64 highWaterMark = HttpTransport::DefaultHighWaterMark;
+	qint64 lowWaterMark = HttpTransport::DefaultLowWaterMark;
 	
 };
 }
@@ -60,6 +68,7 @@ Nuria::HttpServer::HttpServer (QObject *parent)
 	qRegisterMetaType< HttpTransport::Timeout > ();
 	qRegisterMetaType< HttpTransport * > ();
 	qRegisterMetaType< HttpClient * > ();
+	qRegisterMetaType< HttpRequestTimings > ();
 	
 	// Create root node
 	this->d_ptr->root = new HttpNode (this);
@@ -190,6 +199,22 @@ void Nuria::HttpServer::setMaxThreads (int amount) {
 	this->d_ptr->activeThreads = amount;
 }
 
+Nuria::HttpServer::SchedulingPolicy Nuria::HttpServer::schedulingPolicy () const {
+	return this->d_ptr->policy;
+}
+
+void Nuria::HttpServer::setSchedulingPolicy (SchedulingPolicy policy) {
+	this->d_ptr->policy = policy;
+}
+
+bool Nuria::HttpServer::reusePort () const {
+	return this->d_ptr->reusePort;
+}
+
+void Nuria::HttpServer::setReusePort (bool enabled) {
+	this->d_ptr->reusePort = enabled;
+}
+
 int Nuria::HttpServer::timeout (HttpTransport::Timeout which) {
 	switch (which) {
 	case HttpTransport::ConnectTimeout: return this->d_ptr->timeoutConnect;
@@ -223,13 +248,42 @@ void Nuria::HttpServer::setMinimalBytesReceived (int bytes) {
 	this->d_ptr->minBytesReceived = bytes;
 }
 
+qint64 Nuria::HttpServer::highWaterMark () const {
+	return this->d_ptr->highWaterMark;
+}
+
+void Nuria::HttpServer::setHighWaterMark (qint64 bytes) {
+	this->d_ptr->highWaterMark = bytes;
+}
+
+qint64 Nuria::HttpServer::lowWaterMark () const {
+	return this->d_ptr->lowWaterMark;
+}
+
+void Nuria::HttpServer::setLowWaterMark (qint64 bytes) {
+	this->d_ptr->lowWaterMark = bytes;
+}
+
+bool Nuria::HttpServer::phaseTimingEnabled () const {
+	return this->d_ptr->phaseTiming;
+}
+
+void Nuria::HttpServer::setPhaseTimingEnabled (bool enabled) {
+	this->d_ptr->phaseTiming = enabled;
+}
+
+bool Nuria::HttpServer::clientPoolingEnabled () const {
+	return this->d_ptr->clientPooling;
+}
+
+void Nuria::HttpServer::setClientPoolingEnabled (bool enabled) {
+	this->d_ptr->clientPooling = enabled;
+}
+
 bool Nuria::HttpServer::invokeByPath (HttpClient *client, const QString &path) {
 	
-	// Split the path.
-	QStringList parts = path.split (QLatin1Char ('/'), QString::SkipEmptyParts);
-	
-	// Try to invoke
-	if (this->d_ptr->root->invokePath (path, parts, 0, client)) {
+	// Try to invoke. Plain nodes are resolved on the UTF-8 path.
+	if (this->d_ptr->root->invokeUtf8Path (path, path.toUtf8 (), client)) {
 		return true;
 	}
 	
@@ -260,8 +314,11 @@ void Nuria::HttpServer::invokeError (HttpClient *client, int statusCode, const Q
 
 bool Nuria::HttpServer::addTcpServerBackend (Internal::TcpServer *server, const QHostAddress &interface, quint16 port) {
 	Internal::HttpTcpBackend *backend = new Internal::HttpTcpBackend (server, this);
+	bool success = (this->d_ptr->reusePort)
+	               ? backend->listenReusePort (interface, port)
+	               : backend->listen (interface, port);
 	
-	if (!backend->listen (interface, port)) {
+	if (!success) {
 		delete backend;
 		return false;
 	}
@@ -274,27 +331,94 @@ bool Nuria::HttpServer::addTcpServerBackend (Internal::TcpServer *server, const
 
 bool Nuria::HttpServer::addTransport (HttpTransport *transport) {
 	
-	if (this->d_ptr->activeThreads < 1 || this->thread () != transport->thread ()) {
-		connect (transport, SIGNAL(connectionTimedout(Nuria::AbstractTransport::Timeout)),
-		         this, SLOT(forwardTimeout(Nuria::AbstractTransport::Timeout)));
-		return false;
-	}
+	// Transports accepted by a server thread itself stay in there.
+	Internal::HttpThread *thread = qobject_cast< Internal::HttpThread * > (transport->thread ());
+	bool moved = false;
 	
-	// Move to the next thread.
-	// TODO: This is a naive approach which is bad for servers that have lots of long-running requests.
-	int index = this->d_ptr->threadIndex % this->d_ptr->activeThreads;
-	this->d_ptr->threadIndex++;
+	if (!thread) {
+		if (this->d_ptr->activeThreads < 1 || this->thread () != transport->thread ()) {
+			connect (transport, SIGNAL(connectionTimedout(Nuria::AbstractTransport::Timeout)),
+			         this, SLOT(forwardTimeout(Nuria::AbstractTransport::Timeout)));
+			return false;
+		}
+		
+		// Move to the thread chosen by the scheduling policy.
+		thread = chooseThread ();
+		transport->setParent (nullptr);
+		transport->moveToThread (thread);
+		moved = true;
+	}
 	
 	// 
-	Internal::HttpThread *thread = this->d_ptr->threads.at (index);
-	transport->setParent (nullptr);
-	transport->moveToThread (thread);
 	thread->incrementRunning (transport);
 	connect (transport, &QObject::destroyed,
 	         thread, &Internal::HttpThread::transportDestroyed);
 	
-	// Transport has been moved to another thread.
-	return true;
+	return moved;
+}
+
+Nuria::Internal::HttpThread *Nuria::HttpServer::chooseThread () {
+	const QVector< Internal::HttpThread * > &threads = this->d_ptr->threads;
+	int count = this->d_ptr->activeThreads;
+	int index = 0;
+	
+	// Latencies are only comparable if all threads finished requests lately.
+	// Else, an idle thread would keep an outdated value, and a new one would
+	// start at zero and get all connections.
+	SchedulingPolicy policy = this->d_ptr->policy;
+	if (policy == LeastRecentLatency) {
+		for (int i = 0; i < count; i++) {
+			if (!threads.at (i)->hasRecentLatency ()) {
+				policy = LeastConnections;
+				break;
+			}
+			
+		}
+		
+	}
+	
+	// 
+	switch (policy) {
+	case RoundRobin:
+		index = this->d_ptr->threadIndex % count;
+		this->d_ptr->threadIndex++;
+		break;
+	case LeastConnections:
+		for (int i = 1; i < count; i++) {
+			if (threads.at (i)->runningTransports () < threads.at (index)->runningTransports ()) {
+				index = i;
+			}
+			
+		}
+		
+		break;
+	case LeastRecentLatency:
+		for (int i = 1; i < count; i++) {
+			int latency = threads.at (i)->recentLatency ();
+			int best = threads.at (index)->recentLatency ();
+			
+			if (latency < best || (latency == best && threads.at (i)->runningTransports () <
+			                                          threads.at (index)->runningTransports ())) {
+				index = i;
+			}
+			
+		}
+		
+		break;
+	case PowerOfTwoChoices: {
+		if (count < 2) {
+			break;
+		}
+		
+		// Pick two distinct threads
+		int first = this->d_ptr->random () % count;
+		int second = (first + 1 + this->d_ptr->random () % (count - 1)) % count;
+		index = (threads.at (second)->runningTransports () < threads.at (first)->runningTransports ())
+		        ? second : first;
+	} break;
+	}
+	
+	return threads.at (index);
 }
 
 void Nuria::HttpServer::startProcessingThreads (int amount) {
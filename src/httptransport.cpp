@@ -15,11 +15,13 @@
  */
 
 #include "private/transportprivate.hpp"
+#include "private/metrics.hpp"
 #include "nuria/httptransport.hpp"
 #include "nuria/httpbackend.hpp"
 #include "nuria/httpclient.hpp"
 #include "nuria/httpserver.hpp"
 #include <nuria/callback.hpp>
+#include <QThread>
 
 namespace Nuria {
 class HttpTransportPrivate : public AbstractTransportPrivate {
@@ -27,12 +29,15 @@ public:
 	
 	HttpBackend *backend;
 	int maxRequests;
+	qint64 highWaterMark;
+	qint64 lowWaterMark;
 	
 };
 }
 
 Nuria::HttpTransport::HttpTransport (HttpBackend *backend, HttpServer *server)
-	: AbstractTransport (new HttpTransportPrivate, server)
+	: AbstractTransport (new HttpTransportPrivate,
+	                     (server->thread () == QThread::currentThread ()) ? server : nullptr)
 {
 	Q_D(HttpTransport);
 	
@@ -43,6 +48,8 @@ Nuria::HttpTransport::HttpTransport (HttpBackend *backend, HttpServer *server)
 	d->timeoutData = server->timeout (DataTimeout);
 	d->timeoutKeepAlive = server->timeout (KeepAliveTimeout);
 	d->minBytesReceived = server->minimalBytesReceived ();
+	d->highWaterMark = server->highWaterMark ();
+	d->lowWaterMark = server->lowWaterMark ();
 	
 }
 
@@ -62,6 +69,27 @@ void Nuria::HttpTransport::setMaxRequests (int count) {
 	d_func ()->maxRequests = count;
 }
 
+qint64 Nuria::HttpTransport::bytesToWrite (HttpClient *client) const {
+	Q_UNUSED(client)
+	return 0;
+}
+
+qint64 Nuria::HttpTransport::highWaterMark () const {
+	return d_func ()->highWaterMark;
+}
+
+void Nuria::HttpTransport::setHighWaterMark (qint64 bytes) {
+	d_func ()->highWaterMark = bytes;
+}
+
+qint64 Nuria::HttpTransport::lowWaterMark () const {
+	return d_func ()->lowWaterMark;
+}
+
+void Nuria::HttpTransport::setLowWaterMark (qint64 bytes) {
+	d_func ()->lowWaterMark = bytes;
+}
+
 Nuria::HttpBackend *Nuria::HttpTransport::backend () {
 	return d_func ()->backend;
 }
@@ -73,14 +101,43 @@ bool Nuria::HttpTransport::flush (HttpClient *client) {
 
 void Nuria::HttpTransport::readFromRemote (HttpClient *client, QByteArray &data) {
 	this->d_ptr->trafficReceived += data.length ();
+	Internal::Metrics::add (Internal::Metrics::BytesReceived, data.length ());
 	client->processData (data);
 }
 
 void Nuria::HttpTransport::bytesSent (HttpClient *client, qint64 bytes) {
 	this->d_ptr->trafficSent += bytes;
+	Internal::Metrics::add (Internal::Metrics::BytesSent, bytes);
 	client->bytesSent (bytes);
 }
 
+bool Nuria::HttpTransport::sendToRemote (HttpClient *client, const QVector< QByteArray > &slices) {
+	int length = 0;
+	for (const QByteArray &slice : slices) {
+		length += slice.length ();
+	}
+	
+	QByteArray data;
+	data.reserve (length);
+	for (const QByteArray &slice : slices) {
+		data.append (slice);
+	}
+	
+	return sendToRemote (client, data);
+}
+
+bool Nuria::HttpTransport::sendFileToRemote (HttpClient *client, QFile *file, qint64 offset, qint64 length) {
+	Q_UNUSED(client)
+	Q_UNUSED(file)
+	Q_UNUSED(offset)
+	Q_UNUSED(length)
+	return false;
+}
+
+void Nuria::HttpTransport::sendFileFinished (HttpClient *client, bool success) {
+	client->sendFileFinished (success);
+}
+
 bool Nuria::HttpTransport::addToServer () {
 	bool wasMoved = d_func ()->backend->httpServer ()->addTransport (this);
 	
@@ -19,6 +19,83 @@
 #include <QDateTime>
 
 #include "nuria/httpclient.hpp"
+#include <cstring>
+
+namespace {
+// Pre-rendered response lines for all status codes with the default message
+struct ResponseLineCache {
+	enum { FirstCode = 100, LastCode = 599, Count = LastCode - FirstCode + 1 };
+	
+	QByteArray http1_0[Count];
+	QByteArray http1_1[Count];
+	
+	ResponseLineCache () {
+		for (int i = 0; i < Count; i++) {
+			QByteArray code = QByteArray::number (FirstCode + i);
+			QByteArray name = Nuria::HttpClient::httpStatusCodeName (FirstCode + i);
+			
+			this->http1_0[i] = "HTTP/1.0 " + code + ' ' + name + "\r\n";
+			this->http1_1[i] = "HTTP/1.1 " + code + ' ' + name + "\r\n";
+		}
+		
+	}
+	
+	const QByteArray *find (Nuria::HttpClient::HttpVersion version, int code) const {
+		if (code < FirstCode || code > LastCode) {
+			return nullptr;
+		}
+		
+		switch (version) {
+		case Nuria::HttpClient::Http1_0: return &this->http1_0[code - FirstCode];
+		case Nuria::HttpClient::Http1_1: return &this->http1_1[code - FirstCode];
+		default: return nullptr;
+		}
+		
+	}
+	
+};
+
+}
+
+static const ResponseLineCache &responseLineCache () {
+	static const ResponseLineCache cache;
+	return cache;
+}
+
+static int httpHeadersLength (const Nuria::HttpClient::HeaderMap &headers) {
+	int length = 0;
+	
+	auto it = headers.constBegin ();
+	auto end = headers.constEnd ();
+	for (; it != end; ++it) {
+		length += it.key ().length () + it.value ().length () + 4; // ": " and "\r\n"
+	}
+	
+	return length;
+}
+
+static char *appendRaw (char *cur, const char *data, int length) {
+	memcpy (cur, data, length);
+	return cur + length;
+}
+
+static char *appendRaw (char *cur, const QByteArray &data) {
+	return appendRaw (cur, data.constData (), data.length ());
+}
+
+static char *appendHttpHeaders (char *cur, const Nuria::HttpClient::HeaderMap &headers) {
+	auto it = headers.constBegin ();
+	auto end = headers.constEnd ();
+	
+	for (; it != end; ++it) {
+		cur = appendRaw (cur, it.key ());
+		cur = appendRaw (cur, ": ", 2);
+		cur = appendRaw (cur, it.value ());
+		cur = appendRaw (cur, "\r\n", 2);
+	}
+	
+	return cur;
+}
 
 Nuria::HttpWriter::HttpWriter () {
 	
@@ -36,6 +113,15 @@ QByteArray Nuria::HttpWriter::httpVersionToString (Nuria::HttpClient::HttpVersio
 
 QByteArray Nuria::HttpWriter::writeResponseLine (HttpClient::HttpVersion version, int statusCode,
 						 const QByteArray &message) {
+	if (message.isEmpty ()) {
+		const QByteArray *cached = responseLineCache ().find (version, statusCode);
+		if (cached) {
+			return *cached;
+		}
+		
+	}
+	
+	// Custom message or uncommon status code
 	QByteArray line = httpVersionToString (version);
 	line.append (' ');
 	line.append (QByteArray::number (statusCode));
@@ -111,23 +197,42 @@ QByteArray Nuria::HttpWriter::writeSetCookieValue (const QNetworkCookie &cookie)
 }
 
 QByteArray Nuria::HttpWriter::writeHttpHeaders (const Nuria::HttpClient::HeaderMap &headers) {
-	auto it = headers.constBegin ();
-	auto end = headers.constEnd ();
+	QByteArray data (httpHeadersLength (headers), Qt::Uninitialized);
+	appendHttpHeaders (data.data (), headers);
+	return data;
+}
+
+QByteArray Nuria::HttpWriter::writeResponseHeader (HttpClient::HttpVersion version, int statusCode,
+                                                   const QByteArray &message,
+                                                   const HttpClient::HeaderMap &headers,
+                                                   const HttpClient::Cookies &cookies,
+                                                   const QByteArray &fixedHeaders) {
+	QByteArray responseLine = writeResponseLine (version, statusCode, message);
+	QByteArray cookieData;
 	
-	QByteArray data;
-	for (; it != end; ++it) {
-		data.append (it.key ());
-		data.append (": ");
-		data.append (it.value ());
-		data.append ("\r\n");
+	if (!cookies.isEmpty ()) {
+		cookieData = writeSetCookies (cookies);
 	}
 	
+	// Compute the final size and write everything in one go
+	int length = responseLine.length () + httpHeadersLength (headers) + fixedHeaders.length ()
+	             + cookieData.length () + 2;
+	
+	QByteArray data (length, Qt::Uninitialized);
+	char *cur = data.data ();
+	
+	cur = appendRaw (cur, responseLine);
+	cur = appendHttpHeaders (cur, headers);
+	cur = appendRaw (cur, fixedHeaders);
+	cur = appendRaw (cur, cookieData);
+	appendRaw (cur, "\r\n", 2);
+	
 	return data;
 }
 
 QByteArray Nuria::HttpWriter::dateTimeToHttpDateHeader (const QDateTime &dateTime) {
 	static const char *days[] = { "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun" };
-	static const char *months[] = { "Jan", "Feb", "Mar", "Apr", "Mai", "Jun",
+	static const char *months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
 				        "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };	
 	
 	QDate date = dateTime.date ();
@@ -145,6 +250,27 @@ QByteArray Nuria::HttpWriter::dateTimeToHttpDateHeader (const QDateTime &dateTim
 	return dateString;
 }
 
+QByteArray Nuria::HttpWriter::currentHttpDate () {
+	struct DateCache {
+		qint64 second = -1;
+		QByteArray value;
+	};
+	
+	// Each thread keeps its own copy, so readers never have to synchronize.
+	static thread_local DateCache cache;
+	
+	qint64 msecs = QDateTime::currentMSecsSinceEpoch ();
+	qint64 second = msecs / 1000;
+	
+	if (cache.second != second) {
+		QDateTime now = QDateTime::fromMSecsSinceEpoch (second * 1000, Qt::UTC);
+		cache.value = dateTimeToHttpDateHeader (now);
+		cache.second = second;
+	}
+	
+	return cache.value;
+}
+
 QByteArray Nuria::HttpWriter::buildRangeHeader (qint64 begin, qint64 end, qint64 totalLength) {
 	QByteArray range = "bytes " + QByteArray::number (begin) +
 			   "-" + QByteArray::number (end) + 
@@ -170,8 +296,7 @@ void Nuria::HttpWriter::addComplianceHeaders (Nuria::HttpClient::HttpVersion ver
 	QByteArray dateHeader = HttpClient::httpHeaderName (HttpClient::HeaderDate);
 	
 	if (!headers.contains (dateHeader)) {
-		QByteArray dateString = dateTimeToHttpDateHeader (QDateTime::currentDateTimeUtc ());
-		headers.insert (dateHeader, dateString);
+		headers.insert (dateHeader, currentHttpDate ());
 	}
 	
 }
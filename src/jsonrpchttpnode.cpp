@@ -0,0 +1,205 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nuria/jsonrpchttpnode.hpp"
+
+#include "private/jsonrpcbatch.hpp"
+#include "nuria/websocket.hpp"
+#include <QThreadPool>
+#include <QPointer>
+#include <QHash>
+
+namespace Nuria {
+class JsonRpcHttpNodePrivate {
+public:
+	
+	QHash< QString, Internal::JsonRpcMethod > methods;
+	QThreadPool *pool = nullptr;
+	
+};
+}
+
+Nuria::JsonRpcHttpNode::JsonRpcHttpNode (const QString &resourceName, HttpNode *parent)
+        : HttpNode (resourceName, parent), d_ptr (new JsonRpcHttpNodePrivate)
+{
+	
+}
+
+Nuria::JsonRpcHttpNode::~JsonRpcHttpNode () {
+	delete this->d_ptr;
+}
+
+bool Nuria::JsonRpcHttpNode::connectMethod (const QString &name, const QStringList &argumentNames,
+                                            const Callback &callback) {
+	QList< int > types = callback.argumentTypes ();
+	if (!callback.isValid () || types.length () != argumentNames.length ()) {
+		return false;
+	}
+	
+	// 
+	Internal::JsonRpcMethod method;
+	method.callback = callback;
+	method.names = argumentNames;
+	method.types = types;
+	
+	this->d_ptr->methods.insert (name, method);
+	return true;
+}
+
+bool Nuria::JsonRpcHttpNode::connectMethod (const QString &name, const Callback &callback) {
+	QList< int > types = callback.argumentTypes ();
+	if (types.isEmpty ()) {
+		return connectMethod (name, QStringList (), callback);
+	}
+	
+	// Pass "params" as a whole
+	if (!callback.isValid () || types.length () != 1 || types.first () != QMetaType::QVariantMap) {
+		return false;
+	}
+	
+	Internal::JsonRpcMethod method;
+	method.callback = callback;
+	method.passParams = true;
+	
+	this->d_ptr->methods.insert (name, method);
+	return true;
+}
+
+bool Nuria::JsonRpcHttpNode::disconnectMethod (const QString &name) {
+	return (this->d_ptr->methods.remove (name) > 0);
+}
+
+bool Nuria::JsonRpcHttpNode::hasMethod (const QString &name) const {
+	return this->d_ptr->methods.contains (name);
+}
+
+QThreadPool *Nuria::JsonRpcHttpNode::threadPool () const {
+	return this->d_ptr->pool;
+}
+
+void Nuria::JsonRpcHttpNode::setThreadPool (QThreadPool *pool) {
+	this->d_ptr->pool = pool;
+}
+
+bool Nuria::JsonRpcHttpNode::invokePath (const QString &path, const QStringList &parts,
+                                         int index, HttpClient *client) {
+	
+	// Sub-nodes and slots
+	if (index < parts.length ()) {
+		return HttpNode::invokePath (path, parts, index, client);
+	}
+	
+	// 
+	if (!allowAccessToClient (path, parts, index, client)) {
+		client->killConnection (403);
+		return false;
+	}
+	
+	if (client->isWebSocketHandshake ()) {
+		return acceptWebSocket (client);
+	}
+	
+	if (client->verb () != HttpClient::POST) {
+		client->killConnection (405);
+		return false;
+	}
+	
+	// Wait for the request body if it's not there yet.
+	if (client->postBodyLength () > client->postBodyTransferred ()) {
+		client->setSlotInfo (SlotInfo (Callback (this, &JsonRpcHttpNode::processHttpRequest)));
+		return true;
+	}
+	
+	processHttpRequest (client);
+	return true;
+}
+
+bool Nuria::JsonRpcHttpNode::acceptWebSocket (HttpClient *client) {
+	WebSocket *socket = client->acceptWebSocketConnection ();
+	if (!socket) {
+		return false;
+	}
+	
+	// Each frame carries a single request or a batch. The socket may live
+	// in another thread than the node, so it's used as context, and the
+	// node is guarded instead.
+	QPointer< JsonRpcHttpNode > node (this);
+	auto handler = [node, socket](WebSocket::FrameType, const QByteArray &data) {
+		if (node) {
+			node->processPayload (data, nullptr, socket);
+		}
+		
+	};
+	
+	connect (socket, &WebSocket::frameReceived, socket, handler);
+	
+	return true;
+}
+
+void Nuria::JsonRpcHttpNode::processHttpRequest (HttpClient *client) {
+	
+	// The response may be written after this method returned. The client
+	// is closed by the batch when done.
+	client->setKeepConnectionOpen (true);
+	processPayload (client->readAll (), client, nullptr);
+}
+
+void Nuria::JsonRpcHttpNode::processPayload (const QByteArray &data, HttpClient *client, WebSocket *socket) {
+	QJsonParseError error;
+	QJsonDocument document = QJsonDocument::fromJson (data, &error);
+	QJsonArray array = document.array ();
+	
+	// An empty array is answered with a single error.
+	bool isBatch = !array.isEmpty ();
+	Internal::JsonRpcBatch *batch = (client)
+	                                ? new Internal::JsonRpcBatch (client, isBatch)
+	                                : new Internal::JsonRpcBatch (socket, isBatch);
+	
+	if (error.error != QJsonParseError::NoError || document.isNull ()) {
+		batch->addResponse (Internal::JsonRpcUtil::getErrorResponse (QJsonValue (), Internal::ParseError));
+	} else if (document.isObject ()) {
+		Internal::JsonRpcRequest request = Internal::JsonRpcUtil::dissectRequestObject (document.object ());
+		batch->invokeNow (this->d_ptr->methods.value (request.method), request);
+	} else if (!isBatch) {
+		batch->addResponse (Internal::JsonRpcUtil::getErrorResponse (QJsonValue (), Internal::InvalidRequest));
+	} else {
+		QThreadPool *pool = this->d_ptr->pool;
+		
+		for (const QJsonValue &value : array) {
+			if (!value.isObject ()) {
+				batch->addResponse (Internal::JsonRpcUtil::getErrorResponse (QJsonValue (),
+				                                                             Internal::InvalidRequest));
+				continue;
+			}
+			
+			// Entries are only dispatched concurrently if a pool was set
+			Internal::JsonRpcRequest request = Internal::JsonRpcUtil::dissectRequestObject (value.toObject ());
+			Internal::JsonRpcMethod method = this->d_ptr->methods.value (request.method);
+			
+			if (pool) {
+				batch->invokeLater (pool, method, request);
+			} else {
+				batch->invokeNow (method, request);
+			}
+			
+		}
+		
+	}
+	
+	// 
+	batch->finish ();
+}
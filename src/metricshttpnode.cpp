@@ -0,0 +1,168 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nuria/metricshttpnode.hpp"
+
+#include "private/metrics.hpp"
+
+using namespace Nuria::Internal;
+
+struct LatencyBucket {
+	quint64 usec;
+	const char *label;
+};
+
+// Upper bounds of the exported latency histogram buckets
+static const LatencyBucket latencyBuckets[] = {
+	{ 100, "0.0001" }, { 250, "0.00025" }, { 500, "0.0005" },
+	{ 1000, "0.001" }, { 2500, "0.0025" }, { 5000, "0.005" },
+	{ 10000, "0.01" }, { 25000, "0.025" }, { 50000, "0.05" },
+	{ 100000, "0.1" }, { 250000, "0.25" }, { 500000, "0.5" },
+	{ 1000000, "1" }, { 2500000, "2.5" }, { 5000000, "5" },
+	{ 10000000, "10" }
+};
+
+static void writeHeader (QByteArray &out, const char *name, const char *type, const char *help) {
+	out.append ("# HELP ").append (name).append (' ').append (help).append ('\n');
+	out.append ("# TYPE ").append (name).append (' ').append (type).append ('\n');
+}
+
+static void writeValue (QByteArray &out, const QByteArray &name, const QByteArray &labels, const QByteArray &value) {
+	out.append (name);
+	
+	if (!labels.isEmpty ()) {
+		out.append ('{').append (labels).append ('}');
+	}
+	
+	out.append (' ').append (value).append ('\n');
+}
+
+static void writeValue (QByteArray &out, const QByteArray &name, const QByteArray &labels, quint64 value) {
+	writeValue (out, name, labels, QByteArray::number (value));
+}
+
+static void writeCounter (QByteArray &out, const char *name, const char *help, quint64 value) {
+	writeHeader (out, name, "counter", help);
+	writeValue (out, name, QByteArray (), value);
+}
+
+static void writeLatency (QByteArray &out, const MetricsSnapshot &snapshot) {
+	static const char name[] = "nuria_http_request_duration_seconds";
+	writeHeader (out, name, "histogram", "Duration of HTTP requests.");
+	
+	// Buckets are cumulative. Recorded values are assigned to an exported
+	// bucket if the whole recording bucket fits into it.
+	QByteArray bucketName = QByteArray (name) + "_bucket";
+	quint64 count = 0;
+	int index = 0;
+	
+	for (const LatencyBucket &bucket : latencyBuckets) {
+		for (; index < snapshot.latency.length () &&
+		     MetricsHistogram::upperBound (index) <= bucket.usec; index++) {
+			count += snapshot.latency.at (index);
+		}
+		
+		writeValue (out, bucketName, QByteArray ("le=\"") + bucket.label + '"', count);
+	}
+	
+	writeValue (out, bucketName, "le=\"+Inf\"", snapshot.latencyCount);
+	writeValue (out, QByteArray (name) + "_sum", QByteArray (),
+	            QByteArray::number (snapshot.latencySum / 1000000.0, 'f', 6));
+	writeValue (out, QByteArray (name) + "_count", QByteArray (), snapshot.latencyCount);
+}
+
+Nuria::MetricsHttpNode::MetricsHttpNode (const QString &resourceName, HttpNode *parent)
+        : HttpNode (resourceName, parent)
+{
+	
+}
+
+Nuria::MetricsHttpNode::~MetricsHttpNode () {
+	// 
+}
+
+QByteArray Nuria::MetricsHttpNode::exposition () {
+	MetricsSnapshot snapshot = Metrics::snapshot ();
+	const QVector< quint64 > &counters = snapshot.counters;
+	QByteArray out;
+	
+	// Requests
+	writeCounter (out, "nuria_http_requests_total", "Finished HTTP requests.",
+	              counters.at (Metrics::RequestsTotal));
+	
+	writeHeader (out, "nuria_http_responses_total", "counter", "Finished HTTP requests by status code.");
+	for (int i = 0; i < snapshot.statusCodes.length (); i++) {
+		if (snapshot.statusCodes.at (i) > 0) {
+			QByteArray code = QByteArray::number (i + Metrics::FirstStatusCode);
+			writeValue (out, "nuria_http_responses_total", "code=\"" + code + '"', snapshot.statusCodes.at (i));
+		}
+		
+	}
+	
+	writeLatency (out, snapshot);
+	
+	// Traffic
+	writeCounter (out, "nuria_http_received_bytes_total", "Bytes received from HTTP clients.",
+	              counters.at (Metrics::BytesReceived));
+	writeCounter (out, "nuria_http_sent_bytes_total", "Bytes sent to HTTP clients.",
+	              counters.at (Metrics::BytesSent));
+	
+	// Transports
+	writeHeader (out, "nuria_transports_open", "gauge", "Currently existing transports.");
+	writeValue (out, "nuria_transports_open", QByteArray (),
+	            QByteArray::number (qint64 (counters.at (Metrics::OpenTransports))));
+	
+	writeHeader (out, "nuria_transport_timeouts_total", "counter", "Connections closed due to a timeout.");
+	writeValue (out, "nuria_transport_timeouts_total", "kind=\"connect\"", counters.at (Metrics::ConnectTimeouts));
+	writeValue (out, "nuria_transport_timeouts_total", "kind=\"data\"", counters.at (Metrics::DataTimeouts));
+	writeValue (out, "nuria_transport_timeouts_total", "kind=\"keepalive\"", counters.at (Metrics::KeepAliveTimeouts));
+	
+	// Protocols
+	writeHeader (out, "nuria_websocket_frames_total", "counter", "WebSocket frames.");
+	writeValue (out, "nuria_websocket_frames_total", "direction=\"received\"",
+	            counters.at (Metrics::WebSocketFramesReceived));
+	writeValue (out, "nuria_websocket_frames_total", "direction=\"sent\"",
+	            counters.at (Metrics::WebSocketFramesSent));
+	
+	writeHeader (out, "nuria_fastcgi_records_total", "counter", "FastCGI records.");
+	writeValue (out, "nuria_fastcgi_records_total", "direction=\"received\"",
+	            counters.at (Metrics::FastCgiRecordsReceived));
+	writeValue (out, "nuria_fastcgi_records_total", "direction=\"sent\"",
+	            counters.at (Metrics::FastCgiRecordsSent));
+	
+	return out;
+}
+
+bool Nuria::MetricsHttpNode::invokePath (const QString &path, const QStringList &parts,
+                                         int index, HttpClient *client) {
+	static const QByteArray contentType = QByteArrayLiteral("text/plain; version=0.0.4");
+	
+	// Sub-nodes and slots
+	if (index < parts.length ()) {
+		return HttpNode::invokePath (path, parts, index, client);
+	}
+	
+	// 
+	if (!allowAccessToClient (path, parts, index, client)) {
+		client->killConnection (403);
+		return false;
+	}
+	
+	client->setResponseHeader (HttpClient::HeaderContentType, contentType);
+	client->write (exposition ());
+	return true;
+}
@@ -247,6 +247,12 @@ protected:
 	 */
 	void addBytesSent (uint64_t bytes);
 	
+	/**
+	 * Handles moving the timeout to another thread. Sub-classes overriding
+	 * this have to call the base implementation.
+	 */
+	bool event (QEvent *event) override;
+	
 	/**
 	 * Starts the timer with timeout for \a mode.
 	 */
@@ -261,6 +267,7 @@ protected:
 	// For NuriaFramework sub-classes
 	AbstractTransportPrivate *d_ptr;
 private:
+	friend class AbstractTransportPrivate;
 	void triggerTimeout ();
 	
 };
@@ -0,0 +1,78 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NURIA_HTTPBODYPRODUCER_HPP
+#define NURIA_HTTPBODYPRODUCER_HPP
+
+#include "network_global.hpp"
+#include <QObject>
+
+namespace Nuria {
+
+class HttpClient;
+
+/**
+ * \brief Generates the body of a response on demand
+ * 
+ * Instead of pushing data into a HttpClient using write(), or handing it a
+ * QIODevice, a producer is asked for more data whenever the transport is
+ * ready to send it. This is useful for lazily generated bodies, like the rows
+ * of a database cursor or a large export, as only the data which can be sent
+ * right now is held in memory.
+ * 
+ * To use it, sub-class HttpBodyProducer and pass an instance to
+ * HttpClient::streamToClient(). The transfer mode, filters and backpressure
+ * are handled the same way as for HttpClient::pipeToClient().
+ * 
+ * If the producer has no data right now, produce() returns an empty
+ * QByteArray. It then emits dataAvailable() once it has, or once atEnd()
+ * changed to \c true.
+ */
+class NURIA_NETWORK_EXPORT HttpBodyProducer : public QObject {
+	Q_OBJECT
+public:
+	
+	/** Constructor. */
+	explicit HttpBodyProducer (QObject *parent = 0);
+	
+	/** Destructor. */
+	~HttpBodyProducer () override;
+	
+	/**
+	 * Returns \c true if all data has been produced. The response is
+	 * finished afterwards.
+	 */
+	virtual bool atEnd () const = 0;
+	
+	/**
+	 * Called by \a client when the transport can take more data. Returns
+	 * up to \a maxlen bytes of the body. Additional bytes are discarded.
+	 */
+	virtual QByteArray produce (HttpClient *client, qint64 maxlen) = 0;
+	
+signals:
+	
+	/**
+	 * Emit this after produce() returned no data to tell the client that
+	 * it should try again.
+	 */
+	void dataAvailable ();
+	
+};
+
+}
+
+#endif // NURIA_HTTPBODYPRODUCER_HPP
@@ -17,12 +17,14 @@
 #ifndef NURIA_HTTPCLIENT_HPP
 #define NURIA_HTTPCLIENT_HPP
 
+#include "httprequesttimings.hpp"
 #include "httppostbodyreader.hpp"
 #include "network_global.hpp"
 #include <QNetworkCookie>
 #include <QHostAddress>
 #include <QIODevice>
 #include <QMetaType>
+#include <QVector>
 #include <QMap>
 #include <QUrl>
 
@@ -30,12 +32,19 @@ namespace Nuria {
 
 class HttpClientPrivate;
 class HttpTransport;
+class HttpBodyProducer;
 class HttpFilter;
 class HttpServer;
 class WebSocket;
 class HttpNode;
 class SlotInfo;
 
+namespace Internal {
+class CompressionFilter;
+class WebSocketWriter;
+class HttpClientPool;
+}
+
 /**
  * \brief The HttpClient class represents a connection to a client.
  * 
@@ -82,7 +91,8 @@ class SlotInfo;
  * \warning As of now HttpClient is self-contained. This means that it will use
  * deleteLater() on itself when the connection is closed by any side. Do not do
  * this on your own. Never \c delete or deleteLater a HttpClient instance! Use
- * close instead!
+ * close instead! If HttpServer::clientPoolingEnabled() is \c true, a closed
+ * instance may be re-used for a later request instead.
  * 
  * \par Range request and responses
  * If you want to support requests with 'Range' headers use rangeStart() and
@@ -191,6 +201,8 @@ public:
 		HeaderOrigin,
 		HeaderSecWebSocketKey,
 		HeaderSecWebSocketVersion,
+		HeaderIfNoneMatch,
+		HeaderIfModifiedSince,
 		
 		/* Response only */
 		HeaderContentEncoding = 2000,
@@ -203,6 +215,8 @@ public:
 		HeaderTransferEncoding,
 		HeaderLocation,
 		HeaderSecWebSocketAccept,
+		HeaderVary,
+		HeaderETag,
 		
 	};
 	
@@ -407,10 +421,23 @@ public:
 	 * of \a device will be transferred to this instance and thus will
 	 * be destroyed when the client quits or \a device has no more data
 	 * to read.
+	 * 
+	 * Reading from \a device is paused while more than
+	 * HttpTransport::highWaterMark() bytes are waiting to be sent, and
+	 * continues once it's down to HttpTransport::lowWaterMark().
+	 * 
 	 * \note \a device must be readable and open.
 	 */
 	bool pipeToClient (QIODevice *device, qint64 maxlen = -1);
 	
+	/**
+	 * Sends the response body generated by \a producer. The producer is
+	 * asked for more data whenever the transport is ready to send it, see
+	 * HttpBodyProducer. Otherwise, this behaves like pipeToClient(), and
+	 * ownership of \a producer is transferred to this instance.
+	 */
+	bool streamToClient (HttpBodyProducer *producer);
+	
 	/**
 	 * Uses \a device from now on as buffer device. You can use this for
 	 * example when you write an application which takes the POST body data,
@@ -628,6 +655,13 @@ public:
 	 */
 	HttpPostBodyReader *postBodyReader ();
 	
+	/**
+	 * Returns the phase timestamps of this request collected so far. All
+	 * phases are unreached if phase timing is disabled.
+	 * \sa HttpServer::setPhaseTimingEnabled
+	 */
+	HttpRequestTimings requestTimings () const;
+	
 	/** Returns the used transfer mode. */
 	TransferMode transferMode () const;
 	
@@ -825,6 +859,9 @@ private:
 	friend class HttpTransport;
 	friend class HttpServer;
 	friend class HttpNode;
+	friend class Internal::CompressionFilter;
+	friend class Internal::WebSocketWriter;
+	friend class Internal::HttpClientPool;
 	
 	/**
 	 * Parses the request headers. Returns \c true on success.
@@ -847,13 +884,12 @@ private:
 	void bytesSent (qint64 bytes);
 	void processData (QByteArray &data);
 	
-	bool sendChunkedData (const QByteArray &data);
+	bool sendChunkedData (const QVector< QByteArray > &slices);
 	qint64 parseIntegerHeaderValue (const QByteArray &value);
 	bool readPostBodyContentLength ();
 	bool send100ContinueIfClientExpectsIt ();
 	bool readAllAvailableHeaderLines (QByteArray &data);
-	bool readFirstLine (const QByteArray &line);
-	bool readHeader (const QByteArray &line);
+	void readParsedHeader (const QByteArray &data);
 	bool isReceivedHeaderHttp11Compliant ();
 	bool verifyPostRequestCompliance ();
 	bool verifyCompleteHeader ();
@@ -867,11 +903,31 @@ private:
 	HttpPostBodyReader *createUrlEncodedPartReader (const QByteArray &header);
 	qint64 writeDataInternal (QByteArray data);
 	bool sendData (const QByteArray &data);
+	
+	/**
+	 * Writes \a slices like write() would do, but passes them to the
+	 * transport without joining them if nothing has to be filtered.
+	 */
+	bool writeSlices (const QVector< QByteArray > &slices);
+	
+	/**
+	 * Returns \c true if this instance can be put into the client pool
+	 * after it has been closed.
+	 */
+	bool isReusable () const;
+	
+	/**
+	 * Resets this instance for a new request received by \a transport.
+	 * Objects owned by the previous request are destroyed.
+	 */
+	void reuse (HttpTransport *transport, HttpServer *server);
+	void initialize (HttpTransport *transport, HttpServer *server, QIODevice *buffer);
 	void closeInternal ();
 	QByteArray filterInit ();
 	QByteArray filterDeinit ();
 	bool filterData (QByteArray &data);
 	bool filterHeaders (HeaderMap &headers);
+	QByteArray fixedResponseHeaders ();
 	void addFilterNameToHeader (HeaderMap &headers, const QByteArray &name);
 	void initPath (QByteArray path);
 	
@@ -881,6 +937,23 @@ private:
 	 */
 	bool sendPipeChunkToClient ();
 	
+	/**
+	 * Returns \c true if reading from the pipeToClient() device has to
+	 * wait for the transport to send buffered data.
+	 */
+	bool pipeIsThrottled ();
+	
+	/**
+	 * Lets the transport send the rest of the pipeToClient() device if it
+	 * is a plain file. Returns \c true if the transport took over. Sets
+	 * \a failed if the response header couldn't be sent.
+	 */
+	bool sendPipeFileToClient (bool &failed);
+	void sendFileFinished (bool success);
+	
+	/** Responds with "304 Not Modified" and no body. */
+	void sendNotModified ();
+	
 	// 
 	HttpClientPrivate *d_ptr;
 	
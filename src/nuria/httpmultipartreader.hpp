@@ -81,7 +81,7 @@ private:
 	int boundingLineLength () const;
 	void stopListening ();
 	int appendToCurrentBuffer (const QByteArray &data, int length);
-	int processContentBoundary (int idxOfNewline);
+	int processContentBoundary (int offset);
 	void initCurrentBuffer (const QString &name, TemporaryBufferDevice *device);
 	
 	HttpMultiPartReaderPrivate *d_ptr;
@@ -99,8 +99,28 @@ public:
 	/** \sa forceEncrypted */
 	void setForceEncrypted (bool force);
 	
+	/**
+	 * Returns the headers which are sent in every response of this slot.
+	 * \sa setFixedResponseHeaders
+	 */
+	HttpClient::HeaderMap fixedResponseHeaders () const;
+	
+	/**
+	 * Sets \a headers which are sent along every response of this slot,
+	 * like a \c Cache-Control or a \c Content-Security-Policy header.
+	 * The headers are rendered once here and later copied as a whole into
+	 * the response header.
+	 * 
+	 * If the response already has a header of the same name, the one of
+	 * the response takes precedence.
+	 * 
+	 * \note These headers are not passed through HttpFilter::filterHeaders.
+	 */
+	void setFixedResponseHeaders (const HttpClient::HeaderMap &headers);
+	
 private:
 	friend class HttpNode;
+	friend class HttpClient;
 	
 	// 
 	QSharedDataPointer< SlotInfoPrivate > d;
@@ -321,6 +341,66 @@ public:
 	 */
 	void setStaticResourceMode (StaticResourcesMode mode);
 	
+	/**
+	 * Returns \c true if static resources are served from pre-compressed
+	 * files. The default is \c false.
+	 * \sa setServePrecompressedResources
+	 */
+	bool servePrecompressedResources () const;
+	
+	/**
+	 * If \a enable is \c true, a static resource is served from a
+	 * pre-compressed sibling file if the client accepts its encoding. For
+	 * a requested file "app.js", the files "app.js.br", "app.js.zst" and
+	 * "app.js.gz" are tried in this order.
+	 * 
+	 * The HttpClient::DeflateFilter and HttpClient::GzipFilter are
+	 * removed from the client in this case. Range requests and clients
+	 * with other filters are always served from the original file.
+	 */
+	void setServePrecompressedResources (bool enable);
+	
+	/**
+	 * Returns the directory generated gzip files of static resources are
+	 * stored in.
+	 * \sa setPrecompressedCacheDir
+	 */
+	QString precompressedCacheDir () const;
+	
+	/**
+	 * Sets the directory generated gzip files of static resources are
+	 * stored in. If set, the first request of a static resource without a
+	 * pre-compressed sibling starts a background job which compresses the
+	 * file into \a path. Later requests are served from there as long as
+	 * the generated file is newer than the original one.
+	 * 
+	 * Setting a path implies setServePrecompressedResources(). The default
+	 * is an empty path, which disables the generation.
+	 */
+	void setPrecompressedCacheDir (const QString &path);
+	
+	/**
+	 * Returns the maximum size in bytes of static resources kept in memory.
+	 * \sa setStaticResourceCacheSize
+	 */
+	qint64 staticResourceCacheSize () const;
+	
+	/**
+	 * Enables the in-memory cache of static resources. Small files are kept
+	 * in memory up to a total of \a bytes, files of 256KiB and larger are
+	 * always streamed from disk. Least recently used files are dropped
+	 * first.
+	 * 
+	 * Cached resources are sent with a "ETag" and "Last-Modified" header.
+	 * Requests with a matching "If-None-Match" or "If-Modified-Since"
+	 * header are answered with "304 Not Modified" without accessing the
+	 * file. Changes to cached files are noticed through inotify on Linux
+	 * and by checking the modification time once per second elsewhere.
+	 * 
+	 * The default is \c 0, which disables the cache.
+	 */
+	void setStaticResourceCacheSize (qint64 bytes);
+	
 	/**
 	 * Returns \c true if this node has a subnode called \a name.
 	 */
@@ -438,6 +518,17 @@ private:
 	 */
 	static bool callSlot (const SlotInfo &info, HttpClient *client);
 	
+	/** Used by callSlotByName() to invoke a found slot. */
+	bool invokeSlot (const SlotInfo &info, HttpClient *client);
+	
+	/**
+	 * Used by HttpServer::invokeByPath. Resolves the UTF-8 encoded \a utf8
+	 * through nodes which don't re-implement invokePath() by looking up
+	 * the path segments directly. The node which can't be handled like
+	 * this is invoked through invokePath().
+	 */
+	bool invokeUtf8Path (const QString &path, const QByteArray &utf8, HttpClient *client);
+	
 	// 
 	HttpNodePrivate *d_ptr;
 	
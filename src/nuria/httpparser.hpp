@@ -19,16 +19,93 @@
 
 #include "httpclient.hpp"
 #include <QByteArray>
+#include <QVector>
 
+class QDateTime;
 class QIODevice;
 
 namespace Nuria {
 
 /**
  * \brief Parser functions for the HyperText Transfer Protocol.
+ * 
+ * \par Incremental parsing
+ * Request headers can be parsed incrementally using parseRequestHeader().
+ * The parser works on the receive buffer itself and stores its progress in a
+ * RequestState. All results are stored as offsets into the buffer, so no data
+ * is copied while parsing. Data may be appended to the buffer between calls,
+ * which makes it possible to feed headers which are split across multiple
+ * reads.
  */
 class NURIA_NETWORK_EXPORT HttpParser {
 public:
+	
+	enum {
+		
+		/** Maximum length of a single header line in bytes. */
+		MaxLineLength = 4096
+	};
+	
+	/** Results of parseRequestHeader(). */
+	enum RequestParseResult {
+		
+		/** The header is incomplete. Call again with more data. */
+		NeedMoreData = 0,
+		
+		/** The header has been completely parsed. */
+		HeaderComplete,
+		
+		/** The data is not a valid HTTP request header. */
+		InvalidRequest
+	};
+	
+	/** A part of the buffer, denoted by its offset and length. */
+	struct Range {
+		int begin;
+		int length;
+		
+		/**
+		 * Returns a view of this range in \a buffer without copying
+		 * it. The result is only valid while \a buffer is not modified.
+		 */
+		QByteArray view (const QByteArray &buffer) const
+		{ return QByteArray::fromRawData (buffer.constData () + begin, length); }
+		
+		/** Returns a deep copy of this range in \a buffer. */
+		QByteArray toByteArray (const QByteArray &buffer) const
+		{ return QByteArray (buffer.constData () + begin, length); }
+		
+	};
+	
+	/** Location of a header field in the buffer. */
+	struct HeaderField {
+		Range name;
+		Range value;
+	};
+	
+	/**
+	 * Progress of parseRequestHeader(). Default-construct this to start
+	 * parsing a new request.
+	 */
+	struct RequestState {
+		enum State { FirstLine, Headers, Complete, Failed };
+		
+		/** Current state of the parser. */
+		State state = FirstLine;
+		
+		/**
+		 * Offset of the first byte that has not been consumed yet. Once
+		 * the header is complete, this points to the start of the body.
+		 */
+		int offset = 0;
+		
+		HttpClient::HttpVerb verb = HttpClient::InvalidVerb;
+		HttpClient::HttpVersion version = HttpClient::HttpUnknown;
+		Range path = { 0, 0 };
+		QVector< HeaderField > headers;
+		
+	};
+	
 	/** Constructor. */
 	HttpParser ();
 	
@@ -80,6 +157,14 @@ public:
 	 */
 	bool parseRangeHeaderValue (const QByteArray &value, qint64 &begin, qint64 &end);
 	
+	/**
+	 * Parses \a value which contains a HTTP date like
+	 * "Sun, 06 Nov 1994 08:49:37 GMT" as used by the "If-Modified-Since"
+	 * HTTP header. On success, \a dateTime is set to the value in UTC and
+	 * \c true is returned.
+	 */
+	bool parseHttpDateValue (const QByteArray &value, QDateTime &dateTime);
+	
 	/**
 	 * Takes a key name of a http header and 'corrects' the case,
 	 * so 'content-length' becomes 'Content-Length'.
@@ -99,6 +184,22 @@ public:
 	 */ 
 	bool parseFirstLineFull (const QByteArray &line, HttpClient::HttpVerb &verb,
 				 QByteArray &path, HttpClient::HttpVersion &version);
+	
+	/**
+	 * Parses the request header in \a buffer, starting at the offset in
+	 * \a state. Complete lines are consumed and the result is stored in
+	 * \a state. Empty lines in front of the request line are ignored.
+	 * 
+	 * If \c NeedMoreData is returned, call this method again with the same
+	 * \a state after appending more data to \a buffer. Data in front of
+	 * \c state.offset must not be changed in the meantime.
+	 */
+	RequestParseResult parseRequestHeader (const QByteArray &buffer, RequestState &state);
+	
+private:
+	bool parseFirstLineRange (const QByteArray &buffer, int begin, int end, RequestState &state);
+	bool parseHeaderLineRange (const QByteArray &buffer, int begin, int end, RequestState &state);
+	
 };
 
 
@@ -0,0 +1,110 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef NURIA_HTTPREQUESTTIMINGS_HPP
+#define NURIA_HTTPREQUESTTIMINGS_HPP
+
+#include "network_global.hpp"
+#include <QMetaType>
+#include <QString>
+
+namespace Nuria {
+
+/**
+ * \brief Timestamps of the phases of a single HTTP request
+ * 
+ * Collected by HttpClient if phase timing has been enabled through
+ * HttpServer::setPhaseTimingEnabled(). All timestamps are taken from a
+ * monotonic clock and are in nanoseconds relative to the creation of the
+ * HttpClient. Phases which have not been reached are \c -1.
+ * 
+ * \sa HttpServer::requestTimed HttpClient::requestTimings
+ */
+struct NURIA_NETWORK_EXPORT HttpRequestTimings {
+	
+	enum Phase {
+		
+		/** The first data of the request has been received. */
+		DataReceived = 0,
+		
+		/** The request header has been received completely. */
+		HeaderReceived,
+		
+		/** The requested path is about to be invoked. */
+		RoutingStarted,
+		
+		/**
+		 * Invoking the path returned. For requests without a body, this
+		 * includes the slot.
+		 */
+		RoutingFinished,
+		
+		/** The request body has been received completely. */
+		BodyReceived,
+		
+		/** The response header has been sent. */
+		HeaderSent,
+		
+		/** The response is complete. */
+		Closed,
+		
+		PhaseCount
+	};
+	
+	/** Constructor. All phases are unreached. */
+	HttpRequestTimings () {
+		for (int i = 0; i < PhaseCount; i++) {
+			this->timestamps[i] = -1;
+		}
+		
+	}
+	
+	/** Returns \c true if \a phase has been reached. */
+	bool isReached (Phase phase) const
+	{ return (this->timestamps[phase] >= 0); }
+	
+	/**
+	 * Returns the nanoseconds between \a from and \a to. Returns \c -1 if
+	 * either hasn't been reached.
+	 */
+	qint64 elapsed (Phase from, Phase to) const {
+		if (!isReached (from) || !isReached (to)) {
+			return -1;
+		}
+		
+		return this->timestamps[to] - this->timestamps[from];
+	}
+	
+	/** Timestamps indexed by Phase. */
+	qint64 timestamps[PhaseCount];
+	
+	/** Nanoseconds spent in HttpFilter's on the response body. */
+	qint64 filterTime = 0;
+	
+	/** The requested path. */
+	QString path;
+	
+	/** The response status code. */
+	int statusCode = 0;
+	
+};
+
+}
+
+Q_DECLARE_METATYPE(Nuria::HttpRequestTimings)
+
+#endif // NURIA_HTTPREQUESTTIMINGS_HPP
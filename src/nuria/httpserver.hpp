@@ -18,6 +18,7 @@
 #define NURIA_HTTPSERVER_HPP
 
 #include "network_global.hpp"
+#include "httprequesttimings.hpp"
 #include "httptransport.hpp"
 #include <QSslCertificate>
 #include <QHostAddress>
@@ -27,7 +28,10 @@
 class QTcpServer;
 
 namespace Nuria {
-namespace Internal { class TcpServer; }
+namespace Internal {
+class TcpServer;
+class HttpThread;
+}
 class HttpServerPrivate;
 class HttpBackend;
 class HttpClient;
@@ -80,6 +84,9 @@ class HttpNode;
  * threading is active (By using setMaxThreads), all request handling will be
  * done in threads and none will be handled in the HttpServer thread.
  * 
+ * New connections are distributed onto the processing threads according to
+ * the scheduling policy, which can be changed through setSchedulingPolicy().
+ * 
  * \warning When using multi-threading, be aware that your code is also
  * thread-safe.
  * 
@@ -113,6 +120,38 @@ public:
 		OneThreadPerCore = -1
 	};
 	
+	/**
+	 * Policies used to choose the processing thread of a new connection.
+	 * Only has an effect if threading is active.
+	 * \sa setSchedulingPolicy
+	 */
+	enum SchedulingPolicy {
+		
+		/** Connections are distributed in turn onto all threads. */
+		RoundRobin = 0,
+		
+		/**
+		 * The thread currently serving the fewest connections is
+		 * chosen.
+		 */
+		LeastConnections = 1,
+		
+		/**
+		 * The thread with the lowest recent request latency is chosen.
+		 * Ties are broken by the count of served connections. As long
+		 * as any thread hasn't finished a request in the last second,
+		 * this behaves like \c LeastConnections.
+		 */
+		LeastRecentLatency = 2,
+		
+		/**
+		 * Two threads are picked at random, of which the one serving
+		 * fewer connections is chosen. This avoids herding on a single
+		 * thread while being cheap to compute.
+		 */
+		PowerOfTwoChoices = 3
+	};
+	
 	/**
 	 * Constructor.
 	 * \sa listen listenSecure
@@ -194,6 +233,34 @@ public:
 	 */
 	void setMaxThreads (int amount);
 	
+	/**
+	 * Returns the policy used to distribute new connections onto the
+	 * processing threads. The default is \c RoundRobin.
+	 */
+	SchedulingPolicy schedulingPolicy () const;
+	
+	/** Sets the scheduling \a policy. */
+	void setSchedulingPolicy (SchedulingPolicy policy);
+	
+	/**
+	 * Returns \c true if listen() and listenSecure() create one listen
+	 * socket per processing thread. The default is \c false.
+	 * \sa setReusePort
+	 */
+	bool reusePort () const;
+	
+	/**
+	 * If \a enabled, following calls to listen() and listenSecure() will
+	 * bind one listen socket per processing thread using \c SO_REUSEPORT.
+	 * The operating system then distributes incoming connections onto the
+	 * threads, so accepting and serving a connection happens in the same
+	 * thread and the scheduling policy is not used.
+	 * 
+	 * If the platform lacks support for \c SO_REUSEPORT, a single listen
+	 * socket is used instead.
+	 */
+	void setReusePort (bool enabled);
+	
 	/**
 	 * Returns the timeout time for \a which in msec.
 	 * A value of \c -1 disables the timeout.
@@ -216,11 +283,74 @@ public:
 	/** Sets the minimal bytes received amount. */
 	void setMinimalBytesReceived (int bytes);
 	
+	/**
+	 * Returns the high water mark used by new transports.
+	 * The default is HttpTransport::DefaultHighWaterMark.
+	 * \sa HttpTransport::highWaterMark
+	 */
+	qint64 highWaterMark () const;
+	
+	/**
+	 * Sets the high water mark of new transports to \a bytes. While more
+	 * than this amount of a response is waiting to be sent, HttpClient
+	 * doesn't read from the device passed to HttpClient::pipeToClient(),
+	 * until it's down to lowWaterMark(). This keeps slow peers from
+	 * making the server buffer large responses in memory.
+	 */
+	void setHighWaterMark (qint64 bytes);
+	
+	/**
+	 * Returns the low water mark used by new transports.
+	 * The default is HttpTransport::DefaultLowWaterMark.
+	 */
+	qint64 lowWaterMark () const;
+	
+	/** Sets the low water mark of new transports to \a bytes. */
+	void setLowWaterMark (qint64 bytes);
+	
+	/**
+	 * Returns \c true if the phases of requests are timed.
+	 * \sa setPhaseTimingEnabled
+	 */
+	bool phaseTimingEnabled () const;
+	
+	/**
+	 * If \a enabled, HttpClient records when each request reaches the
+	 * phases listed in HttpRequestTimings, and requestTimed() is emitted
+	 * for each finished request. This only affects clients created
+	 * afterwards. The default is \c false.
+	 */
+	void setPhaseTimingEnabled (bool enabled);
+	
+	/**
+	 * Returns \c true if HttpClient instances are re-used.
+	 * \sa setClientPoolingEnabled
+	 */
+	bool clientPoolingEnabled () const;
+	
+	/**
+	 * If \a enabled, TCP transports put closed HttpClient instances into
+	 * a pool of their thread instead of deleting them. The next request in
+	 * that thread re-uses a pooled instance, saving its construction.
+	 * 
+	 * Only clients which nothing is connected to anymore are pooled. Code
+	 * which keeps pointers to a HttpClient after it has been closed, like
+	 * a QPointer checked later on, must not be used with this option. The
+	 * default is \c false.
+	 */
+	void setClientPoolingEnabled (bool enabled);
+	
 signals:
 	
 	/** Emitted when \a transport timed out because in \a mode. */
 	void connectionTimedout (Nuria::HttpTransport *transport, Nuria::AbstractTransport::Timeout mode);
 	
+	/**
+	 * Emitted when a request has been completed, if phase timing is
+	 * enabled. This signal is emitted in the thread of the HttpClient.
+	 */
+	void requestTimed (const Nuria::HttpRequestTimings &timings);
+	
 private slots:
 	void forwardTimeout (Nuria::AbstractTransport::Timeout mode);
 	
@@ -234,6 +364,7 @@ private:
 	
 	bool addTcpServerBackend (Internal::TcpServer *server, const QHostAddress &interface, quint16 port);
 	bool addTransport (HttpTransport *transport);
+	Internal::HttpThread *chooseThread ();
 	void startProcessingThreads (int amount);
 	void stopProcessingThreads (int lastN);
 	void notifyBackendsOfNewThread (QThread *serverThread);
@@ -18,6 +18,9 @@
 #define NURIA_HTTPTRANSPORT_HPP
 
 #include "abstracttransport.hpp"
+#include <QVector>
+
+class QFile;
 
 namespace Nuria {
 
@@ -59,6 +62,12 @@ public:
 		/** Maximum requests per transport in a keep-alive session. */
 		MaxRequestsDefault = 10,
 		
+		/** Default value for highWaterMark() in bytes. */
+		DefaultHighWaterMark = 256 * 1024,
+		
+		/** Default value for lowWaterMark() in bytes. */
+		DefaultLowWaterMark = 64 * 1024,
+		
 	};
 	
 	/** Transport types. */
@@ -103,6 +112,33 @@ public:
 	/** Sets the maximum count of requests per transport. */
 	void setMaxRequests (int count);
 	
+	/**
+	 * Returns the amount of bytes of the response of \a client which have
+	 * been handed to the transport, but which were not sent yet. The
+	 * default implementation returns \c 0.
+	 */
+	virtual qint64 bytesToWrite (HttpClient *client) const;
+	
+	/**
+	 * Returns the amount of unsent bytes at which HttpClient stops reading
+	 * from a device passed to HttpClient::pipeToClient().
+	 * \sa bytesToWrite lowWaterMark
+	 */
+	qint64 highWaterMark () const;
+	
+	/** Sets the high water mark. */
+	void setHighWaterMark (qint64 bytes);
+	
+	/**
+	 * Returns the amount of unsent bytes at which HttpClient continues
+	 * reading from the piped device after it has been paused.
+	 * \sa highWaterMark
+	 */
+	qint64 lowWaterMark () const;
+	
+	/** Sets the low water mark. */
+	void setLowWaterMark (qint64 bytes);
+	
 	/** Returns the HttpBackend associated with this transport. */
 	HttpBackend *backend ();
 	
@@ -128,6 +164,31 @@ protected:
 	 */
 	virtual bool sendToRemote (HttpClient *client, const QByteArray &data) = 0;
 	
+	/**
+	 * \overload
+	 * Used by \a client to send \a slices, in order, to the remote party.
+	 * This lets framing layers put headers around a payload without
+	 * copying it. Slices may reference memory of the caller, so
+	 * implementations must copy what they keep after returning.
+	 * 
+	 * The default implementation joins the slices and calls the other
+	 * sendToRemote().
+	 */
+	virtual bool sendToRemote (HttpClient *client, const QVector< QByteArray > &slices);
+	
+	/**
+	 * Used by \a client to send \a length bytes of \a file, starting at
+	 * \a offset, to the remote party without copying the data through
+	 * user-space. This is only attempted if the data doesn't need to be
+	 * filtered.
+	 * 
+	 * If the implementation accepts, it returns \c true and later calls
+	 * sendFileFinished() once the data has been sent or sending failed.
+	 * The default implementation returns \c false, in which case the
+	 * client reads the file itself and uses sendToRemote().
+	 */
+	virtual bool sendFileToRemote (HttpClient *client, QFile *file, qint64 offset, qint64 length);
+	
 	/**
 	 * Used by the \b implementation to write \a data into \a client to be
 	 * processed. The \a client will remove the parts it read from \a data.
@@ -142,6 +203,13 @@ protected:
 	 */
 	void bytesSent (HttpClient *client, qint64 bytes);
 	
+	/**
+	 * Called by \b implementations after a file transfer started by
+	 * sendFileToRemote() has ended. \a success is \c false if not all
+	 * data could be sent.
+	 */
+	void sendFileFinished (HttpClient *client, bool success);
+	
 	/**
 	 * Called by \b implementations after their initialization routine to
 	 * tell the HttpServer that the transport can now be moved to a
@@ -39,7 +39,8 @@ public:
 	/**
 	 * Returns the first line for a HTTP response header.
 	 * If \a message is empty, HttpClient::httpStatusCodeName() will be used
-	 * to generate an appropriate message.
+	 * to generate an appropriate message. These default lines are rendered
+	 * only once and shared afterwards.
 	 */
 	QByteArray writeResponseLine (HttpClient::HttpVersion version, int statusCode,
 				      const QByteArray &message);
@@ -62,12 +63,34 @@ public:
 	 */
 	QByteArray writeHttpHeaders (const HttpClient::HeaderMap &headers);
 	
+	/**
+	 * Returns the complete response header block, consisting of the
+	 * response line, \a headers, the already rendered \a fixedHeaders,
+	 * \a cookies and the terminating empty line.
+	 * 
+	 * The size of the result is computed up-front, so the data is
+	 * written into a single allocation.
+	 * 
+	 * \sa writeResponseLine writeHttpHeaders SlotInfo::setFixedResponseHeaders
+	 */
+	QByteArray writeResponseHeader (HttpClient::HttpVersion version, int statusCode,
+	                                const QByteArray &message, const HttpClient::HeaderMap &headers,
+	                                const HttpClient::Cookies &cookies,
+	                                const QByteArray &fixedHeaders = QByteArray ());
+	
 	/**
 	 * Returns the formatted value for a Date header based on \a dateTime.
 	 * \note \a dateTime is assumed to be in UTC.
 	 */
 	QByteArray dateTimeToHttpDateHeader (const QDateTime &dateTime);
 	
+	/**
+	 * Returns the value for a Date header of the current time. The value
+	 * is cached and only formatted again once the second has changed.
+	 * This function is thread-safe.
+	 */
+	QByteArray currentHttpDate ();
+	
 	/**
 	 * Returns the value for a Range header.
 	 */
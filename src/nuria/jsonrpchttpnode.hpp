@@ -0,0 +1,134 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef NURIA_JSONRPCHTTPNODE_HPP
+#define NURIA_JSONRPCHTTPNODE_HPP
+
+#include "httpnode.hpp"
+
+class QThreadPool;
+
+namespace Nuria {
+
+class JsonRpcHttpNodePrivate;
+class WebSocket;
+
+/**
+ * \brief HttpNode serving JSON-RPC 2.0 requests
+ * 
+ * This node implements JSON-RPC 2.0 as documented at
+ * http://www.jsonrpc.org/specification. Requests are accepted as body of HTTP
+ * POST requests, and as text or binary frames of WebSocket connections to the
+ * path of the node itself. Both single requests and batches of requests are
+ * supported. Notifications, that is requests without an "id", are invoked
+ * but never answered.
+ * 
+ * \par Usage
+ * Register methods using connectMethod(). Arguments are taken from the
+ * "params" object of the request by their name. Positional parameters are not
+ * supported.
+ * 
+ * \code
+ * JsonRpcHttpNode *node = new JsonRpcHttpNode ("rpc", server->root ());
+ * node->connectMethod ("add", { "a", "b" }, Callback::fromLambda ([](int a, int b) {
+ *         return a + b;
+ * }));
+ * \endcode
+ * 
+ * \par Batches
+ * Requests are invoked in the thread of the client, including the entries of
+ * a batch. If a pool was set through setThreadPool(), the entries of a batch
+ * are dispatched concurrently onto it instead, thus methods which may be
+ * invoked through a batch have to be thread-safe then. Over HTTP, the
+ * response of each entry is written to the client as soon as it's available,
+ * in the order of completion. Over WebSockets, the batch response is sent as
+ * one frame once all entries have been answered.
+ * 
+ * If a HTTP request produced no response at all, as it only consisted of
+ * notifications, the status code is set to 204.
+ * 
+ * \par Compatibility
+ * Sub-nodes and slots added through HttpNode::addNode() and
+ * HttpNode::connectSlot() are served as usual.
+ */
+class NURIA_NETWORK_EXPORT JsonRpcHttpNode : public HttpNode {
+	Q_OBJECT
+public:
+	
+	/** Constructor. */
+	explicit JsonRpcHttpNode (const QString &resourceName = QString (), HttpNode *parent = nullptr);
+	
+	/** Destructor. */
+	~JsonRpcHttpNode ();
+	
+	/**
+	 * Registers \a callback to be invoked for requests of the method
+	 * \a name. Arguments are read from the "params" object of the request
+	 * and are passed in the order given by \a argumentNames. Returns
+	 * \c false if the amount of names doesn't match the arguments of
+	 * \a callback.
+	 * 
+	 * The result of \a callback is sent back as "result". If a parameter is
+	 * missing or can't be converted to the argument type, an "Invalid
+	 * params" error is sent instead.
+	 */
+	bool connectMethod (const QString &name, const QStringList &argumentNames, const Callback &callback);
+	
+	/**
+	 * \overload
+	 * \a callback takes either no arguments, or a single QVariantMap which
+	 * receives the "params" object of the request.
+	 */
+	bool connectMethod (const QString &name, const Callback &callback);
+	
+	/** Removes the method \a name. Returns \c true on success. */
+	bool disconnectMethod (const QString &name);
+	
+	/** Returns \c true if a method \a name has been registered. */
+	bool hasMethod (const QString &name) const;
+	
+	/**
+	 * Returns the thread pool the entries of batches are dispatched onto.
+	 * Defaults to \c nullptr, in which case they're invoked one after
+	 * another in the thread of the client.
+	 */
+	QThreadPool *threadPool () const;
+	
+	/**
+	 * Sets the \a pool batch entries are dispatched onto. Ownership is
+	 * \b not transferred. Passing \c nullptr restores the default. Pass
+	 * QThreadPool::globalInstance() to use the global pool.
+	 */
+	void setThreadPool (QThreadPool *pool);
+	
+protected:
+	
+	bool invokePath (const QString &path, const QStringList &parts, int index, HttpClient *client) override;
+	
+private:
+	
+	bool acceptWebSocket (HttpClient *client);
+	void processHttpRequest (HttpClient *client);
+	void processPayload (const QByteArray &data, HttpClient *client, WebSocket *socket);
+	
+	JsonRpcHttpNodePrivate *d_ptr;
+	
+};
+
+}
+
+#endif // NURIA_JSONRPCHTTPNODE_HPP
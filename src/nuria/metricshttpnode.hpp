@@ -0,0 +1,66 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef NURIA_METRICSHTTPNODE_HPP
+#define NURIA_METRICSHTTPNODE_HPP
+
+#include "httpnode.hpp"
+
+namespace Nuria {
+
+/**
+ * \brief HttpNode exposing server metrics in the Prometheus text format
+ * 
+ * NuriaNetwork collects process-wide metrics of all servers: finished
+ * requests by status code, the request latency as histogram, transferred
+ * bytes, timeouts, open transports, WebSocket frames and FastCGI records.
+ * Each thread records into its own set of counters without any locking, the
+ * sets are summed up when this node is requested. The metrics outlive the
+ * transports and threads they were recorded in.
+ * 
+ * Requesting the path of this node returns the current values in version
+ * 0.0.4 of the Prometheus exposition format, as documented at
+ * http://prometheus.io/docs/instrumenting/exposition_formats/
+ * 
+ * \code
+ * new MetricsHttpNode ("metrics", server->root ());
+ * \endcode
+ * 
+ * Sub-nodes and slots are served as usual.
+ */
+class NURIA_NETWORK_EXPORT MetricsHttpNode : public HttpNode {
+	Q_OBJECT
+public:
+	
+	/** Constructor. */
+	explicit MetricsHttpNode (const QString &resourceName = QString (), HttpNode *parent = nullptr);
+	
+	/** Destructor. */
+	~MetricsHttpNode ();
+	
+	/** Returns the current metrics in the Prometheus text format. */
+	static QByteArray exposition ();
+	
+protected:
+	
+	bool invokePath (const QString &path, const QStringList &parts, int index, HttpClient *client) override;
+	
+};
+
+}
+
+#endif // NURIA_METRICSHTTPNODE_HPP
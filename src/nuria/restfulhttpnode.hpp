@@ -36,7 +36,12 @@
 
 namespace Nuria {
 
-namespace Internal { struct RestfulHttpNodeSlotData; }
+namespace Internal {
+struct RestfulHttpNodeSlotData;
+struct RestfulHttpNodeMatch;
+struct RestfulHttpNodeInvokeInfo;
+struct RestfulHttpNodeArgument;
+}
 
 class RestfulHttpNodePrivate;
 class MetaMethod;
@@ -158,6 +163,26 @@ public:
 	void setRestfulHandler (const QString &path, const QStringList &argumentNames,
 				const Callback &callback, bool waitForRequestPostBody = true);
 	
+	/**
+	 * Returns \c true if results are streamed as JSON.
+	 * \sa setStreamJsonResponses
+	 */
+	bool streamJsonResponses () const;
+	
+	/**
+	 * If \a enable is \c true, results which are sent as JSON are written
+	 * to the client in chunks while walking through them, instead of
+	 * building the whole document first. This lowers the memory usage and
+	 * latency of large results.
+	 * 
+	 * In this mode, generateResultData() is only called for QByteArray,
+	 * QString and QJsonDocument results. serializeVariant() is only called
+	 * for types which have no JSON representation, like custom structures.
+	 * 
+	 * The default is \c false.
+	 */
+	void setStreamJsonResponses (bool enable);
+	
 protected:
 	
 	/**
@@ -220,10 +245,14 @@ private:
 	bool invokeMatchLater (Callback callback, const QVariantList &arguments, HttpClient *client);
 	bool invokeMatchNow (Callback callback, const QVariantList &arguments, HttpClient *client);
 	bool invokeMatch (Internal::RestfulHttpNodeSlotData &slotData,
-			  QRegularExpressionMatch &match, HttpClient *client);
-	QVariantList argumentValues (const QStringList &names, const QList<int> &types,
-				     QRegularExpressionMatch &match, HttpClient *client);
+			  Internal::RestfulHttpNodeMatch &match, HttpClient *client);
+	QVector< Internal::RestfulHttpNodeArgument > resolveArguments (const Internal::RestfulHttpNodeSlotData &slotData,
+	                                                               const QStringList &names,
+	                                                               const QList< int > &types);
+	QVariantList argumentValues (const Internal::RestfulHttpNodeInvokeInfo &info,
+				     Internal::RestfulHttpNodeMatch &match, HttpClient *client);
 	bool writeResponse (const QVariant &response, HttpClient *client);
+	bool streamVariantAsJson (const QVariant &variant, HttpClient *client);
 	void addJsonContentTypeHeaderToResponse (HttpClient *client);
 	QVariantMap deepConvertMap (QVariantMap map);
 	QVariantList deepConvertList (QVariantList list);
@@ -0,0 +1,224 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bytescanner.hpp"
+
+#include <QtGlobal>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define NURIA_BYTESCANNER_X86
+#include <immintrin.h>
+#endif
+
+using Nuria::Internal::ByteScanner;
+
+static int findByteScalar (const char *data, int length, char c) {
+	const void *pos = ::memchr (data, c, size_t (length));
+	return (pos) ? int (static_cast< const char * > (pos) - data) : -1;
+}
+
+static int findSubstringScalar (const char *data, int length, const char *needle, int needleLength) {
+	int skip[256];
+	int last = needleLength - 1;
+	
+	// Boyer-Moore-Horspool
+	for (int i = 0; i < 256; i++) {
+		skip[i] = needleLength;
+	}
+	
+	for (int i = 0; i < last; i++) {
+		skip[uchar (needle[i])] = last - i;
+	}
+	
+	for (int i = 0; i <= length - needleLength; i += skip[uchar (data[i + last])]) {
+		if (data[i + last] == needle[last] && !::memcmp (data + i, needle, size_t (last))) {
+			return i;
+		}
+		
+	}
+	
+	return -1;
+}
+
+#ifdef NURIA_BYTESCANNER_X86
+static int findByteSse2 (const char *data, int length, char c) {
+	const __m128i needle = _mm_set1_epi8 (c);
+	int i = 0;
+	
+	for (; i + 16 <= length; i += 16) {
+		__m128i block = _mm_loadu_si128 (reinterpret_cast< const __m128i * > (data + i));
+		unsigned mask = unsigned (_mm_movemask_epi8 (_mm_cmpeq_epi8 (block, needle)));
+		
+		if (mask) {
+			return i + __builtin_ctz (mask);
+		}
+		
+	}
+	
+	// Remainder
+	for (; i < length; i++) {
+		if (data[i] == c) {
+			return i;
+		}
+		
+	}
+	
+	return -1;
+}
+
+__attribute__((target("avx2")))
+static int findByteAvx2 (const char *data, int length, char c) {
+	const __m256i needle = _mm256_set1_epi8 (c);
+	int i = 0;
+	
+	for (; i + 32 <= length; i += 32) {
+		__m256i block = _mm256_loadu_si256 (reinterpret_cast< const __m256i * > (data + i));
+		unsigned mask = unsigned (_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (block, needle)));
+		
+		if (mask) {
+			return i + __builtin_ctz (mask);
+		}
+		
+	}
+	
+	// Remainder
+	int result = findByteSse2 (data + i, length - i, c);
+	return (result == -1) ? -1 : i + result;
+}
+
+// Candidates are positions where both the first and the last byte of the
+// needle match. Only those are verified using memcmp().
+static int findSubstringSse2 (const char *data, int length, const char *needle, int needleLength) {
+	const __m128i first = _mm_set1_epi8 (needle[0]);
+	const __m128i last = _mm_set1_epi8 (needle[needleLength - 1]);
+	int lastOffset = needleLength - 1;
+	int i = 0;
+	
+	for (; i + lastOffset + 16 <= length; i += 16) {
+		__m128i blockFirst = _mm_loadu_si128 (reinterpret_cast< const __m128i * > (data + i));
+		__m128i blockLast = _mm_loadu_si128 (reinterpret_cast< const __m128i * > (data + i + lastOffset));
+		__m128i matches = _mm_and_si128 (_mm_cmpeq_epi8 (blockFirst, first), _mm_cmpeq_epi8 (blockLast, last));
+		unsigned mask = unsigned (_mm_movemask_epi8 (matches));
+		
+		for (; mask; mask &= mask - 1) {
+			int pos = i + __builtin_ctz (mask);
+			if (!::memcmp (data + pos + 1, needle + 1, size_t (needleLength - 2))) {
+				return pos;
+			}
+			
+		}
+		
+	}
+	
+	// Remainder
+	int result = findSubstringScalar (data + i, length - i, needle, needleLength);
+	return (result == -1) ? -1 : i + result;
+}
+
+__attribute__((target("avx2")))
+static int findSubstringAvx2 (const char *data, int length, const char *needle, int needleLength) {
+	const __m256i first = _mm256_set1_epi8 (needle[0]);
+	const __m256i last = _mm256_set1_epi8 (needle[needleLength - 1]);
+	int lastOffset = needleLength - 1;
+	int i = 0;
+	
+	for (; i + lastOffset + 32 <= length; i += 32) {
+		__m256i blockFirst = _mm256_loadu_si256 (reinterpret_cast< const __m256i * > (data + i));
+		__m256i blockLast = _mm256_loadu_si256 (reinterpret_cast< const __m256i * > (data + i + lastOffset));
+		__m256i matches = _mm256_and_si256 (_mm256_cmpeq_epi8 (blockFirst, first),
+		                                    _mm256_cmpeq_epi8 (blockLast, last));
+		unsigned mask = unsigned (_mm256_movemask_epi8 (matches));
+		
+		for (; mask; mask &= mask - 1) {
+			int pos = i + __builtin_ctz (mask);
+			if (!::memcmp (data + pos + 1, needle + 1, size_t (needleLength - 2))) {
+				return pos;
+			}
+			
+		}
+		
+	}
+	
+	// Remainder
+	int result = findSubstringSse2 (data + i, length - i, needle, needleLength);
+	return (result == -1) ? -1 : i + result;
+}
+#endif
+
+static ByteScanner::Implementation detectImplementation () {
+#ifdef NURIA_BYTESCANNER_X86
+	__builtin_cpu_init ();
+	if (__builtin_cpu_supports ("avx2")) {
+		return ByteScanner::Avx2;
+	}
+	
+	return ByteScanner::Sse2;
+#else
+	return ByteScanner::Scalar;
+#endif
+}
+
+static const ByteScanner::Implementation g_best = detectImplementation ();
+
+// Every implementation implies support for the ones below it.
+static inline ByteScanner::Implementation resolve (ByteScanner::Implementation impl) {
+	return (impl == ByteScanner::Best || impl > g_best) ? g_best : impl;
+}
+
+ByteScanner::Implementation Nuria::Internal::ByteScanner::bestImplementation () {
+	return g_best;
+}
+
+bool Nuria::Internal::ByteScanner::isSupported (Implementation impl) {
+	return (impl <= g_best);
+}
+
+int Nuria::Internal::ByteScanner::findByte (const char *data, int length, char c, Implementation impl) {
+	switch (resolve (impl)) {
+#ifdef NURIA_BYTESCANNER_X86
+	case Avx2: return findByteAvx2 (data, length, c);
+	case Sse2: return findByteSse2 (data, length, c);
+#endif
+	default: return findByteScalar (data, length, c);
+	}
+	
+}
+
+int Nuria::Internal::ByteScanner::findCrLf (const char *data, int length, Implementation impl) {
+	return findSubstring (data, length, "\r\n", 2, impl);
+}
+
+int Nuria::Internal::ByteScanner::findSubstring (const char *data, int length, const char *needle,
+                                                 int needleLength, Implementation impl) {
+	if (needleLength < 1) {
+		return 0;
+	} else if (needleLength > length) {
+		return -1;
+	} else if (needleLength == 1) {
+		return findByte (data, length, needle[0], impl);
+	}
+	
+	// 
+	switch (resolve (impl)) {
+#ifdef NURIA_BYTESCANNER_X86
+	case Avx2: return findSubstringAvx2 (data, length, needle, needleLength);
+	case Sse2: return findSubstringSse2 (data, length, needle, needleLength);
+#endif
+	default: return findSubstringScalar (data, length, needle, needleLength);
+	}
+	
+}
@@ -0,0 +1,57 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef NURIA_INTERNAL_BYTESCANNER_HPP
+#define NURIA_INTERNAL_BYTESCANNER_HPP
+
+namespace Nuria {
+namespace Internal {
+
+// Vectorized searching of delimiters in received data. The best
+// implementation supported by the CPU is chosen at run-time.
+class ByteScanner {
+	ByteScanner () = delete;
+public:
+	
+	enum Implementation {
+		Best = -1,
+		Scalar = 0,
+		Sse2 = 1,
+		Avx2 = 2
+	};
+	
+	// The implementation used when passing Best.
+	static Implementation bestImplementation ();
+	static bool isSupported (Implementation impl);
+	
+	// Returns the index of the first occurence of \a c in \a data, or -1.
+	static int findByte (const char *data, int length, char c, Implementation impl = Best);
+	
+	// Returns the index of the first "\r\n" in \a data, or -1.
+	static int findCrLf (const char *data, int length, Implementation impl = Best);
+	
+	// Returns the index of the first occurence of \a needle in \a data, or
+	// -1. The scalar implementation uses Boyer-Moore-Horspool, the vector
+	// ones compare the first and last byte of the needle on many positions
+	// at once and only verify the candidates.
+	static int findSubstring (const char *data, int length, const char *needle, int needleLength,
+	                          Implementation impl = Best);
+	
+};
+
+}
+}
+
+#endif // NURIA_INTERNAL_BYTESCANNER_HPP
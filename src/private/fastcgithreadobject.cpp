@@ -20,6 +20,7 @@
 #include "fastcgitransport.hpp"
 #include "fastcgireader.hpp"
 #include "fastcgiwriter.hpp"
+#include "metrics.hpp"
 #include <QLocalSocket>
 #include <QTcpSocket>
 #include <QMetaType>
@@ -173,6 +174,8 @@ bool Nuria::Internal::FastCgiThreadObject::processRecord (QIODevice *socket, Fas
 
 bool Nuria::Internal::FastCgiThreadObject::processCompleteRecord (QIODevice *socket, FastCgiRecord record,
                                                                   const QByteArray &body) {
+	Metrics::add (Metrics::FastCgiRecordsReceived);
+	
 	switch (record.type) {
 	case FastCgiType::GetValues: return processGetValues (socket, body);
 	case FastCgiType::BeginRequest: return processBeginRequest (socket, record, body);
@@ -22,6 +22,7 @@
 #include "fastcgithreadobject.hpp"
 #include "fastcgiwriter.hpp"
 #include <QTcpSocket>
+#include <algorithm>
 #include <cctype>
 
 static const QByteArray fcgiRequestVerb = QByteArrayLiteral("REQUEST_METHOD");
@@ -122,6 +123,12 @@ bool Nuria::Internal::FastCgiTransport::isOpen () const {
 	return this->d_ptr->device->isOpen ();
 }
 
+qint64 Nuria::Internal::FastCgiTransport::bytesToWrite (HttpClient *) const {
+	
+	// The connection may be shared with other requests.
+	return this->d_ptr->device->bytesToWrite ();
+}
+
 void Nuria::Internal::FastCgiTransport::forceClose () {
 	closeFcgiRequest ();
 	
@@ -155,6 +162,25 @@ bool Nuria::Internal::FastCgiTransport::sendToRemote (HttpClient *, const QByteA
 	return this->d_ptr->device->isOpen ();
 }
 
+bool Nuria::Internal::FastCgiTransport::sendToRemote (HttpClient *client, const QVector< QByteArray > &slices) {
+	
+	// Put all slices into a single StdOut record if possible. An empty
+	// record would end the stream.
+	bool empty = std::all_of (slices.constBegin (), slices.constEnd (),
+	                          [](const QByteArray &slice) { return slice.isEmpty (); });
+	if (empty) {
+		return this->d_ptr->device->isOpen ();
+	}
+	
+	if (!this->d_ptr->firstLineReplaced ||
+	    !FastCgiWriter::writeStreamMessage (this->d_ptr->device, FastCgiType::StdOut,
+	                                        this->d_ptr->requestId, slices)) {
+		return HttpTransport::sendToRemote (client, slices);
+	}
+	
+	return this->d_ptr->device->isOpen ();
+}
+
 void Nuria::Internal::FastCgiTransport::bytesWritten (qint64 bytes) {
 	bytesSent (this->d_ptr->client, bytes);
 }
@@ -60,6 +60,7 @@ public:
 	Type type () const;
 	bool isSecure () const;
 	bool isOpen () const;
+	qint64 bytesToWrite (HttpClient *) const;
 	QHostAddress localAddress () const;
 	quint16 localPort () const;
 	QHostAddress peerAddress () const;
@@ -75,6 +76,7 @@ protected:
 	
 	void close (HttpClient *client);
 	bool sendToRemote (HttpClient *, const QByteArray &data);
+	bool sendToRemote (HttpClient *client, const QVector< QByteArray > &slices);
 	void forwardBodyData (const QByteArray &data);
 	
 private:
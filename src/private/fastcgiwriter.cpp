@@ -16,6 +16,7 @@
 
 #include "fastcgiwriter.hpp"
 
+#include "metrics.hpp"
 #include <QByteArray>
 #include <QIODevice>
 
@@ -34,6 +35,29 @@ static inline void write (QByteArray &data, const T &t) {
 	data.append (reinterpret_cast< const char * > (&t), sizeof(T));
 }
 
+static inline void writeRecord (QIODevice *device, const FastCgiRecord &record) {
+	write (device, record);
+	Nuria::Internal::Metrics::add (Nuria::Internal::Metrics::FastCgiRecordsSent);
+}
+
+// Writes the record header of a stream message with \a length bytes of content
+static inline bool writeStreamRecord (QIODevice *device, FastCgiType type, uint16_t requestId, int length) {
+	if (length > 0xFFFF) {
+		return false;
+	}
+	
+	FastCgiRecord record;
+	record.version = FastCgiRecord::Version;
+	record.type = type;
+	record.reserved = 0x0;
+	record.requestId = SWAPPED(requestId);
+	record.paddingLength = 0;
+	record.contentLength = SWAPPED(uint16_t (length));
+	
+	writeRecord (device, record);
+	return true;
+}
+
 // 
 static inline void writeNameValueLength (QByteArray &data, int len) {
 	if (len <= NameValueCharLimit) {
@@ -73,7 +97,7 @@ void Nuria::Internal::FastCgiWriter::writeGetValuesResult (QIODevice *device, co
 	record.paddingLength = 0;
 	record.contentLength = SWAPPED(uint16_t (body.length ()));
 	
-	write (device, record);
+	writeRecord (device, record);
 	write (device, body);
 }
 
@@ -91,7 +115,7 @@ void Nuria::Internal::FastCgiWriter::writeUnknownTypeResult (QIODevice *device,
 	body.type = type;
 	memset (body.reserved, 0x0, sizeof(body.reserved));
 	
-	write (device, record);
+	writeRecord (device, record);
 	write (device, body);
 }
 
@@ -111,30 +135,38 @@ void Nuria::Internal::FastCgiWriter::writeEndRequest (QIODevice *device, uint16_
 	body.protocolStatus = protoStatus;
 	memset (body.reserved, 0x0, sizeof(body.reserved));
 	
-	write (device, record);
+	writeRecord (device, record);
 	write (device, body);
 }
 
 bool Nuria::Internal::FastCgiWriter::writeStreamMessage (QIODevice *device, FastCgiType type,
                                                          uint16_t requestId, const QByteArray &body) {
-	if (body.length () > 0xFFFF) {
+	if (!writeStreamRecord (device, type, requestId, body.length ())) {
 		return false;
 	}
 	
-	// 
-	FastCgiRecord record;
-	record.version = FastCgiRecord::Version;
-        record.type = type;
-        record.reserved = 0x0;
-        record.requestId = SWAPPED(requestId);
-        record.paddingLength = 0;
-        record.contentLength = SWAPPED(uint16_t (body.length ()));
-	
-	write (device, record);
 	write (device, body);
 	return true;
 }
 
+bool Nuria::Internal::FastCgiWriter::writeStreamMessage (QIODevice *device, FastCgiType type,
+                                                         uint16_t requestId, const QVector< QByteArray > &body) {
+	int length = 0;
+	for (const QByteArray &slice : body) {
+		length += slice.length ();
+	}
+	
+	if (!writeStreamRecord (device, type, requestId, length)) {
+		return false;
+	}
+	
+	for (const QByteArray &slice : body) {
+		write (device, slice);
+	}
+	
+	return true;
+}
+
 void Nuria::Internal::FastCgiWriter::writeMultiPartStream (QIODevice *device, FastCgiType type,
                                                            uint16_t requestId, const QByteArray &body) {
 	enum { ChunkSize = 0xFFFF };
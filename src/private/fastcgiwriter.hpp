@@ -19,6 +19,7 @@
 
 #include "fastcgistructures.hpp"
 #include <QByteArray>
+#include <QVector>
 #include <QMap>
 class QIODevice;
 
@@ -40,6 +41,8 @@ public:
 	
 	static bool writeStreamMessage (QIODevice *device, FastCgiType type,
 	                                uint16_t requestId, const QByteArray &body);
+	static bool writeStreamMessage (QIODevice *device, FastCgiType type,
+	                                uint16_t requestId, const QVector< QByteArray > &body);
 	static void writeMultiPartStream (QIODevice *device, FastCgiType type,
 	                                  uint16_t requestId, const QByteArray &body);
 	
@@ -0,0 +1,54 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "httpbodyproducerdevice.hpp"
+
+#include "../nuria/httpbodyproducer.hpp"
+#include <cstring>
+
+Nuria::Internal::HttpBodyProducerDevice::HttpBodyProducerDevice (HttpBodyProducer *producer,
+                                                                 HttpClient *client)
+	: m_producer (producer), m_client (client)
+{
+	producer->setParent (this);
+	connect (producer, &HttpBodyProducer::dataAvailable, this, &QIODevice::readyRead);
+	
+	// Unbuffered: Only ask the producer for what's actually sent.
+	open (QIODevice::ReadOnly | QIODevice::Unbuffered);
+	
+}
+
+bool Nuria::Internal::HttpBodyProducerDevice::isSequential () const {
+	return true;
+}
+
+bool Nuria::Internal::HttpBodyProducerDevice::atEnd () const {
+	return this->m_producer->atEnd ();
+}
+
+qint64 Nuria::Internal::HttpBodyProducerDevice::readData (char *data, qint64 maxlen) {
+	QByteArray chunk = this->m_producer->produce (this->m_client, maxlen);
+	qint64 length = qMin (qint64 (chunk.length ()), maxlen);
+	
+	memcpy (data, chunk.constData (), size_t (length));
+	return length;
+}
+
+qint64 Nuria::Internal::HttpBodyProducerDevice::writeData (const char *data, qint64 len) {
+	Q_UNUSED(data)
+	Q_UNUSED(len)
+	return -1;
+}
@@ -0,0 +1,54 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NURIA_INTERNAL_HTTPBODYPRODUCERDEVICE_HPP
+#define NURIA_INTERNAL_HTTPBODYPRODUCERDEVICE_HPP
+
+#include <QIODevice>
+
+namespace Nuria {
+class HttpBodyProducer;
+class HttpClient;
+
+namespace Internal {
+
+/**
+ * Sequential read-only device reading from a HttpBodyProducer. Used by
+ * HttpClient::streamToClient() to re-use the pipeToClient() logic. Takes
+ * ownership of the producer.
+ */
+class HttpBodyProducerDevice : public QIODevice {
+public:
+	
+	HttpBodyProducerDevice (HttpBodyProducer *producer, HttpClient *client);
+	
+	bool isSequential () const override;
+	bool atEnd () const override;
+	
+protected:
+	qint64 readData (char *data, qint64 maxlen) override;
+	qint64 writeData (const char *data, qint64 len) override;
+	
+private:
+	HttpBodyProducer *m_producer;
+	HttpClient *m_client;
+	
+};
+
+}
+}
+
+#endif // NURIA_INTERNAL_HTTPBODYPRODUCERDEVICE_HPP
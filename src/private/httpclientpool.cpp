@@ -0,0 +1,64 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "httpclientpool.hpp"
+
+#include "../nuria/httpclient.hpp"
+#include "../nuria/httpserver.hpp"
+#include <QCoreApplication>
+#include <QVector>
+
+namespace {
+struct ClientPool {
+	QVector< Nuria::HttpClient * > clients;
+	
+	~ClientPool ()
+	{ qDeleteAll (this->clients); }
+	
+};
+}
+
+// Clients belong to the thread they were created in, so does the pool.
+static thread_local ClientPool g_pool;
+
+Nuria::HttpClient *Nuria::Internal::HttpClientPool::acquire (HttpTransport *transport, HttpServer *server) {
+	if (g_pool.clients.isEmpty () || !server->clientPoolingEnabled ()) {
+		return new HttpClient (transport, server);
+	}
+	
+	HttpClient *client = g_pool.clients.takeLast ();
+	client->reuse (transport, server);
+	return client;
+}
+
+bool Nuria::Internal::HttpClientPool::release (HttpClient *client) {
+	if (g_pool.clients.length () >= MaxClientsPerThread || !client->isReusable ()) {
+		return false;
+	}
+	
+	// Neither queued invocations nor a pipe device may reach the client
+	// while it's pooled. It also must not be destroyed together with its
+	// transport.
+	QCoreApplication::removePostedEvents (client);
+	for (QObject *child : client->children ()) {
+		QObject::disconnect (child, nullptr, client, nullptr);
+	}
+	
+	client->setParent (nullptr);
+	
+	g_pool.clients.append (client);
+	return true;
+}
@@ -0,0 +1,56 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NURIA_INTERNAL_HTTPCLIENTPOOL_HPP
+#define NURIA_INTERNAL_HTTPCLIENTPOOL_HPP
+
+namespace Nuria {
+class HttpTransport;
+class HttpClient;
+class HttpServer;
+
+namespace Internal {
+
+/**
+ * Pool of closed HttpClient instances, one per thread. Used by transports if
+ * HttpServer::clientPoolingEnabled() is \c true. Pooled clients are reset in
+ * place when they're handed out again, which happens in a later event than the
+ * one which closed them.
+ */
+class HttpClientPool {
+public:
+	
+	enum { MaxClientsPerThread = 64 };
+	
+	/**
+	 * Returns a client for a new request received by \a transport, taking
+	 * one out of the pool of the current thread if possible.
+	 */
+	static HttpClient *acquire (HttpTransport *transport, HttpServer *server);
+	
+	/**
+	 * Puts the closed \a client into the pool of the current thread.
+	 * Returns \c false if it can't be re-used, in which case the caller
+	 * has to destroy it.
+	 */
+	static bool release (HttpClient *client);
+	
+};
+
+}
+}
+
+#endif // NURIA_INTERNAL_HTTPCLIENTPOOL_HPP
@@ -17,14 +17,23 @@
 #ifndef NURIA_HTTPPRIVATE_HPP
 #define NURIA_HTTPPRIVATE_HPP
 
+#include "../nuria/httpparser.hpp"
 #include "../nuria/httpclient.hpp"
+#include "../nuria/httpnode.hpp"
+#include "nameindex.hpp"
 
+#include <QElapsedTimer>
 #include <QDateTime>
 
 namespace Nuria {
 
 class TemporaryBufferDevice;
 
+namespace Internal {
+struct DeflateStream;
+class StaticResourceCache;
+}
+
 // Private data structure of Nuria::HttpClient
 struct HttpClientPrivate {
 	
@@ -64,14 +73,29 @@ struct HttpClientPrivate {
 	//
 	QIODevice *pipeDevice = nullptr;
 	qint64 pipeMaxlen = -1;
+	bool pipePaused = false;
+	bool pipeClosing = false;
+	bool sendingFile = false;
 	
 	// 
 	SlotInfo slotInfo;
 	QVector< HttpFilter * > filters;
 	
+	// State of the DeflateFilter or GzipFilter, see CompressionFilter
+	Internal::DeflateStream *deflateStream = nullptr;
+	
 	// 
 	bool keepConnectionOpen = false;
 	bool connectionClosed = false;
+	
+	// Progress of the request header parser
+	HttpParser::RequestState parserState;
+	
+	// Started on construction, used to measure the request latency.
+	QElapsedTimer timer;
+	
+	// Phase timestamps, only if enabled in the HttpServer.
+	HttpRequestTimings *timings = nullptr;
 };
 
 class HttpNodePrivate {
@@ -88,6 +112,17 @@ public:
 	// of 'slots' to '' in qobjectdefs.h
 	QMap< QString , SlotInfo > mySlots;
 	
+	// Sub-nodes and slots by their UTF-8 encoded name
+	Internal::NameIndex< HttpNode * > nodeIndex;
+	Internal::NameIndex< SlotInfo > slotIndex;
+	
+	// Pre-compressed static resources
+	bool servePrecompressed = false;
+	QString precompressedCacheDir;
+	
+	// In-memory static resource cache, if enabled
+	Internal::StaticResourceCache *resourceCache = nullptr;
+	
 };
 
 class SlotInfoPrivate : public QSharedData {
@@ -100,6 +135,10 @@ public:
 	HttpClient::HttpVerbs allowedVerbs = HttpClient::HttpVerbs (0xFF);
 	bool forceEncrypted = false;
 	
+	// Frozen header template, pre-rendered by setFixedResponseHeaders()
+	HttpClient::HeaderMap fixedHeaders;
+	QByteArray fixedHeaderData;
+	
 };
 
 }
@@ -17,8 +17,16 @@
 #include "httptcpbackend.hpp"
 
 #include "httptcptransport.hpp"
+#include <nuria/logger.hpp>
+#include "httpthread.hpp"
 #include "tcpserver.hpp"
 
+#include <QThread>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
 Nuria::Internal::HttpTcpBackend::HttpTcpBackend (TcpServer *server, HttpServer *parent)
         : HttpBackend (parent), m_server (server)
 {
@@ -28,15 +36,87 @@ Nuria::Internal::HttpTcpBackend::HttpTcpBackend (TcpServer *server, HttpServer *
 	
 }
 
+Nuria::Internal::HttpTcpBackend::~HttpTcpBackend () {
+	
+	// The acceptors live in the server threads. Make sure none of them
+	// is still accepting a connection before we go away.
+	for (const QPointer< TcpServer > &acceptor : this->m_acceptors) {
+		if (!acceptor) {
+			continue;
+		}
+		
+		disconnect (acceptor, nullptr, this, nullptr);
+		
+		QThread *thread = acceptor->thread ();
+		if (thread != QThread::currentThread () && thread->isRunning ()) {
+			QMetaObject::invokeMethod (acceptor, "stopListening", Qt::BlockingQueuedConnection);
+		} else {
+			acceptor->stopListening ();
+		}
+		
+		acceptor->deleteLater ();
+	}
+	
+#ifdef Q_OS_UNIX
+	if (this->m_pendingDescriptor != -1) {
+		::close (int (this->m_pendingDescriptor));
+	}
+#endif
+	
+}
+
 bool Nuria::Internal::HttpTcpBackend::listen (const QHostAddress &interface, quint16 port) {
 	return this->m_server->listen (interface, port);
 }
 
+bool Nuria::Internal::HttpTcpBackend::listenReusePort (const QHostAddress &interface, quint16 port) {
+	if (!TcpServer::reusePortSupported ()) {
+		nWarn() << "SO_REUSEPORT is not supported on this platform, using a single listen socket.";
+		return listen (interface, port);
+	}
+	
+	// Create the first socket right away to report errors and to find
+	// out the port if it was chosen by the OS.
+	this->m_pendingDescriptor = TcpServer::createReusePortSocket (interface, port);
+	if (this->m_pendingDescriptor == -1) {
+		return false;
+	}
+	
+	// All further sockets must bind to the same port.
+	if (port == 0) {
+		port = TcpServer::boundPort (this->m_pendingDescriptor);
+	}
+	
+	// 
+	this->m_reusePort = true;
+	this->m_interface = interface;
+	this->m_port = port;
+	return true;
+}
+
 bool Nuria::Internal::HttpTcpBackend::isListening () const {
+	if (this->m_reusePort) {
+		if (this->m_pendingDescriptor != -1) {
+			return true;
+		}
+		
+		for (const QPointer< TcpServer > &acceptor : this->m_acceptors) {
+			if (acceptor && acceptor->isListening ()) {
+				return true;
+			}
+		}
+		
+		return false;
+	}
+	
 	return this->m_server->isListening ();
 }
 
 int Nuria::Internal::HttpTcpBackend::port () const {
+	if (this->m_reusePort) {
+		return (this->m_port != 0) ? this->m_port : -1;
+	}
+	
 	return this->m_server->serverPort ();
 }
 
@@ -45,6 +125,74 @@ void Nuria::Internal::HttpTcpBackend::newClient (qintptr handle) {
 	Q_UNUSED(transport)
 }
 
+void Nuria::Internal::HttpTcpBackend::serverThreadCreated (QThread *thread) {
+	if (!this->m_reusePort) {
+		return;
+	}
+	
+	// Use the socket created by listenReusePort() if it's still unused.
+	qintptr descriptor = this->m_pendingDescriptor;
+	this->m_pendingDescriptor = -1;
+	
+	if (descriptor == -1) {
+		descriptor = TcpServer::createReusePortSocket (this->m_interface, this->m_port);
+	}
+	
+	TcpServer *acceptor = (descriptor != -1) ? createAcceptor (descriptor) : nullptr;
+	if (!acceptor) {
+		nError() << "Failed to create listen socket on port" << this->m_port << "for thread" << thread;
+		return;
+	}
+	
+	// Stop accepting when the thread is about to go away
+	HttpThread *httpThread = qobject_cast< HttpThread * > (thread);
+	if (httpThread) {
+		connect (httpThread, &HttpThread::aboutToStop, acceptor, &QTcpServer::close);
+	}
+	
+	connect (thread, &QThread::finished, acceptor, &QObject::deleteLater, Qt::DirectConnection);
+	connect (acceptor, &QObject::destroyed, this, &HttpTcpBackend::acceptorDestroyed);
+	
+	// 
+	this->m_acceptors.append (QPointer< TcpServer > (acceptor));
+	acceptor->moveToThread (thread);
+	
+}
+
+Nuria::Internal::TcpServer *Nuria::Internal::HttpTcpBackend::createAcceptor (qintptr socketDescriptor) {
+	TcpServer *acceptor = new TcpServer (this->m_server->useEncryption ());
+	
+#ifndef NURIA_NO_SSL_HTTP
+	acceptor->setPrivateKey (this->m_server->privateKey ());
+	acceptor->setLocalCertificate (this->m_server->localCertificate ());
+#endif
+	
+	if (!acceptor->setSocketDescriptor (socketDescriptor)) {
+#ifdef Q_OS_UNIX
+		::close (int (socketDescriptor));
+#endif
+		delete acceptor;
+		return nullptr;
+	}
+	
+	// Accept the connection in the thread of the acceptor. The backend is
+	// the context, so the destructor can disconnect this again.
+	connect (acceptor, &TcpServer::connectionRequested, this, [this, acceptor](qintptr handle) {
+		newClientInThread (handle, acceptor);
+	}, Qt::DirectConnection);
+	
+	return acceptor;
+}
+
+void Nuria::Internal::HttpTcpBackend::newClientInThread (qintptr handle, TcpServer *acceptor) {
+	HttpTcpTransport *transport = new HttpTcpTransport (handle, this, httpServer (), acceptor);
+	Q_UNUSED(transport)
+}
+
+void Nuria::Internal::HttpTcpBackend::acceptorDestroyed () {
+	this->m_acceptors.removeAll (QPointer< TcpServer > ());
+}
+
 Nuria::Internal::TcpServer *Nuria::Internal::HttpTcpBackend::tcpServer () const {
 	return this->m_server;
 }
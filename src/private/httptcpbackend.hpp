@@ -19,6 +19,9 @@
 
 #include "../nuria/httpbackend.hpp"
 #include "../nuria/httpserver.hpp"
+#include <QHostAddress>
+#include <QPointer>
+#include <QVector>
 
 namespace Nuria {
 namespace Internal {
@@ -30,8 +33,14 @@ class HttpTcpBackend : public HttpBackend {
 public:
 	
 	HttpTcpBackend (TcpServer *server, HttpServer *parent);
+	~HttpTcpBackend () override;
 	
 	bool listen (const QHostAddress &interface, quint16 port);
+	
+	// Lets each server thread accept connections on its own listening
+	// socket bound using SO_REUSEPORT. The kernel distributes incoming
+	// connections between those, so they never cross threads.
+	bool listenReusePort (const QHostAddress &interface, quint16 port);
 
 	bool isListening () const override;
 	int port () const override;
@@ -40,8 +49,22 @@ public:
 	
 	TcpServer *tcpServer () const;
 	
+protected:
+	void serverThreadCreated (QThread *thread) override;
+	
 private:
+	TcpServer *createAcceptor (qintptr socketDescriptor);
+	void newClientInThread (qintptr handle, TcpServer *acceptor);
+	void acceptorDestroyed ();
+	
 	TcpServer *m_server;
+	
+	bool m_reusePort = false;
+	QHostAddress m_interface;
+	quint16 m_port = 0;
+	qintptr m_pendingDescriptor = -1;
+	QVector< QPointer< TcpServer > > m_acceptors;
+	
 };
 
 }
@@ -18,12 +18,26 @@
 
 #include "../nuria/httpclient.hpp"
 #include "../nuria/httpserver.hpp"
+#include "httpclientpool.hpp"
 #include "httptcpbackend.hpp"
 #include <nuria/logger.hpp>
 #include "tcpserver.hpp"
 
+#include <QVarLengthArray>
+#include <QSocketNotifier>
 #include <QSslSocket>
 #include <QTcpSocket>
+#include <QFile>
+
+#ifdef Q_OS_LINUX
+#include <sys/sendfile.h>
+#include <errno.h>
+#endif
+
+#ifdef Q_OS_UNIX
+#include <sys/uio.h>
+#include <errno.h>
+#endif
 
 namespace Nuria {
 namespace Internal {
@@ -35,18 +49,38 @@ public:
 	QSslSocket *sslSocket = nullptr;
 	HttpClient *curClient = nullptr;
 	HttpServer *server;
+	TcpServer *acceptor = nullptr;
 	
+	// Received data not yet consumed by the client. Data is read into its
+	// spare capacity, and consumed from the front in place.
 	QByteArray buffer;
 	
+	// Response data which has not been handed to the socket yet
+	QByteArray corkBuffer;
+	bool flushQueued = false;
+	bool receiving = false;
+	
+	// State of sendFileToRemote(). While a file is being sent, response
+	// data is kept in corkBuffer, so the write notifier of the socket stays
+	// disabled and writeNotifier is the only one watching the descriptor.
+	QFile *sendFile = nullptr;
+	qint64 sendFileOffset = 0;
+	qint64 sendFileRemaining = 0;
+	QSocketNotifier *writeNotifier = nullptr;
+	
 };
 }
 }
 
-Nuria::Internal::HttpTcpTransport::HttpTcpTransport (qintptr handle, HttpTcpBackend *backend, HttpServer *server)
+Nuria::Internal::HttpTcpTransport::HttpTcpTransport (qintptr handle, HttpTcpBackend *backend, HttpServer *server,
+                                                     TcpServer *acceptor)
 	: HttpTransport (backend, server), d_ptr (new HttpTcpTransportPrivate)
 {
 	this->d_ptr->socketHandle = handle;
 	this->d_ptr->server = server;
+	this->d_ptr->acceptor = acceptor;
+	this->d_ptr->corkBuffer.reserve (CorkLimit);
+	this->d_ptr->buffer.reserve (ReceiveBufferSize);
 	
 	addToServer ();
 }
@@ -104,12 +138,26 @@ bool Nuria::Internal::HttpTcpTransport::isOpen () const {
 	return this->d_ptr->socket->isOpen ();
 }
 
+qint64 Nuria::Internal::HttpTcpTransport::bytesToWrite (HttpClient *) const {
+	if (!this->d_ptr->socket) {
+		return 0;
+	}
+	
+	qint64 pending = this->d_ptr->corkBuffer.length () + this->d_ptr->socket->bytesToWrite ();
+	if (this->d_ptr->sslSocket) {
+		pending += this->d_ptr->sslSocket->encryptedBytesToWrite ();
+	}
+	
+	return pending;
+}
+
 
 bool Nuria::Internal::HttpTcpTransport::flush (HttpClient *) {
 	if (!this->d_ptr->socket) {
 		return false;
 	}
 	
+	flushCorked ();
 	return this->d_ptr->socket->flush ();
 }
 
@@ -118,11 +166,24 @@ void Nuria::Internal::HttpTcpTransport::close (HttpClient *client) {
 		return;
 	}
 	
+	// Abort a running file transfer
+	if (this->d_ptr->sendFile) {
+		this->d_ptr->sendFile = nullptr;
+		this->d_ptr->writeNotifier->setEnabled (false);
+	}
+	
+	// Hand the remaining response to the socket before looking at its
+	// write buffer.
+	flushCorked ();
+	
 	// Throw the client away
 	HttpClient::ConnectionMode mode = HttpClient::ConnectionClose;
 	if (this->d_ptr->curClient) {
 		mode = this->d_ptr->curClient->connectionMode ();
-		this->d_ptr->curClient->deleteLater ();
+		if (!HttpClientPool::release (this->d_ptr->curClient)) {
+			this->d_ptr->curClient->deleteLater ();
+		}
+		
 		this->d_ptr->curClient = nullptr;
 	}
 	
@@ -141,7 +202,258 @@ bool Nuria::Internal::HttpTcpTransport::sendToRemote (HttpClient *client, const
 	}
 	
 	// 
-	return (this->d_ptr->socket->write (data) == data.length ());
+	return queueData (&data, 1);
+}
+
+bool Nuria::Internal::HttpTcpTransport::sendToRemote (HttpClient *client, const QVector< QByteArray > &slices) {
+	if (client != this->d_ptr->curClient || !this->d_ptr->socket || !this->d_ptr->socket->isOpen ()) {
+		return false;
+	}
+	
+	// 
+	return queueData (slices.constData (), slices.length ());
+}
+
+bool Nuria::Internal::HttpTcpTransport::queueData (const QByteArray *slices, int count) {
+	int length = this->d_ptr->corkBuffer.length ();
+	for (int i = 0; i < count; i++) {
+		length += slices[i].length ();
+	}
+	
+	// Small writes are combined and sent later on in one go. While a file
+	// is being sent, everything has to wait until it's done.
+	if (length <= CorkLimit || this->d_ptr->sendFile) {
+		for (int i = 0; i < count; i++) {
+			this->d_ptr->corkBuffer.append (slices[i]);
+		}
+		
+		scheduleFlush ();
+		return true;
+	}
+	
+	// Too large to be combined. Send what has been gathered so far together
+	// with the new data, without copying the latter. The parts must be gone
+	// before the buffer is cleared: Clearing it while it's shared would
+	// detach it, losing its reserved capacity.
+	bool result;
+	{
+		QVarLengthArray< QByteArray, 8 > parts;
+		parts.append (this->d_ptr->corkBuffer);
+		parts.append (slices, count);
+		result = writeToSocket (parts.constData (), parts.size ());
+	}
+	
+	this->d_ptr->corkBuffer.resize (0);
+	return result;
+}
+
+void Nuria::Internal::HttpTcpTransport::scheduleFlush () {
+	
+	// dataReceived() flushes once it's done.
+	if (this->d_ptr->receiving || this->d_ptr->flushQueued) {
+		return;
+	}
+	
+	this->d_ptr->flushQueued = true;
+	QMetaObject::invokeMethod (this, "flushCorked", Qt::QueuedConnection);
+}
+
+void Nuria::Internal::HttpTcpTransport::flushCorked () {
+	this->d_ptr->flushQueued = false;
+	
+	if (this->d_ptr->corkBuffer.isEmpty () || this->d_ptr->sendFile ||
+	    !this->d_ptr->socket || !this->d_ptr->socket->isOpen ()) {
+		return;
+	}
+	
+	writeToSocket (&this->d_ptr->corkBuffer, 1);
+	this->d_ptr->corkBuffer.resize (0);
+}
+
+bool Nuria::Internal::HttpTcpTransport::writeToSocket (const QByteArray *slices, int count) {
+	
+	// writev() can only be used if nothing is queued in the socket, and
+	// QSslSocket has to encrypt everything itself.
+#ifdef Q_OS_UNIX
+	bool direct = (!this->d_ptr->sslSocket && !this->d_ptr->sendFile &&
+	               this->d_ptr->socket->bytesToWrite () == 0 &&
+	               this->d_ptr->socket->state () == QAbstractSocket::ConnectedState);
+#else
+	bool direct = false;
+#endif
+	
+	qint64 written = 0;
+	
+#ifdef Q_OS_UNIX
+	if (direct) {
+		QVarLengthArray< struct iovec, 8 > vectors;
+		for (int i = 0; i < count; i++) {
+			if (!slices[i].isEmpty ()) {
+				struct iovec vector = { const_cast< char * > (slices[i].constData ()),
+				                        size_t (slices[i].length ()) };
+				vectors.append (vector);
+			}
+			
+		}
+		
+		if (vectors.isEmpty ()) {
+			return true;
+		}
+		
+		ssize_t result;
+		do {
+			result = ::writev (int (this->d_ptr->socket->socketDescriptor ()),
+			                   vectors.constData (), vectors.size ());
+		} while (result < 0 && errno == EINTR);
+		
+		if (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+			return false;
+		}
+		
+		written = qMax (qint64 (result), qint64 (0));
+	}
+#endif
+	
+	// Queue what the kernel didn't take in the socket
+	qint64 skip = written;
+	for (int i = 0; i < count; i++) {
+		const QByteArray &slice = slices[i];
+		if (skip >= slice.length ()) {
+			skip -= slice.length ();
+			continue;
+		}
+		
+		if (this->d_ptr->socket->write (slice.constData () + skip, slice.length () - skip) !=
+		    slice.length () - skip) {
+			return false;
+		}
+		
+		skip = 0;
+	}
+	
+	// QTcpSocket doesn't know about the bytes written by us. Report them
+	// later on, like QTcpSocket would do.
+	if (written > 0) {
+		QMetaObject::invokeMethod (this, "bytesWritten", Qt::QueuedConnection, Q_ARG(qint64, written));
+	}
+	
+	return true;
+}
+
+bool Nuria::Internal::HttpTcpTransport::sendFileToRemote (HttpClient *client, QFile *file,
+                                                         qint64 offset, qint64 length) {
+#ifdef Q_OS_LINUX
+	if (client != this->d_ptr->curClient || this->d_ptr->sslSocket || this->d_ptr->sendFile ||
+	    !this->d_ptr->socket || !this->d_ptr->socket->isOpen ()) {
+		return false;
+	}
+	
+	// The response header must be in the socket before sendfile() is used.
+	flushCorked ();
+	
+	this->d_ptr->sendFile = file;
+	this->d_ptr->sendFileOffset = offset;
+	this->d_ptr->sendFileRemaining = length;
+	
+	if (!this->d_ptr->writeNotifier) {
+		this->d_ptr->writeNotifier = new QSocketNotifier (this->d_ptr->socket->socketDescriptor (),
+		                                                  QSocketNotifier::Write, this);
+		connect (this->d_ptr->writeNotifier, &QSocketNotifier::activated,
+		         this, &HttpTcpTransport::continueSendFile);
+	}
+	
+	this->d_ptr->writeNotifier->setEnabled (false);
+	continueSendFile ();
+	return true;
+#else
+	Q_UNUSED(client)
+	Q_UNUSED(file)
+	Q_UNUSED(offset)
+	Q_UNUSED(length)
+	return false;
+#endif
+}
+
+void Nuria::Internal::HttpTcpTransport::continueSendFile () {
+#ifdef Q_OS_LINUX
+	enum { MaxBytesPerCall = 4 * 1024 * 1024 };
+	
+	if (!this->d_ptr->sendFile) {
+		return;
+	}
+	
+	// Data buffered by the socket (The response header) must be sent first.
+	// bytesWritten() calls us again.
+	this->d_ptr->writeNotifier->setEnabled (false);
+	if (this->d_ptr->socket->bytesToWrite () > 0) {
+		this->d_ptr->socket->flush ();
+		
+		// flush() may have called us again through bytesWritten()
+		if (this->d_ptr->socket->bytesToWrite () > 0 || !this->d_ptr->sendFile ||
+		    this->d_ptr->writeNotifier->isEnabled ()) {
+			return;
+		}
+		
+	}
+	
+	// Send until the socket buffer is full. Return to the event loop after
+	// some time to not starve other connections.
+	int socketFd = int (this->d_ptr->socket->socketDescriptor ());
+	int fileFd = this->d_ptr->sendFile->handle ();
+	qint64 sent = 0;
+	
+	while (this->d_ptr->sendFileRemaining > 0) {
+		if (sent >= MaxBytesPerCall) {
+			this->d_ptr->writeNotifier->setEnabled (true);
+			return;
+		}
+		
+		off_t offset = off_t (this->d_ptr->sendFileOffset);
+		size_t count = size_t (qMin (this->d_ptr->sendFileRemaining, qint64 (MaxBytesPerCall)));
+		ssize_t result = ::sendfile (socketFd, fileFd, &offset, count);
+		
+		if (result > 0) {
+			this->d_ptr->sendFileOffset += result;
+			this->d_ptr->sendFileRemaining -= result;
+			sent += result;
+			bytesSent (this->d_ptr->curClient, result);
+			addBytesSent (result);
+		} else if (result < 0 && errno == EINTR) {
+			continue;
+		} else if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			this->d_ptr->writeNotifier->setEnabled (true);
+			return;
+		} else {
+			// Error, or the file has been truncated
+			finishSendFile (false);
+			return;
+		}
+		
+	}
+	
+	finishSendFile (true);
+#endif
+}
+
+void Nuria::Internal::HttpTcpTransport::finishSendFile (bool success) {
+	if (!this->d_ptr->sendFile) {
+		return;
+	}
+	
+	this->d_ptr->sendFile = nullptr;
+	this->d_ptr->sendFileRemaining = 0;
+	
+	if (this->d_ptr->writeNotifier) {
+		this->d_ptr->writeNotifier->setEnabled (false);
+	}
+	
+	// Send what has been written in the meantime
+	flushCorked ();
+	
+	if (this->d_ptr->curClient) {
+		sendFileFinished (this->d_ptr->curClient, success);
+	}
+	
 }
 
 void Nuria::Internal::HttpTcpTransport::clientDestroyed (QObject *object) {
@@ -149,6 +461,12 @@ void Nuria::Internal::HttpTcpTransport::clientDestroyed (QObject *object) {
 		return;
 	}
 	
+	// The file is owned by the client
+	if (this->d_ptr->sendFile) {
+		this->d_ptr->sendFile = nullptr;
+		this->d_ptr->writeNotifier->setEnabled (false);
+	}
+	
 	// 
 	close (this->d_ptr->curClient);
 	
@@ -160,6 +478,13 @@ void Nuria::Internal::HttpTcpTransport::bytesWritten (qint64 bytes) {
 	}
 	
 	addBytesSent (bytes);
+	
+	// Continue with the file once the socket buffer has been written.
+	if (this->d_ptr->sendFile && this->d_ptr->socket->bytesToWrite () == 0 &&
+	    !this->d_ptr->writeNotifier->isEnabled ()) {
+		continueSendFile ();
+	}
+	
 }
 
 void Nuria::Internal::HttpTcpTransport::processData (QByteArray &data) {
@@ -178,15 +503,50 @@ void Nuria::Internal::HttpTcpTransport::processData (QByteArray &data) {
 	
 }
 
-void Nuria::Internal::HttpTcpTransport::appendReceivedDataToBuffer () {
-	QByteArray data = this->d_ptr->socket->readAll ();
-	this->d_ptr->buffer.append (data);
-	addBytesReceived (data.length ());
+bool Nuria::Internal::HttpTcpTransport::appendReceivedDataToBuffer () {
+	QByteArray &buffer = this->d_ptr->buffer;
+	qint64 available = this->d_ptr->socket->bytesAvailable ();
+	if (available <= 0) {
+		return false;
+	}
+	
+	// The buffer only grows if its content couldn't be consumed, e.g. if
+	// the header of a request doesn't fit.
+	int used = buffer.length ();
+	if (used >= buffer.capacity ()) {
+		buffer.reserve (qMax (int (ReceiveBufferSize), buffer.capacity () * 2));
+	}
+	
+	// Read directly into the spare capacity
+	int toRead = int (qMin (available, qint64 (buffer.capacity () - used)));
+	buffer.resize (used + toRead);
+	
+	qint64 bytesRead = this->d_ptr->socket->read (buffer.data () + used, toRead);
+	buffer.resize (used + int (qMax (bytesRead, qint64 (0))));
+	
+	if (bytesRead <= 0) {
+		return false;
+	}
+	
+	addBytesReceived (bytesRead);
+	return true;
 }
 
 void Nuria::Internal::HttpTcpTransport::dataReceived () {
-	appendReceivedDataToBuffer ();
+	this->d_ptr->receiving = true;
+	
+	// Process in pieces of the buffer capacity
+	while (this->d_ptr->socket->isOpen () && appendReceivedDataToBuffer ()) {
+		processBuffer ();
+	}
+	
+	// Send all responses (Or parts of them) of this batch at once.
+	this->d_ptr->receiving = false;
+	flushCorked ();
 	
+}
+
+void Nuria::Internal::HttpTcpTransport::processBuffer () {
 	QByteArray &data = this->d_ptr->buffer;
 	int len = 0;
 	
@@ -199,7 +559,7 @@ void Nuria::Internal::HttpTcpTransport::dataReceived () {
 		if (!this->d_ptr->curClient) {
 			startTimeout (DataTimeout);
 			incrementRequestCount ();
-			this->d_ptr->curClient = new HttpClient (this, this->d_ptr->server);
+			this->d_ptr->curClient = HttpClientPool::acquire (this, this->d_ptr->server);
 		}
 		
 		// 
@@ -224,14 +584,20 @@ void Nuria::Internal::HttpTcpTransport::forceClose () {
 	disconnect (this->d_ptr->socket, &QTcpSocket::disconnected,
 	            this, &HttpTransport::connectionLost);
 	
+	this->d_ptr->corkBuffer.clear ();
 	this->d_ptr->socket->close ();
 	deleteLater ();
 }
 
 void Nuria::Internal::HttpTcpTransport::init () {
 	HttpTcpBackend *tcpBackend = static_cast< HttpTcpBackend * > (backend ());
+	TcpServer *tcpServer = this->d_ptr->acceptor;
+	
+	if (!tcpServer) {
+		tcpServer = tcpBackend->tcpServer ();
+	}
 	
-	this->d_ptr->socket = tcpBackend->tcpServer ()->handleToSocket (this->d_ptr->socketHandle);
+	this->d_ptr->socket = tcpServer->handleToSocket (this->d_ptr->socketHandle);
 	this->d_ptr->sslSocket = qobject_cast< QSslSocket * > (this->d_ptr->socket);
 	
 	if (!this->d_ptr->socket) {
@@ -27,13 +27,33 @@ class HttpServer;
 namespace Internal {
 class HttpTcpTransportPrivate;
 class HttpTcpBackend;
+class TcpServer;
 
+/**
+ * \brief HttpTransport for TCP and SSL connections
+ * 
+ * Small writes to the socket are combined: Response data is collected in a
+ * buffer of up to CorkLimit bytes, which is written when the current batch of
+ * received requests has been processed, when the event loop is reached, or
+ * when the client is closed or flushed. This makes the header and the first
+ * part of the body leave in the same segment (Or TLS record).
+ */
 class HttpTcpTransport : public HttpTransport {
 	Q_OBJECT
 public:
 	
+	enum {
+		
+		/** Bytes collected before they're written right away. */
+		CorkLimit = 16 * 1024,
+		
+		/** Initial capacity of the receive buffer. */
+		ReceiveBufferSize = 16 * 1024
+	};
+	
 	/** Constructor. */
-	explicit HttpTcpTransport (qintptr handle, HttpTcpBackend *backend, HttpServer *server);
+	explicit HttpTcpTransport (qintptr handle, HttpTcpBackend *backend, HttpServer *server,
+	                           TcpServer *acceptor = nullptr);
 	
 	/** Destructor. */
 	~HttpTcpTransport () override;
@@ -46,6 +66,7 @@ public:
 	QHostAddress peerAddress () const override;
 	quint16 peerPort () const override;
 	bool isOpen () const override;
+	qint64 bytesToWrite (HttpClient *) const override;
 	
 public slots:
 	bool flush (HttpClient *) override;
@@ -54,16 +75,25 @@ public slots:
 	
 private slots:
 	bool closeSocketWhenBytesWereWritten ();
+	void bytesWritten (qint64 bytes);
+	void flushCorked ();
 	
 protected:
 	void close (HttpClient *client) override;
 	bool sendToRemote (HttpClient *client, const QByteArray &data) override;
+	bool sendToRemote (HttpClient *client, const QVector< QByteArray > &slices) override;
+	bool sendFileToRemote (HttpClient *client, QFile *file, qint64 offset, qint64 length) override;
 	
 private:
+	bool queueData (const QByteArray *slices, int count);
+	bool writeToSocket (const QByteArray *slices, int count);
+	void scheduleFlush ();
+	void continueSendFile ();
+	void finishSendFile (bool success);
 	void clientDestroyed (QObject *object);
-	void bytesWritten (qint64 bytes);
 	void processData (QByteArray &data);
-	void appendReceivedDataToBuffer ();
+	bool appendReceivedDataToBuffer ();
+	void processBuffer ();
 	void dataReceived ();
 	void clientDisconnected ();
 	void closeInternal ();
@@ -18,9 +18,18 @@
 
 #include "../nuria/httpserver.hpp"
 #include <nuria/logger.hpp>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <limits>
+
+static qint64 monotonicMsecs () {
+	QElapsedTimer timer;
+	timer.start ();
+	return timer.msecsSinceReference ();
+}
 
 Nuria::Internal::HttpThread::HttpThread (HttpServer *server)
-        : QThread (server), m_server (server)
+        : QThread (server), m_lastSample (-1), m_server (server)
 {
 	
 }
@@ -30,6 +39,10 @@ Nuria::Internal::HttpThread::~HttpThread () {
 		nError() << "Destroying thread with running HttpTransports!";
 	}
 	
+	// Make sure the event loop is gone before QThread is destroyed.
+	quit ();
+	wait ();
+	
 }
 
 void Nuria::Internal::HttpThread::incrementRunning (HttpTransport *transport) {
@@ -48,9 +61,36 @@ void Nuria::Internal::HttpThread::transportDestroyed () {
 	
 }
 
+int Nuria::Internal::HttpThread::runningTransports () const {
+	return this->m_running.load ();
+}
+
+int Nuria::Internal::HttpThread::recentLatency () const {
+	return this->m_latency.load ();
+}
+
+void Nuria::Internal::HttpThread::recordLatency (qint64 usec) {
+	usec = std::min (usec, qint64 (std::numeric_limits< int >::max ()));
+	
+	// Exponentially weighted moving average with a weight of 1/8.
+	// Only the thread itself writes to m_latency.
+	int current = this->m_latency.load ();
+	this->m_latency.store (current + int ((usec - current) / 8));
+	this->m_lastSample.store (monotonicMsecs ());
+	
+}
+
+bool Nuria::Internal::HttpThread::hasRecentLatency () const {
+	qint64 last = this->m_lastSample.load ();
+	return (last >= 0 && monotonicMsecs () - last <= LatencyMaxAge);
+}
+
 void Nuria::Internal::HttpThread::stopGraceful () {
 	this->m_stop.store (1);
+	emit aboutToStop ();
+	
 	if (this->m_running.load () == 0) {
+		exit ();
 		deleteLater ();
 	}
 	
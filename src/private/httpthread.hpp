@@ -18,6 +18,7 @@
 #define NURIA_INTERNAL_HTTPTHREAD_HPP
 
 #include "../nuria/httptransport.hpp"
+#include <QAtomicInteger>
 #include <QThread>
 
 namespace Nuria {
@@ -30,24 +31,45 @@ class HttpThread : public QThread {
 	Q_OBJECT
 public:
 	
+	enum { LatencyMaxAge = 1000 };
+	
 	explicit HttpThread (HttpServer *server = 0);
 	~HttpThread () override;
 	
 	void incrementRunning (HttpTransport *transport);
 	void transportDestroyed ();
 	
+	// Amount of transports currently living in this thread.
+	int runningTransports () const;
+	
+	// Moving average of the latency of recently finished requests in
+	// microseconds. Used by HttpServer to schedule new transports.
+	int recentLatency () const;
+	void recordLatency (qint64 usec);
+	
+	// Returns \c true if a request finished in the last LatencyMaxAge
+	// msec, i.e. if recentLatency() reflects the current load.
+	bool hasRecentLatency () const;
+	
 public slots:
 	
 	// Waits for the currently processed request to be completed and
 	// deletes the thread itself afterwards.
 	void stopGraceful ();
 	
+signals:
+	
+	// Emitted by stopGraceful() before waiting for running requests.
+	void aboutToStop ();
+	
 private slots:
 	void forwardTimeout (Nuria::HttpTransport::Timeout mode);
 	
 private:
 	QAtomicInt m_running;
 	QAtomicInt m_stop;
+	QAtomicInt m_latency;
+	QAtomicInteger< qint64 > m_lastSample; // Monotonic msec, -1 if none
 	HttpServer *m_server;
 	
 };
@@ -0,0 +1,253 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "jsonrpcbatch.hpp"
+
+#include "../nuria/httpclient.hpp"
+#include "../nuria/websocket.hpp"
+#include <QCoreApplication>
+#include <QThreadPool>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QEvent>
+#include <QMutex>
+
+namespace Nuria {
+namespace Internal {
+
+// Shared with the pool threads. Cleared when the batch is destroyed, so late
+// results are dropped instead of being posted to a deleted object.
+struct JsonRpcBatchGuard {
+	QMutex mutex;
+	QObject *receiver;
+};
+
+class JsonRpcResultEvent : public QEvent {
+public:
+	
+	JsonRpcResultEvent (const QByteArray &data)
+	        : QEvent (eventType ()), data (data)
+	{ }
+	
+	static QEvent::Type eventType () {
+		static const QEvent::Type type = QEvent::Type (QEvent::registerEventType ());
+		return type;
+	}
+	
+	QByteArray data;
+	
+};
+
+class JsonRpcCall : public QRunnable {
+public:
+	
+	JsonRpcCall (const std::shared_ptr< JsonRpcBatchGuard > &guard, const JsonRpcMethod &method,
+	             const JsonRpcRequest &request)
+	        : m_guard (guard), m_method (method), m_request (request)
+	{ }
+	
+	void run () override {
+		QByteArray data = JsonRpcBatch::process (this->m_method, this->m_request);
+		
+		QMutexLocker lock (&this->m_guard->mutex);
+		if (this->m_guard->receiver) {
+			QCoreApplication::postEvent (this->m_guard->receiver, new JsonRpcResultEvent (data));
+		}
+		
+	}
+	
+private:
+	std::shared_ptr< JsonRpcBatchGuard > m_guard;
+	JsonRpcMethod m_method;
+	JsonRpcRequest m_request;
+	
+};
+
+}
+}
+
+Nuria::Internal::JsonRpcBatch::JsonRpcBatch (HttpClient *client, bool isBatch)
+        : QObject (client), m_guard (new JsonRpcBatchGuard), m_client (client), m_isBatch (isBatch)
+{
+	this->m_guard->receiver = this;
+}
+
+Nuria::Internal::JsonRpcBatch::JsonRpcBatch (WebSocket *socket, bool isBatch)
+        : QObject (socket), m_guard (new JsonRpcBatchGuard), m_socket (socket), m_isBatch (isBatch)
+{
+	this->m_guard->receiver = this;
+}
+
+Nuria::Internal::JsonRpcBatch::~JsonRpcBatch () {
+	QMutexLocker lock (&this->m_guard->mutex);
+	this->m_guard->receiver = nullptr;
+}
+
+void Nuria::Internal::JsonRpcBatch::invokeNow (const JsonRpcMethod &method, const JsonRpcRequest &request) {
+	addResponseData (process (method, request));
+}
+
+void Nuria::Internal::JsonRpcBatch::invokeLater (QThreadPool *pool, const JsonRpcMethod &method,
+                                                 const JsonRpcRequest &request) {
+	this->m_pending++;
+	pool->start (new JsonRpcCall (this->m_guard, method, request));
+}
+
+void Nuria::Internal::JsonRpcBatch::addResponse (const JsonRpcResponse &response) {
+	QJsonObject object = JsonRpcUtil::serializeResponse (response);
+	addResponseData (QJsonDocument (object).toJson (QJsonDocument::Compact));
+}
+
+void Nuria::Internal::JsonRpcBatch::finish () {
+	this->m_finished = true;
+	completeIfDone ();
+}
+
+Nuria::Internal::JsonRpcResponse
+Nuria::Internal::JsonRpcBatch::invoke (const JsonRpcMethod &method, const JsonRpcRequest &request) {
+	if (request.version < InvalidElement) {
+		return JsonRpcUtil::getErrorResponse (request.id, request.version);
+	}
+	
+	// The Resource extension is not supported by plain methods.
+	if (request.version != JsonRpc2_0 || !method.callback.isValid ()) {
+		return JsonRpcUtil::getErrorResponse (request.id, MethodNotFound);
+	}
+	
+	// Build the argument list from "params"
+	QVariantList arguments;
+	if (method.passParams) {
+		arguments.append (request.params);
+	} else {
+		arguments.reserve (method.types.length ());
+		
+		for (int i = 0; i < method.types.length (); i++) {
+			QVariant value = request.params.value (method.names.at (i));
+			int type = method.types.at (i);
+			
+			if (!value.isValid () ||
+			    (type != QMetaType::QVariant && value.userType () != type && !value.convert (type))) {
+				return JsonRpcUtil::getErrorResponse (request.id, InvalidParams);
+			}
+			
+			arguments.append (value);
+		}
+		
+	}
+	
+	// Invoke
+	int resultType = method.callback.returnType ();
+	QVariant result = method.callback.invoke (arguments);
+	
+	if (resultType != QMetaType::Void && resultType != QMetaType::QVariant && resultType != 0 &&
+	    resultType != result.userType ()) {
+		return JsonRpcUtil::getErrorResponse (request.id, InternalError);
+	}
+	
+	return JsonRpcUtil::getSuccessResponse (request.id, result);
+}
+
+QByteArray Nuria::Internal::JsonRpcBatch::process (const JsonRpcMethod &method, const JsonRpcRequest &request) {
+	JsonRpcResponse response = invoke (method, request);
+	
+	// Notifications are not answered, not even on failure. Requests which
+	// were too broken to tell are.
+	if (request.id.isUndefined () && request.version != InvalidRequest) {
+		return QByteArray ();
+	}
+	
+	QJsonObject object = JsonRpcUtil::serializeResponse (response);
+	return QJsonDocument (object).toJson (QJsonDocument::Compact);
+}
+
+void Nuria::Internal::JsonRpcBatch::customEvent (QEvent *event) {
+	if (event->type () != JsonRpcResultEvent::eventType ()) {
+		QObject::customEvent (event);
+		return;
+	}
+	
+	// 
+	this->m_pending--;
+	addResponseData (static_cast< JsonRpcResultEvent * > (event)->data);
+	completeIfDone ();
+}
+
+void Nuria::Internal::JsonRpcBatch::addResponseData (const QByteArray &data) {
+	static const QByteArray json = QByteArrayLiteral("application/json");
+	
+	if (data.isEmpty ()) {
+		return;
+	}
+	
+	// Batch responses are a JSON array
+	QByteArray separator (1, (this->m_written == 0) ? '[' : ',');
+	this->m_written++;
+	
+	if (this->m_socket) {
+		if (this->m_isBatch) {
+			this->m_buffer.append (separator);
+		}
+		
+		this->m_buffer.append (data);
+		return;
+	}
+	
+	// Stream to the HTTP client
+	if (this->m_written == 1 && !this->m_client->hasResponseHeader (HttpClient::HeaderContentType)) {
+		this->m_client->setResponseHeader (HttpClient::HeaderContentType, json);
+	}
+	
+	if (this->m_isBatch) {
+		this->m_client->write (separator + data);
+	} else {
+		this->m_client->write (data);
+	}
+	
+}
+
+void Nuria::Internal::JsonRpcBatch::completeIfDone () {
+	if (!this->m_finished || this->m_pending > 0) {
+		return;
+	}
+	
+	// Close the array, unless there was nothing to send at all.
+	if (this->m_isBatch && this->m_written > 0) {
+		if (this->m_socket) {
+			this->m_buffer.append (']');
+		} else {
+			this->m_client->write ("]", 1);
+		}
+		
+	}
+	
+	// Send
+	if (this->m_socket) {
+		if (!this->m_buffer.isEmpty ()) {
+			this->m_socket->sendTextFrame (this->m_buffer);
+		}
+		
+	} else {
+		if (this->m_written == 0) {
+			this->m_client->setResponseCode (204);
+		}
+		
+		this->m_client->close ();
+	}
+	
+	// 
+	deleteLater ();
+}
@@ -0,0 +1,104 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef NURIA_INTERNAL_JSONRPCBATCH_HPP
+#define NURIA_INTERNAL_JSONRPCBATCH_HPP
+
+#include <nuria/callback.hpp>
+#include "jsonrpcutil.hpp"
+#include <QByteArray>
+#include <QObject>
+#include <memory>
+
+class QThreadPool;
+
+namespace Nuria {
+class HttpClient;
+class WebSocket;
+
+namespace Internal {
+struct JsonRpcBatchGuard;
+
+// A method as registered in JsonRpcHttpNode.
+struct JsonRpcMethod {
+	Callback callback;
+	QStringList names;
+	QList< int > types;
+	
+	// The callback takes the whole "params" object.
+	bool passParams = false;
+	
+};
+
+// Collects the responses of a single JSON-RPC request or of a batch and sends
+// them to either a HttpClient or a WebSocket. Batch entries are invoked right
+// away or on a thread pool, their responses are written in order of completion. Over HTTP,
+// each response is written as soon as it's available, WebSockets receive the
+// whole batch response in one text frame.
+// 
+// The instance deletes itself after the last response has been sent, and is
+// deleted with the client or socket if that one goes away first.
+class JsonRpcBatch : public QObject {
+	Q_OBJECT
+public:
+	
+	JsonRpcBatch (HttpClient *client, bool isBatch);
+	JsonRpcBatch (WebSocket *socket, bool isBatch);
+	~JsonRpcBatch () override;
+	
+	// Invokes \a method for \a request in the calling thread.
+	void invokeNow (const JsonRpcMethod &method, const JsonRpcRequest &request);
+	
+	// Invokes \a method for \a request on \a pool.
+	void invokeLater (QThreadPool *pool, const JsonRpcMethod &method, const JsonRpcRequest &request);
+	
+	// Adds an already known response, e.g. for invalid batch elements.
+	void addResponse (const JsonRpcResponse &response);
+	
+	// No more requests will be added. Sends the rest of the response once
+	// all pending invocations are done.
+	void finish ();
+	
+	// Invokes \a method and returns the response to \a request.
+	static JsonRpcResponse invoke (const JsonRpcMethod &method, const JsonRpcRequest &request);
+	
+	// Returns the serialized response to \a request, or an empty array if
+	// it's a notification.
+	static QByteArray process (const JsonRpcMethod &method, const JsonRpcRequest &request);
+	
+protected:
+	void customEvent (QEvent *event) override;
+	
+private:
+	void addResponseData (const QByteArray &data);
+	void completeIfDone ();
+	
+	std::shared_ptr< JsonRpcBatchGuard > m_guard;
+	HttpClient *m_client = nullptr;
+	WebSocket *m_socket = nullptr;
+	QByteArray m_buffer;
+	int m_pending = 0;
+	int m_written = 0;
+	bool m_isBatch;
+	bool m_finished = false;
+	
+};
+
+}
+}
+
+#endif // NURIA_INTERNAL_JSONRPCBATCH_HPP
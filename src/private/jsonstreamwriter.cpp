@@ -0,0 +1,272 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "jsonstreamwriter.hpp"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QIODevice>
+#include <QDateTime>
+#include <QLocale>
+#include <qnumeric.h>
+
+Nuria::Internal::JsonStreamWriter::JsonStreamWriter (QIODevice *device, int chunkSize)
+	: m_device (device), m_chunkSize (chunkSize)
+{
+	
+	this->m_buffer.reserve (chunkSize + 64);
+	
+}
+
+void Nuria::Internal::JsonStreamWriter::setConverter (const Converter &converter) {
+	this->m_converter = converter;
+}
+
+bool Nuria::Internal::JsonStreamWriter::write (const QVariant &value) {
+	writeValue (value, 0);
+	return !this->m_failed;
+}
+
+bool Nuria::Internal::JsonStreamWriter::flush () {
+	if (!this->m_device || this->m_buffer.isEmpty ()) {
+		return !this->m_failed;
+	}
+	
+	if (this->m_device->write (this->m_buffer) != this->m_buffer.length ()) {
+		this->m_failed = true;
+	}
+	
+	this->m_buffer.resize (0);
+	return !this->m_failed;
+}
+
+QByteArray Nuria::Internal::JsonStreamWriter::toJson (const QVariant &value, const Converter &converter) {
+	JsonStreamWriter writer (nullptr, 0);
+	writer.setConverter (converter);
+	
+	if (!writer.write (value)) {
+		return QByteArray ();
+	}
+	
+	return writer.m_buffer;
+}
+
+void Nuria::Internal::JsonStreamWriter::writeValue (const QVariant &value, int depth) {
+	static const QByteArray null = QByteArrayLiteral("null");
+	static const QByteArray trueValue = QByteArrayLiteral("true");
+	static const QByteArray falseValue = QByteArrayLiteral("false");
+	
+	int type = value.userType ();
+	switch (type) {
+	case QMetaType::UnknownType:
+	case QMetaType::Nullptr:
+		return appendLiteral (null);
+	case QMetaType::Bool:
+		return appendLiteral (value.toBool () ? trueValue : falseValue);
+	case QMetaType::Int:
+	case QMetaType::Long:
+	case QMetaType::LongLong:
+	case QMetaType::Short:
+	case QMetaType::Char:
+	case QMetaType::SChar:
+		return appendLiteral (QByteArray::number (value.toLongLong ()));
+	case QMetaType::UInt:
+	case QMetaType::ULong:
+	case QMetaType::ULongLong:
+	case QMetaType::UShort:
+	case QMetaType::UChar:
+		return appendLiteral (QByteArray::number (value.toULongLong ()));
+	case QMetaType::Double:
+	case QMetaType::Float:
+		return writeNumber (value.toDouble ());
+	case QMetaType::QString:
+		return writeString (value.toString ());
+	case QMetaType::QByteArray:
+		return writeString (value.toByteArray ());
+	case QMetaType::QDateTime:
+		return writeString (value.toDateTime ().toString (Qt::ISODate));
+	case QMetaType::QDate:
+		return writeString (value.toDate ().toString (Qt::ISODate));
+	case QMetaType::QTime:
+		return writeString (value.toTime ().toString (Qt::ISODate));
+	case QMetaType::QVariantMap:
+		return writeMap (value.toMap (), depth);
+	case QMetaType::QVariantHash:
+		return writeHash (value.toHash (), depth);
+	case QMetaType::QVariantList:
+	case QMetaType::QStringList:
+		return writeList (value.toList (), depth);
+	case QMetaType::QJsonValue:
+		return writeValue (value.value< QJsonValue > ().toVariant (), depth);
+	case QMetaType::QJsonObject:
+		return appendLiteral (QJsonDocument (value.toJsonObject ()).toJson (QJsonDocument::Compact));
+	case QMetaType::QJsonArray:
+		return appendLiteral (QJsonDocument (value.toJsonArray ()).toJson (QJsonDocument::Compact));
+	case QMetaType::QJsonDocument:
+		return appendLiteral (value.toJsonDocument ().toJson (QJsonDocument::Compact));
+	}
+	
+	// Custom structures
+	if (this->m_converter) {
+		QVariant converted = this->m_converter (value);
+		if (converted.isValid () && converted.userType () != type) {
+			return writeValue (converted, depth);
+		}
+		
+	} else if (value.canConvert< QVariantList > ()) {
+		return writeList (value.toList (), depth);
+	} else if (value.canConvert< QVariantMap > ()) {
+		return writeMap (value.toMap (), depth);
+	}
+	
+	// Failed.
+	if (depth == 0) {
+		this->m_failed = true;
+	} else {
+		appendLiteral (null);
+	}
+	
+}
+
+void Nuria::Internal::JsonStreamWriter::writeList (const QVariantList &list, int depth) {
+	append ('[');
+	
+	for (int i = 0; i < list.length (); i++) {
+		if (i > 0) {
+			append (',');
+		}
+		
+		writeValue (list.at (i), depth + 1);
+	}
+	
+	append (']');
+}
+
+void Nuria::Internal::JsonStreamWriter::writeMap (const QVariantMap &map, int depth) {
+	append ('{');
+	
+	for (auto it = map.constBegin (), end = map.constEnd (); it != end; ++it) {
+		if (it != map.constBegin ()) {
+			append (',');
+		}
+		
+		writeString (it.key ());
+		append (':');
+		writeValue (*it, depth + 1);
+	}
+	
+	append ('}');
+}
+
+void Nuria::Internal::JsonStreamWriter::writeHash (const QVariantHash &hash, int depth) {
+	append ('{');
+	
+	for (auto it = hash.constBegin (), end = hash.constEnd (); it != end; ++it) {
+		if (it != hash.constBegin ()) {
+			append (',');
+		}
+		
+		writeString (it.key ());
+		append (':');
+		writeValue (*it, depth + 1);
+	}
+	
+	append ('}');
+}
+
+void Nuria::Internal::JsonStreamWriter::writeString (const QString &string) {
+	writeString (string.toUtf8 ());
+}
+
+void Nuria::Internal::JsonStreamWriter::writeString (const QByteArray &utf8) {
+	static const char hex[] = "0123456789abcdef";
+	const char *data = utf8.constData ();
+	int length = utf8.length ();
+	int begin = 0;
+	
+	append ('"');
+	for (int i = 0; i < length; i++) {
+		uchar c = uchar (data[i]);
+		if (c >= 0x20 && c != '"' && c != '\\') {
+			continue;
+		}
+		
+		// Write the run of plain characters, then the escaped one
+		append (data + begin, i - begin);
+		begin = i + 1;
+		
+		switch (c) {
+		case '"': append ("\\\"", 2); break;
+		case '\\': append ("\\\\", 2); break;
+		case '\b': append ("\\b", 2); break;
+		case '\f': append ("\\f", 2); break;
+		case '\n': append ("\\n", 2); break;
+		case '\r': append ("\\r", 2); break;
+		case '\t': append ("\\t", 2); break;
+		default: {
+			char escaped[] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF] };
+			append (escaped, 6);
+		} break;
+		}
+		
+	}
+	
+	append (data + begin, length - begin);
+	append ('"');
+}
+
+void Nuria::Internal::JsonStreamWriter::writeNumber (double value) {
+	if (!qIsFinite (value)) {
+		appendLiteral (QByteArrayLiteral("null"));
+		return;
+	}
+	
+#if QT_VERSION >= QT_VERSION_CHECK(5, 7, 0)
+	appendLiteral (QByteArray::number (value, 'g', QLocale::FloatingPointShortest));
+#else
+	// 15 digits are exact for most values, 17 always round-trip.
+	QByteArray number = QByteArray::number (value, 'g', 15);
+	if (number.toDouble () != value) {
+		number = QByteArray::number (value, 'g', 17);
+	}
+	
+	appendLiteral (number);
+#endif
+}
+
+void Nuria::Internal::JsonStreamWriter::append (char c) {
+	this->m_buffer.append (c);
+	chunkWritten ();
+}
+
+void Nuria::Internal::JsonStreamWriter::append (const char *data, int length) {
+	this->m_buffer.append (data, length);
+	chunkWritten ();
+}
+
+void Nuria::Internal::JsonStreamWriter::appendLiteral (const QByteArray &data) {
+	this->m_buffer.append (data);
+	chunkWritten ();
+}
+
+void Nuria::Internal::JsonStreamWriter::chunkWritten () {
+	if (this->m_device && this->m_buffer.length () >= this->m_chunkSize) {
+		flush ();
+	}
+	
+}
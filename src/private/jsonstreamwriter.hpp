@@ -0,0 +1,81 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef NURIA_INTERNAL_JSONSTREAMWRITER_HPP
+#define NURIA_INTERNAL_JSONSTREAMWRITER_HPP
+
+#include <QByteArray>
+#include <QVariant>
+#include <functional>
+
+class QIODevice;
+
+namespace Nuria {
+namespace Internal {
+
+// Writes a QVariant as compact JSON in a single pass. The output is collected
+// in a buffer which is written to the device whenever it exceeds the chunk
+// size, so large lists don't have to be materialized as a whole.
+class JsonStreamWriter {
+public:
+	
+	enum { DefaultChunkSize = 16 * 1024 };
+	
+	// Called for values which are no JSON types, like custom structures.
+	// The result is written instead. An invalid result is written as null.
+	typedef std::function< QVariant(const QVariant &) > Converter;
+	
+	explicit JsonStreamWriter (QIODevice *device, int chunkSize = DefaultChunkSize);
+	
+	void setConverter (const Converter &converter);
+	
+	// Writes \a value. Returns \c false if \a value itself couldn't be
+	// converted, in which case nothing is written, or if writing to the
+	// device failed.
+	bool write (const QVariant &value);
+	
+	// Writes the buffered data to the device.
+	bool flush ();
+	
+	// Returns \a value as JSON.
+	static QByteArray toJson (const QVariant &value, const Converter &converter = Converter ());
+	
+private:
+	void writeValue (const QVariant &value, int depth);
+	void writeList (const QVariantList &list, int depth);
+	void writeMap (const QVariantMap &map, int depth);
+	void writeHash (const QVariantHash &hash, int depth);
+	void writeString (const QString &string);
+	void writeString (const QByteArray &utf8);
+	void writeNumber (double value);
+	void append (char c);
+	void append (const char *data, int length);
+	void appendLiteral (const QByteArray &data);
+	void chunkWritten ();
+	
+	QIODevice *m_device;
+	QByteArray m_buffer;
+	int m_chunkSize;
+	Converter m_converter;
+	bool m_failed = false;
+	
+};
+
+}
+}
+
+#endif // NURIA_INTERNAL_JSONSTREAMWRITER_HPP
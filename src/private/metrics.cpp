@@ -0,0 +1,193 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "metrics.hpp"
+
+#include <QAtomicPointer>
+#include <QtAlgorithms>
+#include <algorithm>
+
+namespace Nuria {
+namespace Internal {
+
+// Counters of a single thread. Only the owning thread writes to it.
+struct MetricsShard {
+	QAtomicInteger< quint64 > counters[Metrics::CounterCount];
+	QAtomicInteger< quint64 > statusCodes[Metrics::StatusCodes];
+	QAtomicInteger< quint64 > latency[MetricsHistogram::Buckets];
+	QAtomicInteger< quint64 > latencySum;
+	
+	QAtomicInt inUse;
+	MetricsShard *next = nullptr;
+	
+};
+
+// Releases the shard of a thread when it finishes.
+struct MetricsShardRef {
+	MetricsShard *shard = nullptr;
+	
+	~MetricsShardRef () {
+		if (this->shard) {
+			this->shard->inUse.storeRelease (0);
+		}
+		
+	}
+	
+};
+
+}
+}
+
+// List of all shards. Shards are only ever added.
+static QAtomicPointer< Nuria::Internal::MetricsShard > g_shards;
+
+static Nuria::Internal::MetricsShard *acquireShard () {
+	using namespace Nuria::Internal;
+	
+	// Reuse the shard of a finished thread
+	for (MetricsShard *cur = g_shards.loadAcquire (); cur; cur = cur->next) {
+		if (cur->inUse.testAndSetAcquire (0, 1)) {
+			return cur;
+		}
+		
+	}
+	
+	// Push a new one
+	MetricsShard *shard = new MetricsShard;
+	shard->inUse.store (1);
+	
+	do {
+		shard->next = g_shards.loadAcquire ();
+	} while (!g_shards.testAndSetRelease (shard->next, shard));
+	
+	return shard;
+}
+
+static inline Nuria::Internal::MetricsShard *localShard () {
+	static thread_local Nuria::Internal::MetricsShardRef ref;
+	
+	if (!ref.shard) {
+		ref.shard = acquireShard ();
+	}
+	
+	return ref.shard;
+}
+
+// There's only one writer per shard, so no read-modify-write is needed.
+static inline void increment (QAtomicInteger< quint64 > &counter, quint64 amount) {
+	counter.store (counter.load () + amount);
+}
+
+int Nuria::Internal::MetricsHistogram::bucketIndex (quint64 value) {
+	if (value < SubBuckets) {
+		return int (value);
+	}
+	
+	int magnitude = 63 - qCountLeadingZeroBits (value);
+	int shift = magnitude - SubBucketBits;
+	int index = (shift + 1) * SubBuckets + int ((value >> shift) & (SubBuckets - 1));
+	return std::min (index, int (Buckets) - 1);
+}
+
+quint64 Nuria::Internal::MetricsHistogram::lowerBound (int index) {
+	if (index < SubBuckets) {
+		return quint64 (index);
+	}
+	
+	int shift = index / SubBuckets - 1;
+	return quint64 (SubBuckets + index % SubBuckets) << shift;
+}
+
+quint64 Nuria::Internal::MetricsHistogram::upperBound (int index) {
+	if (index < SubBuckets) {
+		return quint64 (index);
+	}
+	
+	int shift = index / SubBuckets - 1;
+	return lowerBound (index) + (quint64 (1) << shift) - 1;
+}
+
+quint64 Nuria::Internal::MetricsSnapshot::latencyPercentile (double percentile) const {
+	if (this->latencyCount == 0) {
+		return 0;
+	}
+	
+	// Find the bucket containing the n-th value
+	quint64 rank = quint64 (qMax (1.0, (percentile / 100.0) * this->latencyCount + 0.5));
+	quint64 seen = 0;
+	
+	for (int i = 0; i < this->latency.length (); i++) {
+		seen += this->latency.at (i);
+		if (seen >= rank) {
+			return MetricsHistogram::upperBound (i);
+		}
+		
+	}
+	
+	return MetricsHistogram::upperBound (this->latency.length () - 1);
+}
+
+void Nuria::Internal::Metrics::add (Counter counter, quint64 amount) {
+	increment (localShard ()->counters[counter], amount);
+}
+
+void Nuria::Internal::Metrics::subtract (Counter counter, quint64 amount) {
+	increment (localShard ()->counters[counter], quint64 (0) - amount);
+}
+
+void Nuria::Internal::Metrics::requestFinished (int statusCode, qint64 usec) {
+	MetricsShard *shard = localShard ();
+	quint64 value = quint64 (qMax (qint64 (0), usec));
+	
+	increment (shard->counters[RequestsTotal], 1);
+	increment (shard->latency[MetricsHistogram::bucketIndex (value)], 1);
+	increment (shard->latencySum, value);
+	
+	if (statusCode >= FirstStatusCode && statusCode <= LastStatusCode) {
+		increment (shard->statusCodes[statusCode - FirstStatusCode], 1);
+	}
+	
+}
+
+template< int N >
+static void sumInto (QVector< quint64 > &target, const QAtomicInteger< quint64 > (&source)[N]) {
+	for (int i = 0; i < N; i++) {
+		target[i] += source[i].load ();
+	}
+	
+}
+
+Nuria::Internal::MetricsSnapshot Nuria::Internal::Metrics::snapshot () {
+	MetricsSnapshot result;
+	result.counters.fill (0, CounterCount);
+	result.statusCodes.fill (0, StatusCodes);
+	result.latency.fill (0, MetricsHistogram::Buckets);
+	
+	for (MetricsShard *cur = g_shards.loadAcquire (); cur; cur = cur->next) {
+		sumInto (result.counters, cur->counters);
+		sumInto (result.statusCodes, cur->statusCodes);
+		sumInto (result.latency, cur->latency);
+		result.latencySum += cur->latencySum.load ();
+	}
+	
+	// Every request has been recorded in exactly one bucket
+	for (quint64 count : result.latency) {
+		result.latencyCount += count;
+	}
+	
+	return result;
+}
@@ -0,0 +1,113 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef NURIA_INTERNAL_METRICS_HPP
+#define NURIA_INTERNAL_METRICS_HPP
+
+#include <QAtomicInteger>
+#include <QVector>
+
+namespace Nuria {
+namespace Internal {
+
+// Log-linear bucketing of values as done by HDR histograms. Values below
+// SubBuckets get a bucket each, above that every power of two is split into
+// SubBuckets buckets, giving a relative error of at most 1 / SubBuckets.
+class MetricsHistogram {
+	MetricsHistogram () = delete;
+public:
+	
+	enum {
+		SubBucketBits = 4,
+		SubBuckets = 1 << SubBucketBits,
+		
+		// Values up to 2^40 - 1 are distinguished, bigger ones end up
+		// in the last bucket.
+		Magnitudes = 40,
+		Buckets = (Magnitudes - SubBucketBits + 1) * SubBuckets
+	};
+	
+	static int bucketIndex (quint64 value);
+	static quint64 lowerBound (int index);
+	static quint64 upperBound (int index);
+	
+};
+
+// Merged state of all threads. See Metrics::snapshot().
+struct MetricsSnapshot {
+	QVector< quint64 > counters;
+	QVector< quint64 > statusCodes;
+	QVector< quint64 > latency;
+	quint64 latencySum = 0;
+	quint64 latencyCount = 0;
+	
+	// Returns the (highest) latency in microseconds below which
+	// \a percentile percent of the requests finished.
+	quint64 latencyPercentile (double percentile) const;
+	
+};
+
+// Process-wide metrics. Each thread writes to its own shard of counters with
+// plain relaxed loads and stores, so recording never contends and never
+// takes a lock. Readers sum up all shards. Shards of finished threads are
+// kept and reused by new threads, so nothing is lost when a transport or
+// thread goes away.
+class Metrics {
+	Metrics () = delete;
+public:
+	
+	enum Counter {
+		RequestsTotal = 0,
+		BytesReceived,
+		BytesSent,
+		ConnectTimeouts,
+		DataTimeouts,
+		KeepAliveTimeouts,
+		WebSocketFramesReceived,
+		WebSocketFramesSent,
+		FastCgiRecordsReceived,
+		FastCgiRecordsSent,
+		
+		// Gauge, decremented using subtract().
+		OpenTransports,
+		
+		CounterCount
+	};
+	
+	enum {
+		FirstStatusCode = 100,
+		LastStatusCode = 599,
+		StatusCodes = LastStatusCode - FirstStatusCode + 1
+	};
+	
+	// Adds \a amount to \a counter.
+	static void add (Counter counter, quint64 amount = 1);
+	static void subtract (Counter counter, quint64 amount = 1);
+	
+	// Records a finished request answered with \a statusCode which took
+	// \a usec microseconds.
+	static void requestFinished (int statusCode, qint64 usec);
+	
+	// Returns the sum of all threads.
+	static MetricsSnapshot snapshot ();
+	
+};
+
+}
+}
+
+#endif // NURIA_INTERNAL_METRICS_HPP
@@ -0,0 +1,138 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef NURIA_INTERNAL_NAMEINDEX_HPP
+#define NURIA_INTERNAL_NAMEINDEX_HPP
+
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <cstring>
+
+namespace Nuria {
+namespace Internal {
+
+// Open-addressing hash table mapping UTF-8 names to values. Lookups take a
+// pointer and length into a larger buffer, like a segment of the requested
+// path, and don't allocate. The hash of each name is computed on insertion.
+template< typename T >
+class NameIndex {
+public:
+	
+	static uint hash (const char *name, int length)
+	{ return qHashBits (name, size_t (length), 0); }
+	
+	int size () const
+	{ return this->m_size; }
+	
+	// Inserts or replaces the value of \a name.
+	void insert (const QByteArray &name, const T &value) {
+		if ((this->m_size + 1) * 2 > this->m_entries.size ()) {
+			rehash (qMax (8, this->m_entries.size () * 2));
+		}
+		
+		uint h = hash (name.constData (), name.length ());
+		Entry &entry = this->m_entries[slot (h, name.constData (), name.length ())];
+		if (!entry.used) {
+			entry.used = true;
+			entry.hash = h;
+			entry.name = name;
+			this->m_size++;
+		}
+		
+		entry.value = value;
+	}
+	
+	// Removes \a name. Returns \c true if it existed.
+	bool remove (const QByteArray &name) {
+		if (!find (name.constData (), name.length ())) {
+			return false;
+		}
+		
+		// Removing is rare, simply rebuild the table without it.
+		QVector< Entry > entries;
+		entries.swap (this->m_entries);
+		this->m_size = 0;
+		
+		for (const Entry &cur : entries) {
+			if (cur.used && cur.name != name) {
+				insert (cur.name, cur.value);
+			}
+			
+		}
+		
+		return true;
+	}
+	
+	// Returns the value of \a name, or \c nullptr.
+	const T *find (const char *name, int length) const {
+		if (this->m_size == 0) {
+			return nullptr;
+		}
+		
+		const Entry &entry = this->m_entries.at (slot (hash (name, length), name, length));
+		return (entry.used) ? &entry.value : nullptr;
+	}
+	
+private:
+	struct Entry {
+		bool used = false;
+		uint hash = 0;
+		QByteArray name;
+		T value;
+	};
+	
+	// Index of the entry of \a name, or of the free one it would go to.
+	int slot (uint h, const char *name, int length) const {
+		int mask = this->m_entries.size () - 1;
+		int idx = int (h & uint (mask));
+		
+		while (true) {
+			const Entry &cur = this->m_entries.at (idx);
+			if (!cur.used || (cur.hash == h && cur.name.length () == length &&
+			                  ::memcmp (cur.name.constData (), name, size_t (length)) == 0)) {
+				return idx;
+			}
+			
+			idx = (idx + 1) & mask;
+		}
+		
+	}
+	
+	void rehash (int capacity) {
+		QVector< Entry > entries (capacity);
+		entries.swap (this->m_entries);
+		this->m_size = 0;
+		
+		for (const Entry &cur : entries) {
+			if (cur.used) {
+				insert (cur.name, cur.value);
+			}
+			
+		}
+		
+	}
+	
+	QVector< Entry > m_entries;
+	int m_size = 0;
+	
+};
+
+}
+}
+
+#endif // NURIA_INTERNAL_NAMEINDEX_HPP
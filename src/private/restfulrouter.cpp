@@ -0,0 +1,208 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "restfulrouter.hpp"
+
+Nuria::Internal::RestfulRouter::Node::~Node () {
+	qDeleteAll (this->literals);
+	delete this->placeholder;
+}
+
+Nuria::Internal::RestfulRouter::RestfulRouter ()
+	: m_root (new Node)
+{
+	
+}
+
+Nuria::Internal::RestfulRouter::~RestfulRouter () {
+	delete this->m_root;
+}
+
+static bool isPlaceholderName (const QStringRef &name) {
+	if (name.isEmpty () || name.at (0).isDigit ()) {
+		return false;
+	}
+	
+	// Same rules as for named groups in a QRegularExpression
+	for (QChar c : name) {
+		if (c.unicode () > 127 || (!c.isLetterOrNumber () && c != QLatin1Char ('_'))) {
+			return false;
+		}
+		
+	}
+	
+	return true;
+}
+
+static bool isLiteral (const QString &segment) {
+	static const QString special = QStringLiteral("\\^$.|?*+()[]{}");
+	
+	for (QChar c : segment) {
+		if (special.contains (c)) {
+			return false;
+		}
+		
+	}
+	
+	return true;
+}
+
+bool Nuria::Internal::RestfulRouter::parse (const QString &pattern, QStringList &segments, Captures &captures) {
+	segments = pattern.split (QLatin1Char ('/'));
+	captures.clear ();
+	
+	for (int i = 0; i < segments.length (); i++) {
+		const QString &cur = segments.at (i);
+		
+		// Placeholder
+		if (cur.startsWith (QLatin1Char ('{')) && cur.endsWith (QLatin1Char ('}'))) {
+			QStringRef name = cur.midRef (1, cur.length () - 2);
+			if (!isPlaceholderName (name)) {
+				return false;
+			}
+			
+			// Names must be unique
+			for (const Capture &capture : captures) {
+				if (capture.name == name) {
+					return false;
+				}
+				
+			}
+			
+			Capture capture = { name.toString (), i, (i + 1 == segments.length ()) };
+			captures.append (capture);
+			segments[i].clear ();
+			
+		} else if (!isLiteral (cur)) {
+			return false;
+		}
+		
+	}
+	
+	return true;
+}
+
+bool Nuria::Internal::RestfulRouter::insert (const QString &pattern, int id, Captures &captures) {
+	QStringList segments;
+	if (!parse (pattern, segments, captures)) {
+		return false;
+	}
+	
+	// Walk down the tree, creating missing nodes
+	Node *node = this->m_root;
+	int captureIdx = 0;
+	
+	for (int i = 0; i < segments.length (); i++) {
+		bool isCapture = (captureIdx < captures.length () && captures.at (captureIdx).segment == i);
+		
+		if (isCapture && captures.at (captureIdx).rest) {
+			node->rest.append (id);
+			return true;
+		} else if (isCapture) {
+			if (!node->placeholder) {
+				node->placeholder = new Node;
+			}
+			
+			node = node->placeholder;
+			captureIdx++;
+		} else {
+			Node *&child = node->literals[segments.at (i)];
+			if (!child) {
+				child = new Node;
+			}
+			
+			node = child;
+		}
+		
+	}
+	
+	node->routes.append (id);
+	return true;
+}
+
+void Nuria::Internal::RestfulRouter::clear () {
+	delete this->m_root;
+	this->m_root = new Node;
+}
+
+static inline void appendRoutes (Nuria::Internal::RestfulRouter::Matches &result, const QVector< int > &routes) {
+	result.append (routes.constData (), routes.length ());
+}
+
+void Nuria::Internal::RestfulRouter::match (const QStringList &parts, int index, Matches &result) const {
+	
+	// No parts left equals a single empty segment
+	if (index >= parts.length ()) {
+		const Node *node = this->m_root->literals.value (QString ());
+		if (node) {
+			appendRoutes (result, node->routes);
+		}
+		
+		return;
+	}
+	
+	matchNode (this->m_root, parts, index, result);
+}
+
+void Nuria::Internal::RestfulRouter::matchNode (const Node *node, const QStringList &parts, int pos,
+                                                Matches &result) const {
+	if (pos == parts.length ()) {
+		appendRoutes (result, node->routes);
+		return;
+	}
+	
+	// The rest placeholder wants at least one character
+	const QString &cur = parts.at (pos);
+	if (!node->rest.isEmpty () && (pos + 1 < parts.length () || !cur.isEmpty ())) {
+		appendRoutes (result, node->rest);
+	}
+	
+	// Routes may overlap, so try both literals and placeholders
+	if (!node->literals.isEmpty ()) {
+		const Node *child = node->literals.value (cur);
+		if (child) {
+			matchNode (child, parts, pos + 1, result);
+		}
+		
+	}
+	
+	if (node->placeholder && !cur.isEmpty ()) {
+		matchNode (node->placeholder, parts, pos + 1, result);
+	}
+	
+}
+
+QString Nuria::Internal::RestfulRouter::captured (const Captures &captures, const QString &name,
+                                                  const QStringList &parts, int index) {
+	for (const Capture &capture : captures) {
+		if (capture.name == name) {
+			return captured (capture, parts, index);
+		}
+		
+	}
+	
+	return QString ();
+}
+
+QString Nuria::Internal::RestfulRouter::captured (const Capture &capture, const QStringList &parts, int index) {
+	int pos = index + capture.segment;
+	if (!capture.rest || pos + 1 == parts.length ()) {
+		return parts.value (pos);
+	}
+	
+	return QStringList (parts.mid (pos)).join (QLatin1Char ('/'));
+}
@@ -0,0 +1,85 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef NURIA_INTERNAL_RESTFULROUTER_HPP
+#define NURIA_INTERNAL_RESTFULROUTER_HPP
+
+#include <QVarLengthArray>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+
+namespace Nuria {
+namespace Internal {
+
+// Prefix tree over the path segments of RestfulHttpNode routes. A segment is
+// either a literal or a "{name}" placeholder matching any non-empty segment.
+// A placeholder as last segment matches the rest of the path. Patterns using
+// anything else, like "{a}-{b}" or regular expression syntax, can't be
+// represented and have to be matched by a QRegularExpression instead.
+class RestfulRouter {
+public:
+	
+	struct Capture {
+		QString name;
+		int segment;
+		bool rest; // Captures all remaining segments
+	};
+	
+	typedef QVector< Capture > Captures;
+	typedef QVarLengthArray< int, 8 > Matches;
+	
+	RestfulRouter ();
+	~RestfulRouter ();
+	
+	// Adds \a pattern as route \a id. On success, \a captures is set to
+	// the placeholders of \a pattern and \c true is returned.
+	bool insert (const QString &pattern, int id, Captures &captures);
+	
+	// Removes all routes.
+	void clear ();
+	
+	// Appends the ids of all routes matching \a parts, starting at \a index,
+	// to \a result.
+	void match (const QStringList &parts, int index, Matches &result) const;
+	
+	// Returns the value of placeholder \a name in \a parts.
+	static QString captured (const Captures &captures, const QString &name,
+	                         const QStringList &parts, int index);
+	static QString captured (const Capture &capture, const QStringList &parts, int index);
+	
+private:
+	struct Node {
+		~Node ();
+		
+		QHash< QString, Node * > literals;
+		Node *placeholder = nullptr;
+		QVector< int > routes; // Ending in this node
+		QVector< int > rest; // Ending in a placeholder matching the rest
+	};
+	
+	static bool parse (const QString &pattern, QStringList &segments, Captures &captures);
+	void matchNode (const Node *node, const QStringList &parts, int pos, Matches &result) const;
+	
+	Node *m_root;
+	
+};
+
+}
+}
+
+#endif // NURIA_INTERNAL_RESTFULROUTER_HPP
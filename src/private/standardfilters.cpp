@@ -18,27 +18,25 @@
 
 #include <QCoreApplication>
 #include <QAtomicPointer>
-#include <QtEndian>
+#include <cstring>
+#include <zlib.h>
 
-namespace {
-// Please see the files for information on their license.
-#include "adler32.h"
-#include "crc32.h"
-}
+#include "../nuria/httpnode.hpp"
+#include "httpprivate.hpp"
 
 namespace Nuria {
 namespace Internal {
 
-struct CompressFooter {
-        quint32 hashsum = 0;
-        quint32 uncompressedSize = 0;
-} __attribute__((packed));
+struct DeflateStream {
+	z_stream stream;
+	gz_header header;
+	bool initialized = false;
+	bool failed = false;
+};
 
 }
 }
 
-Q_DECLARE_METATYPE(Nuria::Internal::CompressFooter)
-
 template< typename T >
 static T *threadSafeGlobal () {
 	static QAtomicPointer< T > container;
@@ -56,12 +54,33 @@ static T *threadSafeGlobal () {
 	return inst;
 }
 
-static inline QByteArray compress (const QByteArray &data) {
-	// qCompress() prepends the stream length.
-	// Also get rid of the DEFLATE header and footer.
-	QByteArray result = qCompress (data).mid (6);
-	result.chop (4);
-	return result;
+static bool deflateChunk (z_stream *stream, const QByteArray &input, int flush, QByteArray &output) {
+	stream->next_in = reinterpret_cast< Bytef * > (const_cast< char * > (input.constData ()));
+	stream->avail_in = uInt (input.length ());
+	
+	// The bound covers the data itself, the extra bytes the flush marker
+	// and the stream trailer.
+	output.resize (int (deflateBound (stream, uLong (input.length ()))) + 16);
+	int written = 0;
+	
+	do {
+		if (written == output.length ()) {
+			output.resize (output.length () * 2);
+		}
+		
+		stream->next_out = reinterpret_cast< Bytef * > (output.data () + written);
+		stream->avail_out = uInt (output.length () - written);
+		
+		int result = deflate (stream, flush);
+		if (result == Z_STREAM_ERROR) {
+			return false;
+		}
+		
+		written = output.length () - int (stream->avail_out);
+	} while (stream->avail_out == 0);
+	
+	output.resize (written);
+	return true;
 }
 
 Nuria::HttpFilter *Nuria::Internal::DeflateFilter::instance () {
@@ -72,86 +91,103 @@ Nuria::HttpFilter *Nuria::Internal::GzipFilter::instance () {
 	return threadSafeGlobal< GzipFilter > ();
 }
 
-Nuria::Internal::DeflateFilter::DeflateFilter (QObject *parent)
-        : HttpFilter (parent)
+Nuria::Internal::CompressionFilter::CompressionFilter (Format format, QObject *parent)
+	: HttpFilter (parent), m_format (format)
 {
 	
 }
 
-QByteArray Nuria::Internal::DeflateFilter::filterName () const {
-        return QByteArrayLiteral("deflate");
+QByteArray Nuria::Internal::CompressionFilter::filterBegin (HttpClient *client) {
+	// The zlib header is emitted along the first chunk.
+	stream (client);
+	return QByteArray ();
 }
 
-QByteArray Nuria::Internal::DeflateFilter::filterBegin (HttpClient *client) {
-	static const quint8 header[] = { // RFC 1950
-	        0x78 /* cmf */, 0x9C /* flg */
-	};
+bool Nuria::Internal::CompressionFilter::filterData (HttpClient *client, QByteArray &data) {
+	DeflateStream *deflateStream = stream (client);
+	if (deflateStream->failed) {
+		return false;
+	}
+	
+	// Z_SYNC_FLUSH ends the chunk on a byte boundary without resetting
+	// the dictionary.
+	QByteArray compressed;
+	if (!deflateChunk (&deflateStream->stream, data, Z_SYNC_FLUSH, compressed)) {
+		deflateStream->failed = true;
+		return false;
+	}
 	
-	CompressFooter footer;
-	footer.hashsum = 1;
-	client->setProperty ("_nuria_deflate", QVariant::fromValue (footer));
-	return QByteArray::fromRawData (reinterpret_cast< const char * > (header), sizeof(header));
+	data = compressed;
+	return true;
 }
 
-bool Nuria::Internal::DeflateFilter::filterData (HttpClient *client, QByteArray &data) {
-	// According to RFC 1951
+QByteArray Nuria::Internal::CompressionFilter::filterEnd (HttpClient *client) {
+	DeflateStream *deflateStream = stream (client);
 	
-	// Update footer
-	CompressFooter footer = client->property ("_nuria_deflate").value< CompressFooter > ();
-	footer.hashsum = adler32 (footer.hashsum, data.constData (), data.length ());
-	footer.uncompressedSize += data.length ();
-	client->setProperty ("_nuria_deflate", QVariant::fromValue (footer));
+	QByteArray trailer;
+	if (!deflateStream->failed) {
+		deflateChunk (&deflateStream->stream, QByteArray (), Z_FINISH, trailer);
+	}
 	
-	// Compress data.
-	data = compress (data);
-	return true;
+	client->d_ptr->deflateStream = nullptr;
+	destroyStream (deflateStream);
+	return trailer;
 }
 
-QByteArray Nuria::Internal::DeflateFilter::filterEnd (HttpClient *client) {
-	CompressFooter footer = client->property ("_nuria_deflate").value< CompressFooter > ();
+void Nuria::Internal::CompressionFilter::destroyStream (DeflateStream *stream) {
+	if (!stream) {
+		return;
+	}
 	
-	QByteArray result (4, Qt::Uninitialized);
-	int *hash = reinterpret_cast< int * > (result.data ());
-	*hash = qToBigEndian (footer.hashsum);
+	if (stream->initialized) {
+		deflateEnd (&stream->stream);
+	}
 	
-	return result;
+	delete stream;
 }
 
-Nuria::Internal::GzipFilter::GzipFilter (QObject *parent)
-        : HttpFilter (parent)
-{
+Nuria::Internal::DeflateStream *Nuria::Internal::CompressionFilter::stream (HttpClient *client) {
+	DeflateStream *deflateStream = client->d_ptr->deflateStream;
+	if (deflateStream) {
+		return deflateStream;
+	}
+	
+	// 
+	deflateStream = new DeflateStream;
+	memset (&deflateStream->stream, 0, sizeof(z_stream));
+	memset (&deflateStream->header, 0, sizeof(gz_header));
+	client->d_ptr->deflateStream = deflateStream;
+	
+	int result = deflateInit2 (&deflateStream->stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+	                           int (this->m_format), 8, Z_DEFAULT_STRATEGY);
+	deflateStream->initialized = (result == Z_OK);
+	deflateStream->failed = !deflateStream->initialized;
 	
+	// Don't leak the operating system through the gzip header.
+	if (this->m_format == Gzip && deflateStream->initialized) {
+		deflateStream->header.os = 0xFF;
+		deflateSetHeader (&deflateStream->stream, &deflateStream->header);
+	}
+	
+	return deflateStream;
 }
 
-QByteArray Nuria::Internal::GzipFilter::filterName () const {
-	return QByteArrayLiteral("gzip");
+Nuria::Internal::DeflateFilter::DeflateFilter (QObject *parent)
+	: CompressionFilter (Zlib, parent)
+{
+	
 }
 
-QByteArray Nuria::Internal::GzipFilter::filterBegin (HttpClient *) {
-	static const quint8 member[] = {
-	        0x1F /* id1 */, 0x8B /* id2 */, 0x08 /* cm */, 0x0, /* flg */
-	        0x0, 0x0, 0x0, 0x0 /* mtime */, 0x0 /* xfl */, 0xFF /* os */
-	};
-	
-	return QByteArray::fromRawData (reinterpret_cast< const char * > (member), sizeof(member));
+QByteArray Nuria::Internal::DeflateFilter::filterName () const {
+	return QByteArrayLiteral("deflate");
 }
 
-bool Nuria::Internal::GzipFilter::filterData (HttpClient *client, QByteArray &data) {
-	// According to RFC 1952
-	
-	// Update footer
-	CompressFooter footer = client->property ("_nuria_gzip").value< CompressFooter > ();
-	footer.hashsum = crc32 (footer.hashsum, data.constData (), data.length ());
-	footer.uncompressedSize += data.length ();
-	client->setProperty ("_nuria_gzip", QVariant::fromValue (footer));
+Nuria::Internal::GzipFilter::GzipFilter (QObject *parent)
+	: CompressionFilter (Gzip, parent)
+{
 	
-	// Compress data.
-	data = compress (data);
-	return true;
 }
 
-QByteArray Nuria::Internal::GzipFilter::filterEnd (HttpClient *client) {
-	CompressFooter footer = client->property ("_nuria_gzip").value< CompressFooter > ();
-	QByteArray result (reinterpret_cast< char * > (&footer), sizeof(footer));
-	return result;
+QByteArray Nuria::Internal::GzipFilter::filterName () const {
+	return QByteArrayLiteral("gzip");
 }
@@ -22,22 +22,52 @@
 namespace Nuria {
 namespace Internal {
 
-class DeflateFilter : public HttpFilter {
+struct DeflateStream;
+
+/**
+ * Base class of the compressing filters. Each response gets its own zlib
+ * stream, which is flushed at the end of every chunk, so the compression
+ * state is kept across chunks while each chunk is still decodable on its
+ * own. The stream is stored in the HttpClientPrivate of the client.
+ */
+class CompressionFilter : public HttpFilter {
 	Q_OBJECT
 public:
 	
-	static HttpFilter *instance ();
+	enum Format {
+		Zlib = 15, // RFC 1950
+		Gzip = 31 // RFC 1952
+	};
 	
-	explicit DeflateFilter (QObject *parent = 0);
+	explicit CompressionFilter (Format format, QObject *parent = 0);
 	
-	QByteArray filterName () const override;
 	QByteArray filterBegin (HttpClient *client) override;
 	bool filterData (HttpClient *client, QByteArray &data) override;
 	QByteArray filterEnd (HttpClient *client) override;
 	
+	/** Frees \a stream. Does nothing if \a stream is \c nullptr. */
+	static void destroyStream (DeflateStream *stream);
+	
+private:
+	DeflateStream *stream (HttpClient *client);
+	
+	Format m_format;
+	
 };
 
-class GzipFilter : public HttpFilter {
+class DeflateFilter : public CompressionFilter {
+	Q_OBJECT
+public:
+	
+	static HttpFilter *instance ();
+	
+	explicit DeflateFilter (QObject *parent = 0);
+	
+	QByteArray filterName () const override;
+	
+};
+
+class GzipFilter : public CompressionFilter {
 	Q_OBJECT
 public:
 	
@@ -46,9 +76,6 @@ public:
 	explicit GzipFilter (QObject *parent = 0);
 	
 	QByteArray filterName () const override;
-	QByteArray filterBegin (HttpClient *) override;
-	bool filterData (HttpClient *client, QByteArray &data) override;
-	QByteArray filterEnd (HttpClient *client) override;
 	
 };
 
@@ -0,0 +1,302 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "staticresourcecache.hpp"
+
+#include "../nuria/httpwriter.hpp"
+#include "../nuria/httpparser.hpp"
+#include <QMimeDatabase>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QFile>
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+Nuria::Internal::StaticResourceCache::StaticResourceCache (qint64 maxMemory)
+	: m_maxMemory (maxMemory)
+{
+	
+#ifdef Q_OS_LINUX
+	this->m_inotify = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+#endif
+	
+}
+
+Nuria::Internal::StaticResourceCache::~StaticResourceCache () {
+#ifdef Q_OS_LINUX
+	if (this->m_inotify != -1) {
+		::close (this->m_inotify);
+	}
+#endif
+	
+}
+
+qint64 Nuria::Internal::StaticResourceCache::maxMemory () const {
+	return this->m_maxMemory;
+}
+
+Nuria::Internal::StaticResourceCache::EntryPtr
+Nuria::Internal::StaticResourceCache::lookup (const QString &path) {
+	QMutexLocker lock (&this->m_mutex);
+	processFileEvents ();
+	
+	// Cache hit?
+	EntryPtr entry = this->m_entries.value (path);
+	if (entry && !isStale (path, *entry)) {
+		entry->lastUsed = ++this->m_tick;
+		return entry;
+	}
+	
+	// Large files are streamed from disk by the caller
+	lock.unlock ();
+	QFileInfo info (path);
+	if (!info.isFile () || info.size () >= MaxFileSize) {
+		return EntryPtr ();
+	}
+	
+	// Watch the file before reading it, so changes made while it's being
+	// read aren't missed.
+	lock.relock ();
+	int watch = addWatch (path);
+	quint64 changes = this->m_changes;
+	
+	// Load the file without blocking other threads
+	lock.unlock ();
+	entry = load (path);
+	lock.relock ();
+	processFileEvents ();
+	
+	// Don't use what we read if any watched file changed meanwhile
+	if (!entry || changes != this->m_changes) {
+		dropWatch (watch);
+		return EntryPtr ();
+	}
+	
+	entry->watch = watch;
+	insert (path, entry);
+	return entry;
+}
+
+bool Nuria::Internal::StaticResourceCache::isNotModified (const Entry &entry, const QByteArray &ifNoneMatch,
+                                                          const QByteArray &ifModifiedSince) {
+	
+	// If-None-Match takes precedence over If-Modified-Since (RFC 7232)
+	if (!ifNoneMatch.isEmpty ()) {
+		if (ifNoneMatch.trimmed () == "*") {
+			return true;
+		}
+		
+		for (const QByteArray &tag : ifNoneMatch.split (',')) {
+			QByteArray cur = tag.trimmed ();
+			if (cur.startsWith ("W/")) {
+				cur.remove (0, 2);
+			}
+			
+			if (cur == entry.etag) {
+				return true;
+			}
+			
+		}
+		
+		return false;
+	}
+	
+	// Clients usually send the Last-Modified value back unchanged
+	if (ifModifiedSince.isEmpty ()) {
+		return false;
+	} else if (ifModifiedSince == entry.lastModified) {
+		return true;
+	}
+	
+	QDateTime since;
+	return (HttpParser ().parseHttpDateValue (ifModifiedSince, since) &&
+	        since.toMSecsSinceEpoch () / 1000 >= entry.modifiedSecs);
+}
+
+Nuria::Internal::StaticResourceCache::EntryPtr
+Nuria::Internal::StaticResourceCache::load (const QString &path) {
+	QFile file (path);
+	if (!file.open (QIODevice::ReadOnly)) {
+		return EntryPtr ();
+	}
+	
+	// The file may have grown since it was checked
+	qint64 size = file.size ();
+	if (size >= MaxFileSize) {
+		return EntryPtr ();
+	}
+	
+	// 
+	EntryPtr entry (new Entry);
+	entry->data = file.readAll ();
+	if (entry->data.length () != size) {
+		return EntryPtr ();
+	}
+	
+	
+	// Meta data
+	QFileInfo info (path);
+	QDateTime modified = info.lastModified ().toUTC ();
+	QMimeDatabase database;
+	
+	entry->modifiedSecs = modified.toMSecsSinceEpoch () / 1000;
+	entry->lastModified = HttpWriter ().dateTimeToHttpDateHeader (modified);
+	entry->mimeType = database.mimeTypeForFileNameAndData (path, entry->data).name ().toLatin1 ();
+	entry->etag = '"' + QByteArray::number (size, 16) + '-' +
+	              QByteArray::number (modified.toMSecsSinceEpoch (), 16) + '"';
+	
+	entry->checked.start ();
+	return entry;
+}
+
+bool Nuria::Internal::StaticResourceCache::isStale (const QString &path, Entry &entry) {
+	if (entry.watch != -1) {
+		return false; // inotify tells us
+	}
+	
+	// Check the modification time from time to time
+	if (entry.checked.elapsed () < RecheckInterval) {
+		return false;
+	}
+	
+	entry.checked.start ();
+	QFileInfo info (path);
+	return (!info.exists () || info.lastModified ().toMSecsSinceEpoch () / 1000 != entry.modifiedSecs);
+}
+
+void Nuria::Internal::StaticResourceCache::processFileEvents () {
+#ifdef Q_OS_LINUX
+	if (this->m_inotify == -1) {
+		return;
+	}
+	
+	// The descriptor is non-blocking, so this returns right away if
+	// nothing changed.
+	alignas(inotify_event) char buffer[4096];
+	ssize_t len;
+	
+	while ((len = ::read (this->m_inotify, buffer, sizeof(buffer))) > 0) {
+		for (char *cur = buffer; cur < buffer + len; ) {
+			inotify_event *event = reinterpret_cast< inotify_event * > (cur);
+			cur += sizeof(inotify_event) + event->len;
+			
+			QString path = this->m_watches.value (event->wd);
+			if (!path.isEmpty ()) {
+				remove (path);
+			}
+			
+			// Also counts events of watches added by lookup() which
+			// don't belong to an entry yet.
+			this->m_changes++;
+		}
+		
+	}
+	
+#endif
+}
+
+int Nuria::Internal::StaticResourceCache::addWatch (const QString &path) {
+#ifdef Q_OS_LINUX
+	if (this->m_inotify != -1) {
+		uint32_t mask = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVE_SELF | IN_DELETE_SELF;
+		return inotify_add_watch (this->m_inotify, QFile::encodeName (path).constData (), mask);
+	}
+#else
+	Q_UNUSED(path)
+#endif
+	
+	return -1;
+}
+
+void Nuria::Internal::StaticResourceCache::dropWatch (int watch) {
+#ifdef Q_OS_LINUX
+	
+	// The watch is shared by all paths pointing at the same file
+	if (watch != -1 && !this->m_watches.contains (watch)) {
+		inotify_rm_watch (this->m_inotify, watch);
+	}
+	
+#else
+	Q_UNUSED(watch)
+#endif
+}
+
+void Nuria::Internal::StaticResourceCache::insert (const QString &path, const EntryPtr &entry) {
+	
+	// Several paths may point at the same file, which share the watch. The
+	// entry holding it now gives it up to the new one.
+	QString previous = this->m_watches.value (entry->watch);
+	if (entry->watch != -1 && !previous.isEmpty ()) {
+		EntryPtr old = this->m_entries.take (previous);
+		this->m_watches.remove (entry->watch);
+		
+		if (old) {
+			this->m_memory -= old->data.length ();
+		}
+		
+	}
+	
+	remove (path);
+	if (entry->watch != -1) {
+		this->m_watches.insert (entry->watch, path);
+	}
+	
+	// 
+	entry->lastUsed = ++this->m_tick;
+	this->m_entries.insert (path, entry);
+	this->m_memory += entry->data.length ();
+	
+	evict ();
+}
+
+void Nuria::Internal::StaticResourceCache::remove (const QString &path) {
+	EntryPtr entry = this->m_entries.take (path);
+	if (!entry) {
+		return;
+	}
+	
+	this->m_memory -= entry->data.length ();
+	
+#ifdef Q_OS_LINUX
+	if (entry->watch != -1) {
+		this->m_watches.remove (entry->watch);
+		inotify_rm_watch (this->m_inotify, entry->watch);
+	}
+#endif
+	
+}
+
+void Nuria::Internal::StaticResourceCache::evict () {
+	
+	// Throw out the least recently used entries
+	while (this->m_memory > this->m_maxMemory || this->m_entries.size () > MaxEntries) {
+		auto oldest = this->m_entries.constBegin ();
+		for (auto it = this->m_entries.constBegin (); it != this->m_entries.constEnd (); ++it) {
+			if ((*it)->lastUsed < (*oldest)->lastUsed) {
+				oldest = it;
+			}
+			
+		}
+		
+		QString path = oldest.key ();
+		remove (path);
+	}
+	
+}
@@ -0,0 +1,113 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NURIA_INTERNAL_STATICRESOURCECACHE_HPP
+#define NURIA_INTERNAL_STATICRESOURCECACHE_HPP
+
+#include <QSharedPointer>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QBuffer>
+#include <QMutex>
+#include <QHash>
+
+namespace Nuria {
+namespace Internal {
+
+// Cache of static resource files used by HttpNode. Files smaller than
+// MaxFileSize are kept in memory, larger ones are not cached at all and are
+// streamed from disk by the caller. Entries are invalidated through inotify
+// on Linux, and by comparing the modification time once per second elsewhere.
+// All methods are thread-safe.
+class StaticResourceCache {
+public:
+	
+	enum {
+		MaxFileSize = 256 * 1024,
+		MaxEntries = 4096,
+		RecheckInterval = 1000 // msec, if inotify is not available
+	};
+	
+	struct Entry {
+		QByteArray mimeType;
+		QByteArray etag;
+		QByteArray lastModified; // Formatted for the Last-Modified header
+		qint64 modifiedSecs = 0; // Since epoch
+		
+		// File contents
+		QByteArray data;
+		
+		// Bookkeeping
+		quint64 lastUsed = 0;
+		int watch = -1;
+		QElapsedTimer checked;
+	};
+	
+	typedef QSharedPointer< Entry > EntryPtr;
+	
+	// \a maxMemory limits the size of all files held in memory.
+	explicit StaticResourceCache (qint64 maxMemory);
+	~StaticResourceCache ();
+	
+	qint64 maxMemory () const;
+	
+	// Returns the entry of the file at \a path, loading it if it's not
+	// cached yet. Returns \c nullptr if the file can't be read, is too
+	// large or changed while being read.
+	EntryPtr lookup (const QString &path);
+	
+	// Returns \c true if \a entry matches the conditional request headers.
+	static bool isNotModified (const Entry &entry, const QByteArray &ifNoneMatch,
+	                           const QByteArray &ifModifiedSince);
+	
+private:
+	EntryPtr load (const QString &path);
+	bool isStale (const QString &path, Entry &entry);
+	void processFileEvents ();
+	int addWatch (const QString &path);
+	void dropWatch (int watch);
+	void insert (const QString &path, const EntryPtr &entry);
+	void remove (const QString &path);
+	void evict ();
+	
+	QMutex m_mutex;
+	QHash< QString, EntryPtr > m_entries;
+	QHash< int, QString > m_watches;
+	qint64 m_maxMemory;
+	qint64 m_memory = 0;
+	quint64 m_tick = 0;
+	quint64 m_changes = 0;
+	int m_inotify = -1;
+	
+};
+
+// Device over the data of a cached entry. Keeps the entry alive.
+class CachedResourceDevice : public QBuffer {
+public:
+	
+	explicit CachedResourceDevice (const StaticResourceCache::EntryPtr &entry)
+		: m_entry (entry)
+	{ setData (entry->data); }
+	
+private:
+	StaticResourceCache::EntryPtr m_entry;
+	
+};
+
+}
+}
+
+#endif // NURIA_INTERNAL_STATICRESOURCECACHE_HPP
@@ -23,6 +23,13 @@
 #include <QSslSocket>
 #endif
 
+#ifdef Q_OS_UNIX
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
 Nuria::Internal::TcpServer::TcpServer (bool useSsl, QObject *parent)
 	: QTcpServer (parent), m_ssl (useSsl)
 {
@@ -88,6 +95,100 @@ QTcpSocket *Nuria::Internal::TcpServer::handleToSocket (qintptr handle) {
 	
 }
 
+qintptr Nuria::Internal::TcpServer::createReusePortSocket (const QHostAddress &interface, quint16 port) {
+#if defined(Q_OS_UNIX) && defined(SO_REUSEPORT)
+	bool any = (interface == QHostAddress::Any);
+	bool ipv6 = (any || interface.protocol () == QAbstractSocket::IPv6Protocol);
+	
+	int fd = ::socket (ipv6 ? AF_INET6 : AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) {
+		return -1;
+	}
+	
+	// 
+	int one = 1;
+	int zero = 0;
+	::setsockopt (fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	if (::setsockopt (fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0) {
+		::close (fd);
+		return -1;
+	}
+	
+	// Build the address to bind to
+	sockaddr_storage addr;
+	socklen_t addrLen;
+	::memset (&addr, 0, sizeof(addr));
+	
+	if (ipv6) {
+		sockaddr_in6 *in6 = reinterpret_cast< sockaddr_in6 * > (&addr);
+		in6->sin6_family = AF_INET6;
+		in6->sin6_port = htons (port);
+		addrLen = sizeof(sockaddr_in6);
+		
+		if (any) {
+			::setsockopt (fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+		} else {
+			Q_IPV6ADDR ip = interface.toIPv6Address ();
+			::memcpy (&in6->sin6_addr, &ip, sizeof(ip));
+		}
+		
+	} else {
+		sockaddr_in *in4 = reinterpret_cast< sockaddr_in * > (&addr);
+		in4->sin_family = AF_INET;
+		in4->sin_port = htons (port);
+		in4->sin_addr.s_addr = htonl (interface.toIPv4Address ());
+		addrLen = sizeof(sockaddr_in);
+	}
+	
+	// 
+	if (::bind (fd, reinterpret_cast< sockaddr * > (&addr), addrLen) != 0 ||
+	    ::listen (fd, SOMAXCONN) != 0) {
+		::close (fd);
+		return -1;
+	}
+	
+	return fd;
+#else
+	Q_UNUSED(interface)
+	Q_UNUSED(port)
+	return -1;
+#endif
+}
+
+bool Nuria::Internal::TcpServer::reusePortSupported () {
+#if defined(Q_OS_UNIX) && defined(SO_REUSEPORT)
+	return true;
+#else
+	return false;
+#endif
+}
+
+quint16 Nuria::Internal::TcpServer::boundPort (qintptr socketDescriptor) {
+#ifdef Q_OS_UNIX
+	sockaddr_storage addr;
+	socklen_t addrLen = sizeof(addr);
+	::memset (&addr, 0, sizeof(addr));
+	
+	if (::getsockname (int (socketDescriptor), reinterpret_cast< sockaddr * > (&addr), &addrLen) != 0) {
+		return 0;
+	}
+	
+	if (addr.ss_family == AF_INET6) {
+		return ntohs (reinterpret_cast< sockaddr_in6 * > (&addr)->sin6_port);
+	} else if (addr.ss_family == AF_INET) {
+		return ntohs (reinterpret_cast< sockaddr_in * > (&addr)->sin_port);
+	}
+	
+#else
+	Q_UNUSED(socketDescriptor)
+#endif
+	return 0;
+}
+
+void Nuria::Internal::TcpServer::stopListening () {
+	close ();
+}
+
 bool Nuria::Internal::TcpServer::useEncryption () const {
 	return this->m_ssl;
 }
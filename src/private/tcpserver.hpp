@@ -46,6 +46,21 @@ public:
 	
 	QTcpSocket *handleToSocket (qintptr handle);
 	
+	// Creates a listening socket on \a interface and \a port with
+	// SO_REUSEPORT set, so multiple sockets can be bound to the same port.
+	// Returns the native socket descriptor, or -1 on failure.
+	static qintptr createReusePortSocket (const QHostAddress &interface, quint16 port);
+	static bool reusePortSupported ();
+	
+	// Returns the local port \a socketDescriptor is bound to, or 0.
+	static quint16 boundPort (qintptr socketDescriptor);
+	
+public slots:
+	
+	// Stops listening. Invoked from the thread owning the HttpTcpBackend
+	// to shut down acceptors living in other threads.
+	void stopListening ();
+	
 protected:
 	
 	void incomingConnection (qintptr handle) override;
@@ -0,0 +1,183 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "timerwheel.hpp"
+
+#include <QCoreApplication>
+#include <QThread>
+#include <QTimer>
+
+Nuria::Internal::TimerWheel::Entry::~Entry () {
+	TimerWheel::cancel (this);
+}
+
+Nuria::Internal::TimerWheel::TimerWheel () {
+	for (int i = 0; i < Slots; i++) {
+		this->m_slots[i].prev = this->m_slots[i].next = &this->m_slots[i];
+	}
+	
+	this->m_expired.prev = this->m_expired.next = &this->m_expired;
+	this->m_clock.start ();
+}
+
+Nuria::Internal::TimerWheel::~TimerWheel () {
+	
+	// The event dispatcher of the thread is gone by now, so the timer must
+	// not be touched anymore. It's usually destroyed by shutdown() already.
+	for (int i = 0; i < Slots; i++) {
+		unlinkAll (&this->m_slots[i]);
+	}
+	
+	unlinkAll (&this->m_expired);
+}
+
+Nuria::Internal::TimerWheel *Nuria::Internal::TimerWheel::current () {
+	static thread_local TimerWheel wheel;
+	return &wheel;
+}
+
+void Nuria::Internal::TimerWheel::arm (Entry *entry, int msec) {
+	cancel (entry);
+	
+	// The wheel doesn't advance while it's empty.
+	quint64 now = quint64 (this->m_clock.elapsed ());
+	if (this->m_count == 0) {
+		this->m_ticks = now / TickInterval;
+	}
+	
+	// Round up, so the entry doesn't expire early.
+	quint64 due = (now + quint64 (qMax (msec, 0)) + TickInterval - 1) / TickInterval;
+	due = qMax (due, this->m_ticks + 1);
+	
+	entry->m_wheel = this;
+	entry->m_rounds = (due - this->m_ticks - 1) / Slots;
+	link (&this->m_slots[due % Slots], entry);
+	this->m_count++;
+	
+	// 
+	if (!this->m_timer) {
+		this->m_timer = new QTimer;
+		this->m_timer->setInterval (TickInterval);
+		QObject::connect (this->m_timer, &QTimer::timeout, this->m_timer, [this]() { tick (); });
+		
+		// The main thread doesn't emit finished()
+		QThread *thread = QThread::currentThread ();
+		QCoreApplication *app = QCoreApplication::instance ();
+		if (app && app->thread () == thread) {
+			qAddPostRoutine (&TimerWheel::shutdownCurrent);
+		} else {
+			QObject::connect (thread, &QThread::finished, this->m_timer, [this]() { shutdown (); },
+			                  Qt::DirectConnection);
+		}
+		
+	}
+	
+	if (!this->m_timer->isActive ()) {
+		this->m_timer->start ();
+	}
+	
+}
+
+void Nuria::Internal::TimerWheel::cancel (Entry *entry) {
+	TimerWheel *wheel = entry->m_wheel;
+	if (!wheel) {
+		return;
+	}
+	
+	unlink (entry);
+	entry->m_wheel = nullptr;
+	wheel->m_count--;
+	
+	if (wheel->m_count == 0 && wheel->m_timer) {
+		wheel->m_timer->stop ();
+	}
+	
+}
+
+int Nuria::Internal::TimerWheel::count () const {
+	return this->m_count;
+}
+
+void Nuria::Internal::TimerWheel::shutdown () {
+	for (int i = 0; i < Slots; i++) {
+		unlinkAll (&this->m_slots[i]);
+	}
+	
+	unlinkAll (&this->m_expired);
+	this->m_count = 0;
+	
+	delete this->m_timer;
+	this->m_timer = nullptr;
+}
+
+void Nuria::Internal::TimerWheel::shutdownCurrent () {
+	current ()->shutdown ();
+}
+
+void Nuria::Internal::TimerWheel::tick () {
+	quint64 target = quint64 (this->m_clock.elapsed ()) / TickInterval;
+	
+	// Collect expired entries of all slots passed since the last tick. The
+	// event loop may have been blocked for a while.
+	while (this->m_ticks < target) {
+		this->m_ticks++;
+		Node *head = &this->m_slots[this->m_ticks % Slots];
+		
+		for (Node *node = head->next; node != head;) {
+			Entry *entry = static_cast< Entry * > (node);
+			node = node->next;
+			
+			if (entry->m_rounds > 0) {
+				entry->m_rounds--;
+			} else {
+				unlink (entry);
+				link (&this->m_expired, entry);
+			}
+			
+		}
+		
+	}
+	
+	// Expired entries may arm or cancel any entry, including themselves.
+	while (this->m_expired.next != &this->m_expired) {
+		Entry *entry = static_cast< Entry * > (this->m_expired.next);
+		cancel (entry);
+		entry->expired ();
+	}
+	
+}
+
+void Nuria::Internal::TimerWheel::link (Node *head, Node *node) {
+	node->prev = head->prev;
+	node->next = head;
+	head->prev->next = node;
+	head->prev = node;
+}
+
+void Nuria::Internal::TimerWheel::unlink (Node *node) {
+	node->prev->next = node->next;
+	node->next->prev = node->prev;
+	node->prev = node->next = nullptr;
+}
+
+void Nuria::Internal::TimerWheel::unlinkAll (Node *head) {
+	while (head->next != head) {
+		Entry *entry = static_cast< Entry * > (head->next);
+		unlink (entry);
+		entry->m_wheel = nullptr;
+	}
+	
+}
@@ -0,0 +1,122 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NURIA_INTERNAL_TIMERWHEEL_HPP
+#define NURIA_INTERNAL_TIMERWHEEL_HPP
+
+#include <QElapsedTimer>
+
+class QTimer;
+
+namespace Nuria {
+namespace Internal {
+
+/**
+ * Hashed timer wheel, one per thread. Used for the timeouts of all transports
+ * living in a thread, so there's only a single QTimer per thread instead of one
+ * per connection. Arming, re-arming and cancelling an entry is O(1).
+ * 
+ * Entries expire no earlier than requested, and at most one TickInterval (Plus
+ * the inaccuracy of the event loop) later. All methods must be called from the
+ * thread the wheel belongs to.
+ * 
+ * The QTimer is destroyed by shutdown() once the thread finishes, or for the
+ * main thread, when QCoreApplication is destroyed.
+ */
+class TimerWheel {
+	struct Node {
+		Node *prev = nullptr;
+		Node *next = nullptr;
+	};
+	
+public:
+	
+	enum {
+		
+		/** Resolution of the wheel in msec. */
+		TickInterval = 10,
+		
+		/** Amount of slots, each covering one tick. */
+		Slots = 256
+	};
+	
+	/**
+	 * Base class of things to be armed in the wheel. Destroying an entry
+	 * cancels it.
+	 */
+	class Entry : private Node {
+	public:
+		virtual ~Entry ();
+		
+		/** Returns \c true if the entry is armed. */
+		bool isArmed () const
+		{ return (this->m_wheel != nullptr); }
+		
+	protected:
+		
+		/** Called when the entry expired. It has been disarmed before. */
+		virtual void expired () = 0;
+		
+	private:
+		friend class TimerWheel;
+		TimerWheel *m_wheel = nullptr;
+		quint64 m_rounds = 0;
+	};
+	
+	~TimerWheel ();
+	
+	/** Returns the wheel of the current thread. */
+	static TimerWheel *current ();
+	
+	/** Arms \a entry to expire in \a msec. An armed entry is re-armed. */
+	void arm (Entry *entry, int msec);
+	
+	/** Disarms \a entry. Does nothing if it's not armed. */
+	static void cancel (Entry *entry);
+	
+	/** Returns the amount of armed entries. */
+	int count () const;
+	
+	/**
+	 * Disarms all entries and destroys the timer. Called when the thread
+	 * finishes, while its event dispatcher still exists: The wheel itself
+	 * is only destroyed after that.
+	 */
+	void shutdown ();
+	
+private:
+	TimerWheel ();
+	void tick ();
+	static void shutdownCurrent ();
+	
+	static void link (Node *head, Node *node);
+	static void unlink (Node *node);
+	void unlinkAll (Node *head);
+	
+	QTimer *m_timer = nullptr;
+	QElapsedTimer m_clock;
+	quint64 m_ticks = 0;
+	int m_count = 0;
+	
+	Node m_slots[Slots];
+	Node m_expired;
+	
+};
+
+}
+}
+
+#endif // NURIA_INTERNAL_TIMERWHEEL_HPP
@@ -18,20 +18,23 @@
 #define NURIA_TRANSPORTPRIVATE_HPP
 
 #include "../nuria/abstracttransport.hpp"
-
-class QTimer;
+#include "timerwheel.hpp"
 
 namespace Nuria {
 
-// Private data structure of Nuria::AbstractTransport
-class AbstractTransportPrivate {
+// Private data structure of Nuria::AbstractTransport. Doubles as its entry in
+// the timer wheel of the current thread.
+class AbstractTransportPrivate : public Internal::TimerWheel::Entry {
 public:
 	
 	~AbstractTransportPrivate () {
 		// 
 	}
 	
-	QTimer *timeoutTimer = nullptr;
+	void expired () override;
+	
+	AbstractTransport *q_ptr = nullptr;
+	int timeoutInterval = -1;
 	
 	int requestCount = 0;
 	
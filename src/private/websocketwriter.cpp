@@ -16,7 +16,9 @@
 
 #include "websocketwriter.hpp"
 
+#include "../nuria/httpclient.hpp"
 #include "websocketreader.hpp"
+#include "metrics.hpp"
 #include <QtEndian>
 
 QByteArray Nuria::Internal::WebSocketWriter::serializeFrame (WebSocketFrame frame) {
@@ -52,8 +54,19 @@ QByteArray Nuria::Internal::WebSocketWriter::serializeFrame (WebSocketFrame fram
 void Nuria::Internal::WebSocketWriter::sendToClient (QIODevice *device, bool fin, WebSocketOpcode opcode,
                                                      const char *data, int len) {
 	WebSocketFrame frame { { fin, 0, 0, 0, opcode, 0, 0 }, uint64_t (len), 0 };
-	device->write (serializeFrame (frame));
-	device->write (data, len);
+	QByteArray header = serializeFrame (frame);
+	
+	// Let the transport send header and payload in one go
+	HttpClient *client = qobject_cast< HttpClient * > (device);
+	if (client) {
+		client->writeSlices ({ header, QByteArray::fromRawData (data, len) });
+	} else {
+		device->write (header);
+		device->write (data, len);
+	}
+	
+	
+	Metrics::add (Metrics::WebSocketFramesSent);
 }
 
 QByteArray Nuria::Internal::WebSocketWriter::createClosePayload (int code, const QByteArray &message) {
@@ -16,6 +16,8 @@
 
 #include "nuria/restfulhttpnode.hpp"
 
+#include "private/jsonstreamwriter.hpp"
+#include "private/restfulrouter.hpp"
 #include <nuria/serializer.hpp>
 #include <nuria/bitutils.hpp>
 #include <nuria/callback.hpp>
@@ -26,19 +28,56 @@
 
 enum { NumberOfHandlers = 5 };
 
-struct InvokeInfo {
-	Nuria::Callback callback;
-	QStringList argNames;
-	bool waitForRequestBody;
-};
-
 namespace Nuria {
 
 namespace Internal {
+struct RestfulHttpNodeArgument {
+	int type;
+	QString name; // Empty for the HttpClient
+	int capture; // Index in RestfulHttpNodeSlotData::captures, or -1
+};
+
+// Arguments are resolved on registration, so invoking only has to fetch
+// the captured values.
+struct RestfulHttpNodeInvokeInfo {
+	Callback callback;
+	QVector< RestfulHttpNodeArgument > arguments;
+	bool waitForRequestBody;
+};
+
 struct RestfulHttpNodeSlotData {
+	QString pattern; // Compiled pattern, longer ones take precedence
+	
+	// Routes not representable by the RestfulRouter use a regex
+	bool routed = false;
+	RestfulRouter::Captures captures;
 	QRegularExpression path;
-	InvokeInfo handlers[NumberOfHandlers];
+	
+	RestfulHttpNodeInvokeInfo handlers[NumberOfHandlers];
+};
+
+struct RestfulHttpNodeMatch {
+	RestfulHttpNodeSlotData *data;
+	
+	// Routed
+	const QStringList *parts;
+	int index;
+	
+	// Not routed
+	QRegularExpressionMatch regex;
+	
+	QString captured (const RestfulHttpNodeArgument &argument) const {
+		if (!this->data->routed) {
+			return this->regex.captured (argument.name);
+		} else if (argument.capture == -1) {
+			return QString ();
+		}
+		
+		return RestfulRouter::captured (this->data->captures.at (argument.capture), *this->parts, this->index);
+	}
+	
 };
+
 }
 
 class RestfulHttpNodePrivate {
@@ -47,8 +86,15 @@ public:
 	bool loaded = false;
 	MetaObject *metaObject = nullptr;
 	void *object = nullptr;
+	bool streamJson = false;
 	
-	QMap< QString, Internal::RestfulHttpNodeSlotData > methods;
+	QVector< Internal::RestfulHttpNodeSlotData > methods;
+	QHash< QString, int > methodByPattern;
+	
+	// Routes are matched by the router, or by their regex if it can't
+	// represent them.
+	Internal::RestfulRouter router;
+	QMap< QString, int > regexMethods;
 	
 };
 
@@ -81,18 +127,28 @@ void Nuria::RestfulHttpNode::setRestfulHandler (Nuria::HttpClient::HttpVerbs ver
 	QString compiled = compilePathRegEx (path);
 	
 	// Find control structure
-	auto it = this->d_ptr->methods.find (compiled);
-	if (it == this->d_ptr->methods.end ()) {
+	int idx = this->d_ptr->methodByPattern.value (compiled, -1);
+	if (idx == -1) {
 		Internal::RestfulHttpNodeSlotData data;
-		data.path.setPattern (compiled);
+		idx = this->d_ptr->methods.length ();
+		data.pattern = compiled;
+		data.routed = this->d_ptr->router.insert (path, idx, data.captures);
+		
+		if (!data.routed) {
+			data.path.setPattern (compiled);
+			this->d_ptr->regexMethods.insert (compiled, idx);
+		}
 		
-		it = this->d_ptr->methods.insert (compiled, data);
+		this->d_ptr->methods.append (data);
+		this->d_ptr->methodByPattern.insert (compiled, idx);
 	}
 	
+	Internal::RestfulHttpNodeSlotData *it = &this->d_ptr->methods[idx];
+	
 	// Prepare
-	InvokeInfo info;
+	Internal::RestfulHttpNodeInvokeInfo info;
 	info.callback = callback;
-	info.argNames = argumentNames;
+	info.arguments = resolveArguments (*it, argumentNames, callback.argumentTypes ());
 	info.waitForRequestBody = waitForRequestPostBody;
 	
 	// Store
@@ -109,6 +165,14 @@ void Nuria::RestfulHttpNode::setRestfulHandler (const QString &path, const QStri
 	setRestfulHandler (HttpClient::AllVerbs, path, argumentNames, callback, waitForRequestPostBody);
 }
 
+bool Nuria::RestfulHttpNode::streamJsonResponses () const {
+	return this->d_ptr->streamJson;
+}
+
+void Nuria::RestfulHttpNode::setStreamJsonResponses (bool enable) {
+	this->d_ptr->streamJson = enable;
+}
+
 QVariant Nuria::RestfulHttpNode::serializeVariant (const QVariant &variant) {
 	int type = variant.userType ();
 	
@@ -143,13 +207,28 @@ QVariant Nuria::RestfulHttpNode::serializeVariant (const QVariant &variant) {
 }
 
 QVariant Nuria::RestfulHttpNode::convertArgumentToVariant (const QString &argumentData, int targetType) {
-	QVariant variant = argumentData;
+	bool ok; // Failed conversions yield the default value like QVariant::convert()
 	
-	if (targetType == QMetaType::QVariant) {
-		return variant;
+	// Common types are parsed directly
+	switch (targetType) {
+	case QMetaType::QVariant:
+	case QMetaType::QString:
+		return argumentData;
+	case QMetaType::QByteArray:
+		return argumentData.toUtf8 ();
+	case QMetaType::Int:
+		return int (argumentData.toLongLong (&ok));
+	case QMetaType::LongLong:
+		return argumentData.toLongLong (&ok);
+	case QMetaType::Double:
+		return argumentData.toDouble (&ok);
+	case QMetaType::Bool:
+		return !(argumentData.isEmpty () || argumentData == QLatin1String ("0") ||
+		         argumentData.compare (QLatin1String ("false"), Qt::CaseInsensitive) == 0);
 	}
 	
 	// 
+	QVariant variant = argumentData;
 	variant.convert (targetType);
 	return variant;
 }
@@ -176,7 +255,8 @@ QByteArray Nuria::RestfulHttpNode::generateResultData (const QVariant &result, N
 	return sendVariantAsJson (serializeVariant (result), client);
 }
 
-static InvokeInfo &findInvokeInfo (Nuria::Internal::RestfulHttpNodeSlotData &data, Nuria::HttpClient *client) {
+static Nuria::Internal::RestfulHttpNodeInvokeInfo &findInvokeInfo (Nuria::Internal::RestfulHttpNodeSlotData &data,
+                                                                    Nuria::HttpClient *client) {
 	int verbIdx = Nuria::ffs (int (client->verb ())) - 1;
 	return data.handlers[verbIdx % NumberOfHandlers];
 }
@@ -192,23 +272,54 @@ bool Nuria::RestfulHttpNode::invokePath (const QString &path, const QStringList
 		return false;
 	}
 	
-	// 
-	QString interestingPart = QStringList (parts.mid (index)).join (QLatin1Char ('/'));
-	
-	// Reverse walk over the QMap, so we first check longer paths.
-	auto it = this->d_ptr->methods.end ();
-	auto end = this->d_ptr->methods.begin ();
-	do {
-		it--;
-		Internal::RestfulHttpNodeSlotData &cur = *it;
-		QRegularExpressionMatch match = cur.path.match (interestingPart);
-		if (match.hasMatch ()) {
-			return invokeMatch (cur, match, client);
+	// Of all matching routes, the one with the greatest pattern wins.
+	Internal::RestfulHttpNodeMatch match;
+	match.data = nullptr;
+	match.parts = &parts;
+	match.index = index;
+	
+	Internal::RestfulRouter::Matches candidates;
+	this->d_ptr->router.match (parts, index, candidates);
+	for (int idx : candidates) {
+		Internal::RestfulHttpNodeSlotData *cur = &this->d_ptr->methods[idx];
+		if (!match.data || match.data->pattern < cur->pattern) {
+			match.data = cur;
+		}
+		
+	}
+	
+	// Reverse walk over the regex routes, so we first check longer paths.
+	// Only those taking precedence over the routed match are tried.
+	auto it = this->d_ptr->regexMethods.constEnd ();
+	auto end = this->d_ptr->regexMethods.constBegin ();
+	QString interestingPart;
+	
+	while (it != end) {
+		--it;
+		if (match.data && it.key () < match.data->pattern) {
+			break;
 		}
 		
-	} while (it != end);
+		// 
+		if (interestingPart.isNull ()) {
+			interestingPart = QStringList (parts.mid (index)).join (QLatin1Char ('/'));
+		}
+		
+		Internal::RestfulHttpNodeSlotData &cur = this->d_ptr->methods[*it];
+		QRegularExpressionMatch regexMatch = cur.path.match (interestingPart);
+		if (regexMatch.hasMatch ()) {
+			match.data = &cur;
+			match.regex = regexMatch;
+			break;
+		}
+		
+	}
 	
 	// 
+	if (match.data) {
+		return invokeMatch (*match.data, match, client);
+	}
+	
 	return HttpNode::invokePath (path, parts, index, client);
 	
 }
@@ -360,15 +471,14 @@ bool Nuria::RestfulHttpNode::invokeMatchNow (Callback callback, const QVariantLi
 }
 
 bool Nuria::RestfulHttpNode::invokeMatch (Internal::RestfulHttpNodeSlotData &slotData,
-					  QRegularExpressionMatch &match, HttpClient *client) {
-	InvokeInfo &info = findInvokeInfo (slotData, client);
+					  Internal::RestfulHttpNodeMatch &match, HttpClient *client) {
+	Internal::RestfulHttpNodeInvokeInfo &info = findInvokeInfo (slotData, client);
 	
 	// Prepare arguments
-	QList< int > types = info.callback.argumentTypes ();
-	QVariantList arguments = argumentValues (info.argNames, types, match, client);
+	QVariantList arguments = argumentValues (info, match, client);
 	
 	// Sanity check
-	if (types.length () != arguments.length ()) {
+	if (info.arguments.length () != arguments.length ()) {
 		return false;
 	}
 	
@@ -382,24 +492,53 @@ bool Nuria::RestfulHttpNode::invokeMatch (Internal::RestfulHttpNodeSlotData &slo
 	return invokeMatchNow (info.callback, arguments, client);
 }
 
-QVariantList Nuria::RestfulHttpNode::argumentValues (const QStringList &names, const QList< int > &types,
-						     QRegularExpressionMatch &match, HttpClient *client) {
+QVector< Nuria::Internal::RestfulHttpNodeArgument >
+Nuria::RestfulHttpNode::resolveArguments (const Internal::RestfulHttpNodeSlotData &slotData,
+                                          const QStringList &names, const QList< int > &types) {
+	QVector< Internal::RestfulHttpNodeArgument > arguments;
+	arguments.reserve (types.length ());
+	
+	int nameIdx = 0;
+	for (int type : types) {
+		Internal::RestfulHttpNodeArgument argument = { type, QString (), -1 };
+		
+		// Names of HttpClient arguments are omitted
+		if (type != qMetaTypeId< HttpClient * > ()) {
+			argument.name = names.value (nameIdx++);
+		}
+		
+		for (int i = 0; i < slotData.captures.length () && !argument.name.isEmpty (); i++) {
+			if (slotData.captures.at (i).name == argument.name) {
+				argument.capture = i;
+				break;
+			}
+			
+		}
+		
+		arguments.append (argument);
+	}
+	
+	return arguments;
+}
+
+QVariantList Nuria::RestfulHttpNode::argumentValues (const Internal::RestfulHttpNodeInvokeInfo &info,
+						     Internal::RestfulHttpNodeMatch &match, HttpClient *client) {
 	QVariantList list;
+	list.reserve (info.arguments.length ());
 	
-	int i;
-	for (i = 0; i < types.length (); i++) {
-		if (types.at (i) == qMetaTypeId< HttpClient * > ()) {
+	for (const Internal::RestfulHttpNodeArgument &argument : info.arguments) {
+		if (argument.type == qMetaTypeId< HttpClient * > ()) {
 			list.append (QVariant::fromValue (client));
 			continue;
 		}
 		
 		// 
-		QString data = match.captured (names.at (i));
+		QString data = match.captured (argument);
 		if (data.isEmpty ()) {
 			return QVariantList ();
 		}
 		
-		QVariant value = convertArgumentToVariant (data, types.at (i));
+		QVariant value = convertArgumentToVariant (data, argument.type);
 		if (!value.isValid ()) {
 			return QVariantList ();
 		}
@@ -415,6 +554,13 @@ bool Nuria::RestfulHttpNode::writeResponse (const QVariant &response, Nuria::Htt
 		return true;
 	}
 	
+	// Stream everything which would end up as JSON
+	int type = response.userType ();
+	if (this->d_ptr->streamJson && type != QMetaType::QByteArray &&
+	    type != QMetaType::QString && type != QMetaType::QJsonDocument) {
+		return streamVariantAsJson (response, client);
+	}
+	
 	// 
 	QByteArray responseData = generateResultData (response, client);
 	if (responseData.isEmpty ()) {
@@ -426,6 +572,15 @@ bool Nuria::RestfulHttpNode::writeResponse (const QVariant &response, Nuria::Htt
 	return true;
 }
 
+bool Nuria::RestfulHttpNode::streamVariantAsJson (const QVariant &variant, HttpClient *client) {
+	Internal::JsonStreamWriter writer (client);
+	writer.setConverter ([this](const QVariant &value) { return serializeVariant (value); });
+	
+	// The header has to be set before the first chunk is written
+	addJsonContentTypeHeaderToResponse (client);
+	return writer.write (variant) && writer.flush ();
+}
+
 void Nuria::RestfulHttpNode::addJsonContentTypeHeaderToResponse (HttpClient *client) {
 	static const QByteArray json = QByteArrayLiteral("application/json");
 	
@@ -18,6 +18,7 @@
 
 #include "private/websocketreader.hpp"
 #include "private/websocketwriter.hpp"
+#include "private/metrics.hpp"
 #include "nuria/httptransport.hpp"
 #include "nuria/stringutils.hpp"
 #include "nuria/httpclient.hpp"
@@ -394,6 +395,8 @@ bool Nuria::WebSocketPrivate::processPacket () {
 }
 
 bool Nuria::WebSocketPrivate::processFrame (Internal::WebSocketFrame frame, QByteArray payload) {
+	Internal::Metrics::add (Internal::Metrics::WebSocketFramesReceived);
+	
 	if (!payload.isEmpty ()) {
 		Internal::WebSocketReader::maskPayload (frame.maskKey, payload);
 	}
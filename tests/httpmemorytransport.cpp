@@ -44,3 +44,14 @@ bool Nuria::HttpMemoryTransport::sendToRemote (HttpClient *client, const QByteAr
 	bytesSent (client, data.length ());
 	return true;
 }
+
+bool Nuria::HttpMemoryTransport::sendToRemote (HttpClient *client, const QVector< QByteArray > &slices) {
+	qint64 length = 0;
+	for (const QByteArray &slice : slices) {
+		this->outData.append (slice);
+		length += slice.length ();
+	}
+	
+	bytesSent (client, length);
+	return true;
+}
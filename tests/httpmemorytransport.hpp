@@ -73,6 +73,7 @@ public slots:
 protected:
 	void close (HttpClient *client);
 	bool sendToRemote (HttpClient *client, const QByteArray &data);
+	bool sendToRemote (HttpClient *client, const QVector< QByteArray > &slices);
 };
 
 }
@@ -0,0 +1,649 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QCoreApplication>
+
+#include <nuria/restfulhttpnode.hpp>
+#include <nuria/fastcgibackend.hpp>
+#include <nuria/httpbackend.hpp>
+#include <nuria/httpclient.hpp>
+#include <nuria/httpserver.hpp>
+#include <nuria/websocket.hpp>
+#include <nuria/httpnode.hpp>
+#include <nuria/callback.hpp>
+#include <QCommandLineParser>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QLocalSocket>
+#include <QLocalServer>
+#include <QTcpSocket>
+#include <QEventLoop>
+#include <QThread>
+#include <QVector>
+#include <QFile>
+#include <algorithm>
+#include <cstdio>
+
+// Load generator for the HttpServer. Starts a server on loopback and drives it
+// with keep-alive clients, one per thread, each sending its next request as
+// soon as the previous response has been read completely.
+// 
+// The "mixed" scenario compares the scheduling policies: Every SlowEvery-th
+// client sends slow long-polling requests which occupy their server thread,
+// the others send short REST calls. Every request uses a new connection, so
+// each one is placed by the policy. Only the short requests are reported.
+
+using namespace Nuria;
+
+enum {
+	IoTimeout = 5000,
+	StaticFileSize = 16 * 1024,
+	ChunkSize = 1024,
+	ChunkCount = 16,
+	GzipBodySize = 32 * 1024,
+	EchoFrameSize = 128,
+	SlowEvery = 4,
+	LongPollTime = 20 // msec
+};
+
+static const char *scenarioNames[] = { "static", "rest", "chunked", "gzip", "fastcgi", "websocket", "mixed" };
+
+enum Scenario { Static, Rest, Chunked, Gzip, FastCgi, WebSocketEcho, Mixed, ScenarioCount };
+
+// Indexed by HttpServer::SchedulingPolicy
+static const char *policyNames[] = { "round-robin", "least-connections", "least-recent-latency",
+                                     "power-of-two-choices" };
+enum { PolicyCount = 4 };
+
+// Buffered, blocking reader on top of a QIODevice.
+class BenchConnection {
+public:
+	
+	virtual ~BenchConnection () {}
+	
+	// (Re-)Opens the connection.
+	virtual bool open () = 0;
+	
+	// Sends a single request and reads the whole response.
+	virtual bool roundTrip () = 0;
+	
+protected:
+	
+	QIODevice *device = nullptr;
+	QByteArray buffer;
+	
+	bool fill () {
+		if (!this->device->bytesAvailable () && !this->device->waitForReadyRead (IoTimeout)) {
+			return false;
+		}
+		
+		this->buffer.append (this->device->readAll ());
+		return true;
+	}
+	
+	bool readLine (QByteArray &line) {
+		int idx;
+		while ((idx = this->buffer.indexOf ("\r\n")) < 0) {
+			if (!fill ()) return false;
+		}
+		
+		line = this->buffer.left (idx);
+		this->buffer.remove (0, idx + 2);
+		return true;
+	}
+	
+	bool readBytes (int count, QByteArray *out = nullptr) {
+		while (this->buffer.length () < count) {
+			if (!fill ()) return false;
+		}
+		
+		if (out) {
+			*out = this->buffer.left (count);
+		}
+		
+		this->buffer.remove (0, count);
+		return true;
+	}
+	
+	bool send (const QByteArray &data) {
+		if (this->device->write (data) != data.length ()) {
+			return false;
+		}
+		
+		while (this->device->bytesToWrite () > 0) {
+			if (!this->device->waitForBytesWritten (IoTimeout)) return false;
+		}
+		
+		return true;
+	}
+	
+};
+
+// HTTP/1.1 keep-alive client. Reconnects when the server closes the connection.
+class HttpConnection : public BenchConnection {
+public:
+	
+	HttpConnection (quint16 port, const QByteArray &request)
+		: port (port), request (request)
+	{ this->device = &this->socket; }
+	
+	bool open () override {
+		this->socket.abort ();
+		this->buffer.clear ();
+		this->socket.connectToHost (QHostAddress::LocalHost, this->port);
+		return this->socket.waitForConnected (IoTimeout);
+	}
+	
+	bool roundTrip () override {
+		if (!send (this->request) || !readResponse (200)) {
+			return false;
+		}
+		
+		return (!this->closeAfterResponse || open ());
+	}
+	
+protected:
+	QTcpSocket socket;
+	quint16 port;
+	QByteArray request;
+	bool closeAfterResponse = false;
+	
+	bool readResponse (int expectedStatus) {
+		QByteArray line;
+		if (!readLine (line) || line.mid (9, 3).toInt () != expectedStatus) {
+			return false;
+		}
+		
+		// Headers
+		qint64 length = 0;
+		bool chunked = false;
+		this->closeAfterResponse = false;
+		while (readLine (line) && !line.isEmpty ()) {
+			int colon = line.indexOf (':');
+			QByteArray name = line.left (colon).trimmed ().toLower ();
+			QByteArray value = line.mid (colon + 1).trimmed ().toLower ();
+			
+			if (name == "content-length") {
+				length = value.toLongLong ();
+			} else if (name == "transfer-encoding") {
+				chunked = (value == "chunked");
+			} else if (name == "connection") {
+				this->closeAfterResponse = (value == "close");
+			}
+			
+		}
+		
+		if (expectedStatus == 101) {
+			return true;
+		}
+		
+		// Body
+		if (!chunked) {
+			return readBytes (length);
+		}
+		
+		while (readLine (line)) {
+			int size = line.toInt (nullptr, 16);
+			if (size == 0) {
+				return readLine (line);
+			}
+			
+			if (!readBytes (size + 2)) {
+				return false;
+			}
+			
+		}
+		
+		return false;
+	}
+	
+};
+
+// WebSocket client which sends masked text frames and waits for the echo.
+class WebSocketConnection : public HttpConnection {
+public:
+	
+	WebSocketConnection (quint16 port)
+		: HttpConnection (port, "GET /websocket HTTP/1.1\r\n"
+		                        "Host: 127.0.0.1\r\n"
+		                        "Upgrade: websocket\r\n"
+		                        "Connection: Upgrade\r\n"
+		                        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+		                        "Sec-WebSocket-Version: 13\r\n\r\n")
+	{
+		static const char mask[4] = { 0x12, 0x34, 0x56, 0x78 };
+		this->payload = QByteArray (EchoFrameSize, 'x');
+		
+		this->frame.append (char (0x81)); // FIN + Text
+		this->frame.append (char (0x80 | 126)); // Masked + 16-Bit length
+		this->frame.append (char (EchoFrameSize >> 8));
+		this->frame.append (char (EchoFrameSize & 0xFF));
+		this->frame.append (mask, 4);
+		
+		for (int i = 0; i < EchoFrameSize; i++) {
+			this->frame.append (char (this->payload.at (i) ^ mask[i % 4]));
+		}
+		
+	}
+	
+	bool open () override {
+		return (HttpConnection::open () && send (this->request) && readResponse (101));
+	}
+	
+	bool roundTrip () override {
+		QByteArray header;
+		QByteArray data;
+		if (!send (this->frame) || !readBytes (2, &header)) {
+			return false;
+		}
+		
+		int length = header.at (1) & 0x7F;
+		if (length == 126) {
+			QByteArray extended;
+			if (!readBytes (2, &extended)) return false;
+			length = (uchar (extended.at (0)) << 8) | uchar (extended.at (1));
+		}
+		
+		return (readBytes (length, &data) && data == this->payload);
+	}
+	
+private:
+	QByteArray payload;
+	QByteArray frame;
+	
+};
+
+// FastCGI web-server side. Keeps the connection open and reuses the request id.
+class FastCgiConnection : public BenchConnection {
+public:
+	
+	FastCgiConnection (const QString &name, const QByteArray &path)
+		: name (name)
+	{
+		this->device = &this->socket;
+		
+		static const char beginRequest[] = { 0, 1, 1, 0, 0, 0, 0, 0 }; // Responder, keep connection
+		QByteArray params;
+		appendPair (params, "REQUEST_METHOD", "GET");
+		appendPair (params, "REQUEST_URI", path);
+		appendPair (params, "SERVER_PROTOCOL", "HTTP/1.1");
+		appendPair (params, "REMOTE_ADDR", "127.0.0.1");
+		appendPair (params, "HTTP_HOST", "127.0.0.1");
+		
+		appendRecord (1, QByteArray (beginRequest, sizeof(beginRequest)));
+		appendRecord (4, params); // Params
+		appendRecord (4, QByteArray ()); // End of Params
+		appendRecord (5, QByteArray ()); // End of StdIn
+		
+	}
+	
+	bool open () override {
+		this->socket.abort ();
+		this->buffer.clear ();
+		this->socket.connectToServer (this->name);
+		return this->socket.waitForConnected (IoTimeout);
+	}
+	
+	bool roundTrip () override {
+		enum { StdOut = 6, EndRequest = 3 };
+		
+		if (!send (this->request)) {
+			return false;
+		}
+		
+		// Read records until END_REQUEST
+		QByteArray stdOut;
+		QByteArray header;
+		QByteArray content;
+		while (readBytes (8, &header)) {
+			int type = header.at (1);
+			int length = (uchar (header.at (4)) << 8) | uchar (header.at (5));
+			int padding = uchar (header.at (6));
+			
+			if (!readBytes (length + padding, &content)) {
+				return false;
+			}
+			
+			if (type == StdOut) {
+				stdOut.append (content.constData (), length);
+			} else if (type == EndRequest) {
+				return stdOut.startsWith ("Status: 200");
+			}
+			
+		}
+		
+		return false;
+	}
+	
+private:
+	QLocalSocket socket;
+	QString name;
+	QByteArray request;
+	
+	static void appendLength (QByteArray &data, int length) {
+		if (length < 128) {
+			data.append (char (length));
+		} else {
+			data.append (char ((length >> 24) | 0x80));
+			data.append (char (length >> 16));
+			data.append (char (length >> 8));
+			data.append (char (length));
+		}
+		
+	}
+	
+	static void appendPair (QByteArray &data, const QByteArray &name, const QByteArray &value) {
+		appendLength (data, name.length ());
+		appendLength (data, value.length ());
+		data.append (name);
+		data.append (value);
+	}
+	
+	void appendRecord (int type, const QByteArray &content) {
+		char header[] = { 1, char (type), 0, 1, char (content.length () >> 8),
+		                  char (content.length () & 0xFF), 0, 0 };
+		this->request.append (header, sizeof(header));
+		this->request.append (content);
+	}
+	
+};
+
+// Runs a single connection in its own thread.
+class LoadWorker : public QThread {
+public:
+	
+	Scenario scenario;
+	bool slow = false; // Sends long-polling requests in the mixed scenario
+	quint16 port = 0;
+	QString fastCgiName;
+	qint64 warmupMs = 0;
+	qint64 durationMs = 0;
+	
+	QVector< qint64 > latencies;
+	int errors = 0;
+	
+protected:
+	
+	BenchConnection *createConnection () {
+		static const QByteArray httpTail = " HTTP/1.1\r\nHost: 127.0.0.1\r\n";
+		switch (this->scenario) {
+		case Static:
+			return new HttpConnection (this->port, "GET /static/file.bin" + httpTail + "\r\n");
+		case Rest:
+			return new HttpConnection (this->port, "GET /rest/add/17/25" + httpTail + "\r\n");
+		case Chunked:
+			return new HttpConnection (this->port, "GET /chunked" + httpTail + "\r\n");
+		case Gzip:
+			return new HttpConnection (this->port, "GET /gzip" + httpTail + "Accept-Encoding: gzip\r\n\r\n");
+		case FastCgi:
+			return new FastCgiConnection (this->fastCgiName, "/rest/add/17/25");
+		case Mixed:
+			return new HttpConnection (this->port, (this->slow ? "GET /longpoll" : "GET /rest/add/17/25") +
+			                           httpTail + "Connection: close\r\n\r\n");
+		case WebSocketEcho:
+		case ScenarioCount:
+			break;
+		}
+		
+		return new WebSocketConnection (this->port);
+	}
+	
+	void run () override {
+		QScopedPointer< BenchConnection > connection (createConnection ());
+		QElapsedTimer clock;
+		QElapsedTimer timer;
+		clock.start ();
+		
+		bool connected = connection->open ();
+		while (clock.elapsed () < this->warmupMs + this->durationMs) {
+			if (!connected) {
+				this->errors++;
+				QThread::msleep (10);
+				connected = connection->open ();
+				continue;
+			}
+			
+			// 
+			timer.start ();
+			connected = connection->roundTrip ();
+			qint64 nsecs = timer.nsecsElapsed ();
+			
+			if (clock.elapsed () < this->warmupMs) {
+				continue;
+			} else if (connected) {
+				this->latencies.append (nsecs);
+			} else {
+				this->errors++;
+			}
+			
+		}
+		
+	}
+	
+};
+
+static void setUpServer (HttpServer *server, const QString &staticDir) {
+	HttpNode *root = server->root ();
+	
+	// Static files
+	HttpNode *staticNode = new HttpNode ("static", root);
+	staticNode->setStaticResourceDir (QDir (staticDir));
+	
+	// REST slot
+	RestfulHttpNode *rest = new RestfulHttpNode ("rest", root);
+	rest->setRestfulHandler ("add/{a}/{b}", { "a", "b" }, Callback::fromLambda ([](int a, int b) {
+		return a + b;
+	}));
+	
+	// Chunked streaming
+	root->connectSlot ("chunked", Callback::fromLambda ([](HttpClient *client) {
+		QByteArray chunk (ChunkSize, 'c');
+		for (int i = 0; i < ChunkCount; i++) {
+			client->write (chunk);
+		}
+		
+	}));
+	
+	// Slow long-polling request, which blocks the thread until it's answered
+	root->connectSlot ("longpoll", Callback::fromLambda ([](HttpClient *client) {
+		QThread::msleep (LongPollTime);
+		client->write ("{}");
+	}));
+	
+	// Compressed response
+	root->connectSlot ("gzip", Callback::fromLambda ([](HttpClient *client) {
+		static const QByteArray body = QByteArray ("Lorem ipsum dolor sit amet. ").repeated (GzipBodySize / 28);
+		client->setTransferMode (HttpClient::Buffered);
+		client->addFilter (HttpClient::GzipFilter);
+		client->write (body);
+	}));
+	
+	// WebSocket echo
+	root->connectSlot ("websocket", Callback::fromLambda ([](HttpClient *client) {
+		WebSocket *socket = client->acceptWebSocketConnection ();
+		if (!socket) return;
+		
+		socket->setUseReadBuffer (false);
+		QObject::connect (socket, &WebSocket::frameReceived, [socket](WebSocket::FrameType t, const QByteArray &data) {
+			socket->sendFrame (t, data);
+		});
+		
+	}));
+	
+}
+
+static double percentile (const QVector< qint64 > &sorted, double p) {
+	if (sorted.isEmpty ()) {
+		return 0;
+	}
+	
+	int idx = std::min (sorted.length () - 1, int (p * sorted.length ()));
+	return sorted.at (idx) / 1000.;
+}
+
+static void runScenario (Scenario scenario, const QByteArray &label, int connections, quint16 port,
+                         const QString &fastCgiName, qint64 warmupMs, qint64 durationMs) {
+	QVector< LoadWorker * > workers;
+	QEventLoop loop;
+	int running = connections;
+	
+	for (int i = 0; i < connections; i++) {
+		LoadWorker *worker = new LoadWorker;
+		worker->scenario = scenario;
+		worker->slow = (scenario == Mixed && i % SlowEvery == 0);
+		worker->port = port;
+		worker->fastCgiName = fastCgiName;
+		worker->warmupMs = warmupMs;
+		worker->durationMs = durationMs;
+		workers.append (worker);
+		
+		QObject::connect (worker, &QThread::finished, &loop, [&]() { if (--running == 0) loop.quit (); });
+		worker->start ();
+	}
+	
+	// The server lives in this thread, so keep its event loop running.
+	loop.exec ();
+	
+	// Merge results
+	QVector< qint64 > latencies;
+	int errors = 0;
+	for (LoadWorker *worker : workers) {
+		if (!worker->slow) {
+			latencies += worker->latencies;
+		}
+		
+		errors += worker->errors;
+	}
+	
+	qDeleteAll (workers);
+	std::sort (latencies.begin (), latencies.end ());
+	
+	double rate = latencies.length () * 1000. / durationMs;
+	printf ("%-27s %12.0f req/s  p50 %9.1f us  p99 %9.1f us  p999 %9.1f us  errors %d\n",
+	        label.constData (), rate, percentile (latencies, 0.5), percentile (latencies, 0.99),
+	        percentile (latencies, 0.999), errors);
+	fflush (stdout);
+}
+
+int main (int argc, char *argv[]) {
+	QCoreApplication a (argc, argv);
+	
+	QCommandLineParser parser;
+	parser.setApplicationDescription ("Throughput and latency benchmark of the NuriaProject HttpServer.");
+	parser.addHelpOption ();
+	parser.addOption (QCommandLineOption (QStringList { "c", "connections" },
+	                                      "Concurrent client connections.", "count", "8"));
+	parser.addOption (QCommandLineOption (QStringList { "t", "threads" },
+	                                      "Server threads, -1 for one per core.", "count", "-1"));
+	parser.addOption (QCommandLineOption (QStringList { "d", "duration" },
+	                                      "Measured seconds per scenario.", "seconds", "5"));
+	parser.addOption (QCommandLineOption (QStringList { "w", "warmup" },
+	                                      "Unmeasured seconds per scenario.", "seconds", "1"));
+	parser.addOption (QCommandLineOption (QStringList { "p", "policy" },
+	                                      "Scheduling policy: round-robin, least-connections, "
+	                                      "least-recent-latency or power-of-two-choices. The mixed "
+	                                      "scenario runs with each policy if none is given.", "name"));
+	parser.addPositionalArgument ("scenarios", "static, rest, chunked, gzip, fastcgi, websocket, mixed "
+	                                           "(Default: all)");
+	parser.process (a);
+	
+	int connections = std::max (1, parser.value ("connections").toInt ());
+	qint64 durationMs = std::max (1, parser.value ("duration").toInt ()) * 1000;
+	qint64 warmupMs = std::max (0, parser.value ("warmup").toInt ()) * 1000;
+	
+	// Scenarios to run
+	QVector< Scenario > scenarios;
+	QStringList names = parser.positionalArguments ();
+	for (int i = 0; i < ScenarioCount; i++) {
+		if (names.isEmpty () || names.contains (scenarioNames[i])) {
+			scenarios.append (Scenario (i));
+		}
+		
+	}
+	
+	// Scheduling policies
+	QString policyName = parser.value ("policy");
+	QVector< HttpServer::SchedulingPolicy > policies;
+	for (int i = 0; i < PolicyCount; i++) {
+		if (policyName.isEmpty () || policyName == policyNames[i]) {
+			policies.append (HttpServer::SchedulingPolicy (i));
+		}
+		
+	}
+	
+	if (policies.isEmpty ()) {
+		fprintf (stderr, "Unknown scheduling policy %s\n", qPrintable(policyName));
+		return 1;
+	}
+	
+	// Static file
+	QTemporaryDir staticDir;
+	QFile file (staticDir.path () + "/file.bin");
+	if (!file.open (QIODevice::WriteOnly) || file.write (QByteArray (StaticFileSize, 's')) != StaticFileSize) {
+		fprintf (stderr, "Failed to create the static file in %s\n", qPrintable(staticDir.path ()));
+		return 1;
+	}
+	
+	file.close ();
+	
+	// Server
+	HttpServer server;
+	server.setMaxThreads (parser.value ("threads").toInt ());
+	setUpServer (&server, staticDir.path ());
+	
+	if (!policyName.isEmpty ()) {
+		server.setSchedulingPolicy (policies.first ());
+	}
+
+	
+	if (!server.listen (QHostAddress::LocalHost, 0)) {
+		fprintf (stderr, "Failed to listen on localhost\n");
+		return 1;
+	}
+	
+	QString fastCgiName = QStringLiteral("nuria-loadbench-%1").arg (a.applicationPid ());
+	FastCgiBackend fastCgi (&server);
+	QLocalServer::removeServer (fastCgiName);
+	if (!fastCgi.listenLocal (fastCgiName)) {
+		fprintf (stderr, "Failed to listen on local socket %s\n", qPrintable(fastCgiName));
+		return 1;
+	}
+	
+	// 
+	quint16 port = server.backends ().first ()->port ();
+	HttpServer::SchedulingPolicy defaultPolicy = server.schedulingPolicy ();
+	printf ("# %d connections, %d server threads, %llis per scenario, %s scheduling\n",
+	        connections, server.maxThreads (), durationMs / 1000, policyNames[defaultPolicy]);
+	
+	for (Scenario scenario : scenarios) {
+		if (scenario != Mixed) {
+			runScenario (scenario, scenarioNames[scenario], connections, port, fastCgiName, warmupMs, durationMs);
+			continue;
+		}
+		
+		// Compare the tail latency of the short requests between policies
+		for (HttpServer::SchedulingPolicy policy : policies) {
+			QByteArray label = QByteArray (scenarioNames[scenario]) + '/' + policyNames[policy];
+			server.setSchedulingPolicy (policy);
+			runScenario (scenario, label, connections, port, fastCgiName, warmupMs, durationMs);
+		}
+		
+		server.setSchedulingPolicy (defaultPolicy);
+	}
+	
+	return 0;
+}
@@ -0,0 +1,350 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QCoreApplication>
+
+#include <nuria/httpurlencodedreader.hpp>
+#include <nuria/httpmultipartreader.hpp>
+#include <nuria/httpparser.hpp>
+#include <nuria/httpwriter.hpp>
+#include <nuria/httpserver.hpp>
+#include <nuria/httpclient.hpp>
+#include <nuria/httpnode.hpp>
+#include <nuria/callback.hpp>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDateTime>
+#include <QBuffer>
+#include <QFile>
+#include <cstdio>
+
+#include "private/websocketreader.hpp"
+#include "private/fastcgireader.hpp"
+#include "../httpmemorytransport.hpp"
+
+// Micro-benchmarks of the protocol readers and writers. Results are written as
+// JSON in the format of Google Benchmark, so its tooling can compare runs.
+
+using namespace Nuria::Internal;
+using namespace Nuria;
+
+// Keeps the compiler from optimizing benchmarked calls away.
+static volatile qint64 g_sink = 0;
+
+class MicroBenchmark {
+public:
+	
+	qint64 minTimeNs = 500 * 1000 * 1000;
+	QString filter;
+	QJsonArray results;
+	
+	// Runs \a func repeatedly. \a bytes is the amount of data processed
+	// per iteration, or 0.
+	template< typename Func >
+	void run (const QString &name, qint64 bytes, Func func) {
+		if (!this->filter.isEmpty () && !name.contains (this->filter)) {
+			return;
+		}
+		
+		// Double the iterations until the minimum time is reached
+		qint64 iterations = 1;
+		qint64 elapsed = 0;
+		QElapsedTimer timer;
+		
+		forever {
+			timer.start ();
+			for (qint64 i = 0; i < iterations; i++) {
+				func ();
+			}
+			
+			elapsed = timer.nsecsElapsed ();
+			if (elapsed >= this->minTimeNs || iterations >= (Q_INT64_C(1) << 40)) {
+				break;
+			}
+			
+			iterations *= 2;
+		}
+		
+		// 
+		double perIteration = double (elapsed) / iterations;
+		QJsonObject result {
+			{ "name", name },
+			{ "iterations", iterations },
+			{ "real_time", perIteration },
+			{ "cpu_time", perIteration },
+			{ "time_unit", "ns" }
+		};
+		
+		if (bytes > 0) {
+			result.insert ("bytes_per_second", bytes * 1e9 / perIteration);
+		}
+		
+		this->results.append (result);
+		fprintf (stderr, "%-40s %12.1f ns %14lli iterations\n", qPrintable(name), perIteration, iterations);
+	}
+	
+};
+
+static void benchmarkParser (MicroBenchmark &bench) {
+	static const QByteArray firstLine = "GET /api/v1/users/12345/profile?fields=name,email HTTP/1.1";
+	static const QByteArray headerLine = "Accept-Language: en-US,en;q=0.8,de;q=0.6";
+	static const QByteArray header = "GET /api/v1/users/12345/profile HTTP/1.1\r\n"
+	                                 "Host: www.example.com\r\n"
+	                                 "User-Agent: Mozilla/5.0 (X11; Linux x86_64) Gecko/20100101 Firefox/38.0\r\n"
+	                                 "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+	                                 "Accept-Language: en-US,en;q=0.8,de;q=0.6\r\n"
+	                                 "Accept-Encoding: gzip, deflate\r\n"
+	                                 "Cookie: session=0123456789abcdef; theme=dark\r\n"
+	                                 "Connection: keep-alive\r\n"
+	                                 "Cache-Control: max-age=0\r\n\r\n";
+	HttpParser parser;
+	
+	bench.run ("HttpParser/parseFirstLineFull", firstLine.length (), [&]() {
+		HttpClient::HttpVerb verb;
+		HttpClient::HttpVersion version;
+		QByteArray path;
+		g_sink += parser.parseFirstLineFull (firstLine, verb, path, version);
+	});
+	
+	bench.run ("HttpParser/parseHeaderLine", headerLine.length (), [&]() {
+		QByteArray name;
+		QByteArray value;
+		g_sink += parser.parseHeaderLine (headerLine, name, value);
+	});
+	
+	bench.run ("HttpParser/parseRequestHeader", header.length (), [&]() {
+		HttpParser::RequestState state;
+		g_sink += parser.parseRequestHeader (header, state);
+	});
+	
+}
+
+static void benchmarkWriter (MicroBenchmark &bench) {
+	HttpClient::HeaderMap headers;
+	headers.insert ("Content-Type", "text/html; charset=utf-8");
+	headers.insert ("Content-Length", "1337");
+	headers.insert ("Date", "Sun, 06 Nov 1994 08:49:37 GMT");
+	headers.insert ("Server", "NuriaProject");
+	headers.insert ("Cache-Control", "no-cache, no-store, must-revalidate");
+	headers.insert ("Connection", "keep-alive");
+	headers.insert ("Vary", "Accept-Encoding");
+	headers.insert ("X-Frame-Options", "SAMEORIGIN");
+	
+	HttpClient::Cookies cookies;
+	QNetworkCookie session ("session", "0123456789abcdef");
+	session.setPath ("/");
+	session.setHttpOnly (true);
+	cookies.insert ("session", session);
+	cookies.insert ("theme", QNetworkCookie ("theme", "dark"));
+	
+	HttpWriter writer;
+	QDateTime date = QDateTime::currentDateTimeUtc ();
+	
+	bench.run ("HttpWriter/writeHttpHeaders", 0, [&]() {
+		g_sink += writer.writeHttpHeaders (headers).length ();
+	});
+	
+	bench.run ("HttpWriter/writeSetCookies", 0, [&]() {
+		g_sink += writer.writeSetCookies (cookies).length ();
+	});
+	
+	bench.run ("HttpWriter/dateTimeToHttpDateHeader", 0, [&]() {
+		g_sink += writer.dateTimeToHttpDateHeader (date).length ();
+	});
+	
+	bench.run ("HttpWriter/addComplianceHeaders", 0, [&]() {
+		HttpClient::HeaderMap copy = headers;
+		writer.addComplianceHeaders (HttpClient::Http1_1, copy);
+		g_sink += copy.size ();
+	});
+	
+}
+
+static void benchmarkWebSocket (MicroBenchmark &bench) {
+	static const QByteArray frameHeader ("\x81\xFE\x04\x00\x12\x34\x56\x78", 8); // Masked, 1KiB
+	
+	bench.run ("WebSocketReader/readFrameData", frameHeader.length (), [&]() {
+		WebSocketFrame frame;
+		g_sink += WebSocketReader::readFrameData (frameHeader, frame);
+	});
+	
+	for (int size : { 125, 1024, 65536 }) {
+		QByteArray payload (size, 'x');
+		bench.run (QStringLiteral("WebSocketReader/maskPayload/%1").arg (size), size, [&]() {
+			WebSocketReader::maskPayload (0x12345678, payload);
+			g_sink += payload.at (0);
+		});
+		
+	}
+	
+}
+
+static void appendFastCgiPair (QByteArray &data, const QByteArray &name, const QByteArray &value) {
+	data.append (char (name.length ()));
+	data.append (char (value.length ()));
+	data.append (name);
+	data.append (value);
+}
+
+static void benchmarkFastCgi (MicroBenchmark &bench) {
+	QByteArray record ("\x01\x04\x00\x01\x01\x00\x00\x00", 8);
+	QBuffer buffer (&record);
+	buffer.open (QIODevice::ReadOnly);
+	
+	bench.run ("FastCgiReader/readRecord", record.length (), [&]() {
+		FastCgiRecord result;
+		buffer.seek (0);
+		g_sink += FastCgiReader::readRecord (&buffer, result);
+	});
+	
+	QByteArray params;
+	appendFastCgiPair (params, "REQUEST_METHOD", "GET");
+	appendFastCgiPair (params, "REQUEST_URI", "/api/v1/users/12345/profile");
+	appendFastCgiPair (params, "SERVER_PROTOCOL", "HTTP/1.1");
+	appendFastCgiPair (params, "REMOTE_ADDR", "127.0.0.1");
+	appendFastCgiPair (params, "REMOTE_PORT", "54321");
+	appendFastCgiPair (params, "SERVER_ADDR", "127.0.0.1");
+	appendFastCgiPair (params, "SERVER_PORT", "80");
+	appendFastCgiPair (params, "HTTP_HOST", "www.example.com");
+	appendFastCgiPair (params, "HTTP_ACCEPT_ENCODING", "gzip, deflate");
+	
+	bench.run ("FastCgiReader/readAllNameValuePairs", params.length (), [&]() {
+		NameValueMap values;
+		g_sink += FastCgiReader::readAllNameValuePairs (params, values);
+	});
+	
+}
+
+static void benchmarkPostBodyReaders (MicroBenchmark &bench) {
+	QByteArray multiPart;
+	for (int i = 0; i < 8; i++) {
+		multiPart.append ("--asdasdasd\r\nContent-Disposition: form-data; name=\"field" +
+		                  QByteArray::number (i) + "\"\r\n\r\n" + QByteArray (256, 'v') + "\r\n");
+	}
+	
+	multiPart.append ("--asdasdasd--\r\n");
+	
+	bench.run ("HttpMultiPartReader/eightFields", multiPart.length (), [&]() {
+		QBuffer device;
+		device.setData (multiPart);
+		device.open (QIODevice::ReadOnly);
+		
+		HttpMultiPartReader reader (&device, "asdasdasd");
+		g_sink += reader.isComplete ();
+	});
+	
+	// 
+	QByteArray urlEncoded;
+	for (int i = 0; i < 8; i++) {
+		urlEncoded.append ((i ? "&field" : "field") + QByteArray::number (i) + "=some%20value+" +
+		                   QByteArray (64, 'v'));
+	}
+	
+	bench.run ("HttpUrlEncodedReader/eightFields", urlEncoded.length (), [&]() {
+		QBuffer device;
+		device.setData (urlEncoded);
+		device.open (QIODevice::ReadOnly);
+		
+		HttpUrlEncodedReader reader (&device, "utf-8");
+		g_sink += reader.isComplete ();
+	});
+	
+}
+
+static void benchmarkRequest (MicroBenchmark &bench) {
+	static const QByteArray request = "GET /hello HTTP/1.1\r\n"
+	                                  "Host: www.example.com\r\n"
+	                                  "Accept-Encoding: gzip, deflate\r\n\r\n";
+	HttpServer server;
+	server.root ()->connectSlot ("hello", Callback::fromLambda ([](HttpClient *client) {
+		client->write ("Hello World");
+	}));
+	
+	HttpMemoryTransport transport (&server);
+	
+	bench.run ("HttpClient/requestThroughMemoryTransport", request.length (), [&]() {
+		HttpClient *client = new HttpClient (&transport, &server);
+		transport.process (client, request);
+		g_sink += transport.outData.length ();
+		transport.outData.clear ();
+		delete client;
+	});
+	
+}
+
+// HttpMemoryTransport reports every close() as debug message.
+static void quietMessageHandler (QtMsgType type, const QMessageLogContext &, const QString &msg) {
+	if (type != QtDebugMsg) {
+		fprintf (stderr, "%s\n", qPrintable(msg));
+	}
+	
+}
+
+int main (int argc, char *argv[]) {
+	QCoreApplication a (argc, argv);
+	qInstallMessageHandler (quietMessageHandler);
+	
+	QCommandLineParser parser;
+	parser.setApplicationDescription ("Micro-benchmarks of the NuriaProject Network module.");
+	parser.addHelpOption ();
+	parser.addOption (QCommandLineOption (QStringList { "m", "min-time" },
+	                                      "Minimum milliseconds per benchmark.", "ms", "500"));
+	parser.addOption (QCommandLineOption (QStringList { "f", "filter" },
+	                                      "Only run benchmarks whose name contains this.", "text"));
+	parser.addOption (QCommandLineOption (QStringList { "o", "output" },
+	                                      "Write the JSON results to this file instead of stdout.", "file"));
+	parser.process (a);
+	
+	MicroBenchmark bench;
+	bench.minTimeNs = std::max (1, parser.value ("min-time").toInt ()) * Q_INT64_C(1000000);
+	bench.filter = parser.value ("filter");
+	
+	// 
+	benchmarkParser (bench);
+	benchmarkWriter (bench);
+	benchmarkWebSocket (bench);
+	benchmarkFastCgi (bench);
+	benchmarkPostBodyReaders (bench);
+	benchmarkRequest (bench);
+	
+	// 
+	QJsonObject context {
+		{ "date", QDateTime::currentDateTime ().toString (Qt::ISODate) },
+		{ "executable", a.applicationFilePath () },
+		{ "qt_version", qVersion () },
+		{ "min_time_ms", bench.minTimeNs / 1000000 }
+	};
+	
+	QJsonObject root { { "context", context }, { "benchmarks", bench.results } };
+	QByteArray json = QJsonDocument (root).toJson ();
+	
+	if (!parser.isSet ("output")) {
+		fwrite (json.constData (), 1, json.length (), stdout);
+		return 0;
+	}
+	
+	QFile file (parser.value ("output"));
+	if (!file.open (QIODevice::WriteOnly) || file.write (json) != json.length ()) {
+		fprintf (stderr, "Failed to write %s\n", qPrintable(parser.value ("output")));
+		return 1;
+	}
+	
+	return 0;
+}
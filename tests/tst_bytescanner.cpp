@@ -0,0 +1,146 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QtTest/QtTest>
+#include <QObject>
+
+#include "private/bytescanner.hpp"
+
+using namespace Nuria::Internal;
+
+class ByteScannerTest : public QObject {
+	Q_OBJECT
+private slots:
+	
+	void findByte_data ();
+	void findByte ();
+	
+	void findCrLf_data ();
+	void findCrLf ();
+	
+	void findSubstring_data ();
+	void findSubstring ();
+	
+	void randomizedAgainstIndexOf_data ();
+	void randomizedAgainstIndexOf ();
+	
+private:
+	
+	void addImplementations () {
+		QTest::addColumn< int > ("impl");
+		
+		QTest::newRow ("scalar") << int (ByteScanner::Scalar);
+		QTest::newRow ("sse2") << int (ByteScanner::Sse2);
+		QTest::newRow ("avx2") << int (ByteScanner::Avx2);
+	}
+	
+	ByteScanner::Implementation fetchImplementation (int impl) {
+		if (!ByteScanner::isSupported (ByteScanner::Implementation (impl))) {
+			return ByteScanner::Scalar;
+		}
+		
+		return ByteScanner::Implementation (impl);
+	}
+	
+};
+
+void ByteScannerTest::findByte_data () {
+	addImplementations ();
+}
+
+void ByteScannerTest::findByte () {
+	QFETCH(int, impl);
+	ByteScanner::Implementation i = fetchImplementation (impl);
+	
+	// Long enough to hit the vector loops and the remainder
+	QByteArray data (100, 'a');
+	QCOMPARE(ByteScanner::findByte (data.constData (), data.length (), 'b', i), -1);
+	
+	data[70] = 'b';
+	data[90] = 'b';
+	QCOMPARE(ByteScanner::findByte (data.constData (), data.length (), 'b', i), 70);
+	QCOMPARE(ByteScanner::findByte (data.constData (), 70, 'b', i), -1);
+	QCOMPARE(ByteScanner::findByte (data.constData () + 71, 29, 'b', i), 19);
+	QCOMPARE(ByteScanner::findByte (data.constData (), 0, 'a', i), -1);
+}
+
+void ByteScannerTest::findCrLf_data () {
+	addImplementations ();
+}
+
+void ByteScannerTest::findCrLf () {
+	QFETCH(int, impl);
+	ByteScanner::Implementation i = fetchImplementation (impl);
+	
+	QByteArray data = QByteArray (40, 'x') + "\r\r\n" + QByteArray (40, 'y') + "\r\n";
+	QCOMPARE(ByteScanner::findCrLf (data.constData (), data.length (), i), 41);
+	QCOMPARE(ByteScanner::findCrLf (data.constData (), 42, i), -1);
+	QCOMPARE(ByteScanner::findCrLf (data.constData () + 43, data.length () - 43, i), 40);
+}
+
+void ByteScannerTest::findSubstring_data () {
+	addImplementations ();
+}
+
+void ByteScannerTest::findSubstring () {
+	QFETCH(int, impl);
+	ByteScanner::Implementation i = fetchImplementation (impl);
+	
+	QByteArray needle = "\r\n--boundary";
+	QByteArray data = QByteArray (50, '-') + "\r\n--boundar" + QByteArray (50, '\r') +
+	                  "\r\n--boundary--\r\n";
+	
+	int expected = data.indexOf (needle);
+	QCOMPARE(ByteScanner::findSubstring (data.constData (), data.length (),
+	                                     needle.constData (), needle.length (), i), expected);
+	QCOMPARE(ByteScanner::findSubstring (data.constData (), expected + needle.length () - 1,
+	                                     needle.constData (), needle.length (), i), -1);
+	QCOMPARE(ByteScanner::findSubstring (data.constData (), 5, needle.constData (), 0, i), 0);
+}
+
+void ByteScannerTest::randomizedAgainstIndexOf_data () {
+	addImplementations ();
+}
+
+void ByteScannerTest::randomizedAgainstIndexOf () {
+	static const char alphabet[] = "ab\r\n-";
+	QFETCH(int, impl);
+	ByteScanner::Implementation i = fetchImplementation (impl);
+	
+	qsrand (1);
+	for (int run = 0; run < 2000; run++) {
+		QByteArray data (qrand () % 200, Qt::Uninitialized);
+		QByteArray needle (1 + qrand () % 6, Qt::Uninitialized);
+		
+		for (int j = 0; j < data.length (); j++) {
+			data[j] = alphabet[qrand () % 5];
+		}
+		
+		for (int j = 0; j < needle.length (); j++) {
+			needle[j] = alphabet[qrand () % 5];
+		}
+		
+		// 
+		QCOMPARE(ByteScanner::findSubstring (data.constData (), data.length (),
+		                                     needle.constData (), needle.length (), i),
+		         data.indexOf (needle));
+		QCOMPARE(ByteScanner::findCrLf (data.constData (), data.length (), i), data.indexOf ("\r\n"));
+		QCOMPARE(ByteScanner::findByte (data.constData (), data.length (), '-', i), data.indexOf ('-'));
+	}
+	
+}
+
+QTEST_MAIN(ByteScannerTest)
+#include "tst_bytescanner.moc"
@@ -20,6 +20,7 @@
 #include <QObject>
 
 #include "httpmemorytransport.hpp"
+#include <nuria/httpbodyproducer.hpp>
 #include <nuria/httpfilter.hpp>
 #include <nuria/httpserver.hpp>
 #include <nuria/httpwriter.hpp>
@@ -27,12 +28,40 @@
 
 using namespace Nuria;
 
+// Produces "0123456789" a few times
+class TestProducer : public HttpBodyProducer {
+public:
+	TestProducer (bool wait) : waiting (wait) {}
+	
+	int parts = 3;
+	bool waiting;
+	qint64 maxRequested = 0;
+	
+	bool atEnd () const override
+	{ return parts == 0; }
+	
+	QByteArray produce (HttpClient *, qint64 maxlen) override {
+		maxRequested = qMax (maxRequested, maxlen);
+		if (waiting || parts == 0) {
+			return QByteArray ();
+		}
+		
+		parts--;
+		return "0123456789";
+	}
+	
+	void resume ()
+	{ waiting = false; emit dataAvailable (); }
+	
+};
+
 // HttpNode
 class TestNode : public HttpNode {
 	Q_OBJECT
 public:
 	QBuffer *fromClientBuffer;
 	QByteArray readerClassName;
+	QPointer< TestProducer > producer;
 	
 	TestNode (QObject *parent) : HttpNode (parent) {
 		fromClientBuffer = new QBuffer (this);
@@ -125,6 +154,17 @@ bool TestNode::invokePath (const QString &path, const QStringList &parts,
 		client->write ("abc");
 		client->write ("defg");
 		return true;
+		
+	} else if (path.startsWith ("/static/")) {
+		return sendStaticResource (parts, 1, client);
+		
+	} else if (path.startsWith ("/producer")) {
+		if (path == "/producer/filter") {
+			client->addFilter (new RotFilter (client));
+		}
+		
+		producer = new TestProducer (path == "/producer/wait");
+		return client->streamToClient (producer);
 	}
 	
 	// 
@@ -232,6 +272,10 @@ private slots:
 	void pipeToClientProcess ();
 	void pipeFromClientBuffer ();
 	void pipeFromClientProcess ();
+	void streamToClientStreaming ();
+	void streamToClientChunked ();
+	void streamToClientFiltered ();
+	void streamToClientWaitsForProducer ();
 	void bodyReaderForMultipart ();
 	void bodyReaderForMultipartNoBoundaryGiven ();
 	void bodyReaderForUrlEncoded ();
@@ -243,10 +287,19 @@ private slots:
 	void verifyGzipFilter ();
 	void verifyDeflateFilter ();
 	
+	void staticResourcePrecompressedSibling ();
+	void staticResourcePrecompressedNotAccepted ();
+	void staticResourcePrecompressedGenerated ();
+	void staticResourceCachedHasValidators ();
+	void staticResourceCachedNotModified ();
+	void staticResourceCachedInvalidated ();
+	
 	void verifyClientPath_data ();
 	void verifyClientPath ();
 	
 	void testInvokePath ();
+	void invokeNestedPlainNodes_data ();
+	void invokeNestedPlainNodes ();
 	
 	void redirectClientLocal_data ();
 	void redirectClientLocal ();
@@ -257,6 +310,9 @@ private slots:
 	void genericErrorMessageSentIfNoErrorNodePresent ();
 	void genericErrorMessageSentIfErrorNodeDidntServe ();
 	
+	void phaseTimingDisabledByDefault ();
+	void phaseTimingRecordsPhases ();
+	
 private:
 	
 	HttpClient *createClient (const QByteArray &request) {
@@ -272,8 +328,14 @@ private:
 		return qobject_cast< HttpMemoryTransport * > (client->transport ());
 	}
 	
+	QByteArray responseBody (const QByteArray &response) {
+		return response.mid (response.indexOf ("\r\n\r\n") + 4);
+	}
+	
 	HttpServer *server = new HttpServer (this);
 	TestNode *node = new TestNode (this);
+	QTemporaryDir staticDir;
+	QTemporaryDir cacheDir;
 	
 };
 
@@ -283,6 +345,17 @@ void HttpClientTest::initTestCase () {
 	
 	server->addBackend (new TestBackend (server, 80, false));
 	server->addBackend (new TestBackend (server, 443, true));
+	
+	// Static resources
+	QFile style (staticDir.path () + "/style.css");
+	QFile styleGz (staticDir.path () + "/style.css.gz");
+	QFile script (staticDir.path () + "/app.js");
+	QVERIFY(style.open (QIODevice::WriteOnly) && style.write ("body {}") > 0);
+	QVERIFY(styleGz.open (QIODevice::WriteOnly) && styleGz.write ("Compressed") > 0);
+	QVERIFY(script.open (QIODevice::WriteOnly) && script.write (QByteArray (1000, 'a')) > 0);
+	
+	node->setStaticResourceDir (QDir (staticDir.path ()));
+	node->setServePrecompressedResources (true);
 }
 
 void HttpClientTest::getHttp10 () {
@@ -550,6 +623,86 @@ void HttpClientTest::pipeFromClientProcess () {
 	QVERIFY(!client->isOpen ());
 }
 
+void HttpClientTest::streamToClientStreaming () {
+	QByteArray input = "GET /producer HTTP/1.0\r\n\r\n";
+	QByteArray expected = "HTTP/1.0 200 OK\r\n"
+	                      "Connection: close\r\n\r\n"
+	                      "012345678901234567890123456789";
+	
+	QTest::ignoreMessage (QtDebugMsg, "close()");
+	HttpClient *client = createClient (input);
+	HttpMemoryTransport *transport = getTransport (client);
+	runEventLoopUntil (client, SIGNAL(aboutToClose()));
+	
+	QCOMPARE(transport->outData, expected);
+	QVERIFY(!client->isOpen ());
+}
+
+void HttpClientTest::streamToClientChunked () {
+	QByteArray input = "GET /producer HTTP/1.0\r\n"
+	                   "Connection: keep-alive\r\n\r\n";
+	QByteArray expected = "HTTP/1.0 200 OK\r\n"
+	                      "Connection: keep-alive\r\n"
+	                      "Transfer-Encoding: chunked\r\n\r\n"
+	                      "a\r\n0123456789\r\n"
+	                      "a\r\n0123456789\r\n"
+	                      "a\r\n0123456789\r\n"
+	                      "0\r\n\r\n";
+	
+	HttpMemoryTransport *transport = new HttpMemoryTransport (server);
+	HttpClient *client = new HttpClient (transport, server);
+	transport->setMaxRequests (2);
+	
+	QTest::ignoreMessage (QtDebugMsg, "close()");
+	transport->process (client, input);
+	runEventLoopUntil (client, SIGNAL(aboutToClose()));
+	
+	QCOMPARE(transport->outData, expected);
+}
+
+void HttpClientTest::streamToClientFiltered () {
+	QByteArray input = "GET /producer/filter HTTP/1.0\r\n\r\n";
+	QByteArray expected = "HTTP/1.0 200 OK\r\n"
+	                      "Connection: close\r\n"
+	                      "Content-Encoding: rot\r\n"
+	                      "Foo: bar\r\n\r\n"
+	                      "begin\r\n"
+	                      "123456789:123456789:123456789:"
+	                      "\r\nend";
+	
+	QTest::ignoreMessage (QtDebugMsg, "close()");
+	HttpClient *client = createClient (input);
+	HttpMemoryTransport *transport = getTransport (client);
+	runEventLoopUntil (client, SIGNAL(aboutToClose()));
+	
+	QCOMPARE(transport->outData, expected);
+}
+
+void HttpClientTest::streamToClientWaitsForProducer () {
+	QByteArray input = "GET /producer/wait HTTP/1.0\r\n\r\n";
+	QByteArray expected = "HTTP/1.0 200 OK\r\n"
+	                      "Connection: close\r\n\r\n"
+	                      "012345678901234567890123456789";
+	
+	HttpClient *client = createClient (input);
+	HttpMemoryTransport *transport = getTransport (client);
+	qApp->processEvents ();
+	
+	// Nothing has been produced yet
+	QVERIFY(this->node->producer);
+	QVERIFY(client->isOpen ());
+	QVERIFY(transport->outData.isEmpty ());
+	
+	// 
+	QTest::ignoreMessage (QtDebugMsg, "close()");
+	this->node->producer->resume ();
+	runEventLoopUntil (client, SIGNAL(aboutToClose()));
+	
+	QCOMPARE(transport->outData, expected);
+	QVERIFY(!client->isOpen ());
+	QVERIFY(this->node->producer->maxRequested > 0);
+}
+
 void HttpClientTest::bodyReaderForMultipart () {
 	QByteArray input = "POST /reader HTTP/1.0\r\n"
 	                   "Content-Type: multipart/form-data; boundary=asdasdasd\r\n"
@@ -684,8 +837,9 @@ void HttpClientTest::verifyGzipFilter () {
 	                           "Connection: close\r\n"
 	                           "Content-Encoding: gzip\r\n\r\n"
 	                           "\x1f\x8b\x08\x00\x00\x00\x00\x00"
-	                           "\x00\xff\xf3\x2b\x2d\xca\x4c\x0c"
+	                           "\x00\xff\xf2\x2b\x2d\xca\x4c\x0c"
 	                           "\x28\xca\xcf\x4a\x4d\x2e\x01\x00"
+	                           "\x00\x00\xff\xff\x03\x00"
 	                           "\x43\xa8\xad\x4e\x0c\x00\x00\x00";
 	QByteArray expected (data, sizeof(data) - 1);
 	
@@ -701,8 +855,9 @@ void HttpClientTest::verifyDeflateFilter () {
 	static const char data[] = "HTTP/1.0 200 OK\r\n"
 	                           "Connection: close\r\n"
 	                           "Content-Encoding: deflate\r\n\r\n"
-	                           "\x78\x9c\xf3\x2b\x2d\xca\x4c\x0c"
+	                           "\x78\x9c\xf2\x2b\x2d\xca\x4c\x0c"
 	                           "\x28\xca\xcf\x4a\x4d\x2e\x01\x00"
+	                           "\x00\x00\xff\xff\x03\x00"
 	                           "\x1f\x00\x04\xd7";
 	QByteArray expected (data, sizeof(data) - 1);
 	
@@ -713,6 +868,120 @@ void HttpClientTest::verifyDeflateFilter () {
 	QCOMPARE(transport->outData, expected);
 }
 
+void HttpClientTest::staticResourcePrecompressedSibling () {
+	QByteArray input = "GET /static/style.css HTTP/1.0\r\n"
+	                   "Accept-Encoding: deflate, gzip\r\n\r\n";
+	
+	QTest::ignoreMessage (QtDebugMsg, "close()");
+	HttpClient *client = createClient (input);
+	HttpMemoryTransport *transport = getTransport (client);
+	
+	QVERIFY(transport->outData.contains ("\r\nContent-Encoding: gzip\r\n"));
+	QVERIFY(transport->outData.contains ("\r\nVary: Accept-Encoding\r\n"));
+	QCOMPARE(responseBody (transport->outData), QByteArray ("Compressed"));
+}
+
+void HttpClientTest::staticResourcePrecompressedNotAccepted () {
+	QByteArray input = "GET /static/style.css HTTP/1.0\r\n"
+	                   "Accept-Encoding: gzip;q=0, *\r\n\r\n";
+	
+	QTest::ignoreMessage (QtDebugMsg, "close()");
+	HttpClient *client = createClient (input);
+	HttpMemoryTransport *transport = getTransport (client);
+	
+	QVERIFY(!transport->outData.contains ("Content-Encoding"));
+	QCOMPARE(responseBody (transport->outData), QByteArray ("body {}"));
+}
+
+void HttpClientTest::staticResourcePrecompressedGenerated () {
+	QByteArray input = "GET /static/app.js HTTP/1.0\r\n"
+	                   "Accept-Encoding: gzip\r\n\r\n";
+	node->setPrecompressedCacheDir (cacheDir.path ());
+	
+	// First request starts the generation
+	QTest::ignoreMessage (QtDebugMsg, "close()");
+	HttpClient *first = createClient (input);
+	QCOMPARE(responseBody (getTransport (first)->outData), QByteArray (1000, 'a'));
+	QVERIFY(QThreadPool::globalInstance ()->waitForDone (5000));
+	
+	// Second one is served from the cache
+	QTest::ignoreMessage (QtDebugMsg, "close()");
+	HttpClient *second = createClient (input);
+	QByteArray output = getTransport (second)->outData;
+	node->setPrecompressedCacheDir (QString ());
+	
+	QVERIFY(output.contains ("\r\nContent-Encoding: gzip\r\n"));
+	QVERIFY(responseBody (output).startsWith ("\x1f\x8b"));
+	QVERIFY(responseBody (output).length () < 1000);
+}
+
+void HttpClientTest::staticResourceCachedHasValidators () {
+	QByteArray input = "GET /static/style.css HTTP/1.0\r\n\r\n";
+	node->setStaticResourceCacheSize (1024 * 1024);
+	
+	QTest::ignoreMessage (QtDebugMsg, "close()");
+	HttpClient *client = createClient (input);
+	QByteArray output = getTransport (client)->outData;
+	node->setStaticResourceCacheSize (0);
+	
+	QVERIFY(output.startsWith ("HTTP/1.0 200 OK\r\n"));
+	QVERIFY(output.contains ("\r\nETag: \""));
+	QVERIFY(output.contains ("\r\nLast-Modified: "));
+	QVERIFY(output.contains ("\r\nContent-Type: text/css\r\n"));
+	QCOMPARE(responseBody (output), QByteArray ("body {}"));
+}
+
+void HttpClientTest::staticResourceCachedNotModified () {
+	node->setStaticResourceCacheSize (1024 * 1024);
+	
+	// Fetch the ETag
+	QTest::ignoreMessage (QtDebugMsg, "close()");
+	HttpClient *first = createClient ("GET /static/style.css HTTP/1.0\r\n\r\n");
+	QByteArray output = getTransport (first)->outData;
+	int begin = output.indexOf ("\r\nETag: ") + 8;
+	QByteArray etag = output.mid (begin, output.indexOf ("\r\n", begin) - begin);
+	QVERIFY(etag.startsWith ('"'));
+	
+	// Request it again
+	QTest::ignoreMessage (QtDebugMsg, "close()");
+	HttpClient *second = createClient ("GET /static/style.css HTTP/1.0\r\n"
+	                                   "If-None-Match: \"foo\", " + etag + "\r\n\r\n");
+	output = getTransport (second)->outData;
+	node->setStaticResourceCacheSize (0);
+	
+	QVERIFY(output.startsWith ("HTTP/1.0 304 "));
+	QVERIFY(output.contains ("\r\nETag: " + etag + "\r\n"));
+	QVERIFY(responseBody (output).isEmpty ());
+}
+
+void HttpClientTest::staticResourceCachedInvalidated () {
+#ifndef Q_OS_LINUX
+	QSKIP("Changes are only noticed right away through inotify");
+#endif
+	
+	QFile file (staticDir.path () + "/changing.txt");
+	QVERIFY(file.open (QIODevice::WriteOnly) && file.write ("Old") == 3);
+	file.close ();
+	
+	node->setStaticResourceCacheSize (1024 * 1024);
+	
+	// Put it into the cache
+	QTest::ignoreMessage (QtDebugMsg, "close()");
+	HttpClient *first = createClient ("GET /static/changing.txt HTTP/1.0\r\n\r\n");
+	QCOMPARE(responseBody (getTransport (first)->outData), QByteArray ("Old"));
+	
+	// Change it and request it again
+	QVERIFY(file.open (QIODevice::WriteOnly | QIODevice::Truncate) && file.write ("Changed") == 7);
+	file.close ();
+	
+	QTest::ignoreMessage (QtDebugMsg, "close()");
+	HttpClient *second = createClient ("GET /static/changing.txt HTTP/1.0\r\n\r\n");
+	QByteArray output = getTransport (second)->outData;
+	node->setStaticResourceCacheSize (0);
+	
+	QCOMPARE(responseBody (output), QByteArray ("Changed"));
+}
+
 void HttpClientTest::verifyClientPath_data () {
 	QTest::addColumn< QString > ("host");
 	QTest::addColumn< bool > ("secure");
@@ -775,6 +1044,42 @@ void HttpClientTest::testInvokePath () {
 	QCOMPARE(client->path ().path (), QString ("/rewritten"));
 }
 
+void HttpClientTest::invokeNestedPlainNodes_data () {
+	QTest::addColumn< QByteArray > ("path");
+	QTest::addColumn< QByteArray > ("body");
+	
+	QTest::newRow ("slot") << QByteArray ("/a/b/slot") << QByteArray ("Slot");
+	QTest::newRow ("empty parts") << QByteArray ("//a///b/slot/") << QByteArray ("Slot");
+	QTest::newRow ("index") << QByteArray ("/a/b") << QByteArray ("Index");
+	QTest::newRow ("utf-8") << QByteArray ("/a/%C3%A4/slot") << QByteArray ("Umlaut");
+}
+
+void HttpClientTest::invokeNestedPlainNodes () {
+	QFETCH(QByteArray, path);
+	QFETCH(QByteArray, body);
+	
+	HttpServer plainServer;
+	HttpNode *a = new HttpNode ("a", plainServer.root ());
+	HttpNode *b = new HttpNode ("x", a);
+	HttpNode *umlaut = new HttpNode (QString::fromUtf8 ("\xC3\xA4"), a);
+	QVERIFY(b->setResourceName ("b"));
+	QCOMPARE(a->findNode ("b"), b);
+	QVERIFY(!a->hasNode ("x"));
+	
+	b->connectSlot ("slot", Callback::fromLambda ([](HttpClient *client) { client->write ("Slot"); }));
+	b->connectSlot ("index", Callback::fromLambda ([](HttpClient *client) { client->write ("Index"); }));
+	umlaut->connectSlot ("slot", Callback::fromLambda ([](HttpClient *client) { client->write ("Umlaut"); }));
+	
+	// 
+	HttpMemoryTransport *transport = new HttpMemoryTransport (&plainServer);
+	HttpClient *client = new HttpClient (transport, &plainServer);
+	transport->setMaxRequests (1);
+	
+	QTest::ignoreMessage (QtDebugMsg, "close()");
+	transport->process (client, "GET " + path + " HTTP/1.0\r\n\r\n");
+	QCOMPARE(responseBody (transport->outData), body);
+}
+
 void HttpClientTest::redirectClientLocal_data () {
 	QTest::addColumn< QString > ("host");
 	QTest::addColumn< int > ("port");
@@ -974,5 +1279,50 @@ void HttpClientTest::genericErrorMessageSentIfErrorNodeDidntServe () {
 	QCOMPARE(clientCode, 0);
 }
 
+void HttpClientTest::phaseTimingDisabledByDefault () {
+	QVERIFY(!this->server->phaseTimingEnabled ());
+	QSignalSpy spy (this->server, SIGNAL(requestTimed(Nuria::HttpRequestTimings)));
+	
+	QTest::ignoreMessage (QtDebugMsg, "close()");
+	HttpClient *client = createClient ("GET /default HTTP/1.0\r\n\r\n");
+	
+	QVERIFY(spy.isEmpty ());
+	QVERIFY(!client->requestTimings ().isReached (HttpRequestTimings::DataReceived));
+}
+
+void HttpClientTest::phaseTimingRecordsPhases () {
+	this->server->setPhaseTimingEnabled (true);
+	
+	HttpRequestTimings timings;
+	connect (this->server, &HttpServer::requestTimed, [&timings](const HttpRequestTimings &t) {
+		timings = t;
+	});
+	
+	QTest::ignoreMessage (QtDebugMsg, "close()");
+	createClient ("GET /gzip HTTP/1.0\r\n\r\n");
+	this->server->setPhaseTimingEnabled (false);
+	disconnect (this->server, &HttpServer::requestTimed, 0, 0);
+	
+	// No body was sent
+	QVERIFY(!timings.isReached (HttpRequestTimings::BodyReceived));
+	QCOMPARE(timings.path, QString ("/gzip"));
+	QCOMPARE(timings.statusCode, 200);
+	QVERIFY(timings.filterTime > 0);
+	
+	// Phases are reached in order
+	HttpRequestTimings::Phase phases[] = {
+		HttpRequestTimings::DataReceived, HttpRequestTimings::HeaderReceived,
+		HttpRequestTimings::RoutingStarted, HttpRequestTimings::RoutingFinished,
+		HttpRequestTimings::Closed
+	};
+	
+	for (int i = 1; i < int (sizeof(phases) / sizeof(*phases)); i++) {
+		QVERIFY(timings.elapsed (phases[i - 1], phases[i]) >= 0);
+	}
+	
+	QVERIFY(timings.elapsed (HttpRequestTimings::RoutingStarted, HttpRequestTimings::HeaderSent) >= 0);
+	QVERIFY(timings.elapsed (HttpRequestTimings::HeaderSent, HttpRequestTimings::Closed) >= 0);
+}
+
 QTEST_MAIN(HttpClientTest)
 #include "tst_httpclient.moc"
@@ -44,6 +44,7 @@ private slots:
 	void fragmentedTransfer ();
 	void bytePerByteTransfer ();
 	void valueStreaming ();
+	void largeBinaryField ();
 	
 private:
 	
@@ -268,5 +269,26 @@ void HttpMultiPartReaderTest::valueStreaming () {
 	
 }
 
+void HttpMultiPartReaderTest::largeBinaryField () {
+	
+	// Lots of newlines and partial boundaries in the content
+	QByteArray value;
+	for (int i = 0; i < 20000; i++) {
+		value.append ((i % 7 == 0) ? "\r\n--asdasd" : "\r\nfoo\r");
+	}
+	
+	QByteArray data = "--asdasdasd\r\n"
+	                  "Content-Disposition: form-data; name=\"file\"\r\n"
+	                  "Content-Type: application/octet-stream\r\n\r\n" +
+	                  value + "\r\n--asdasdasd--\r\n";
+	
+	HttpMultiPartReader reader (createBuffer (data), "asdasdasd");
+	
+	QVERIFY(!reader.hasFailed ());
+	QVERIFY(reader.isComplete ());
+	QCOMPARE(reader.fieldLength ("file"), qint64 (value.length ()));
+	QCOMPARE(reader.fieldValue ("file"), value);
+}
+
 QTEST_MAIN(HttpMultiPartReaderTest)
 #include "tst_httpmultipartreader.moc"
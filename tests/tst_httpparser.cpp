@@ -47,6 +47,10 @@ private slots:
 	void parseRangeHeaderValueBadData_data ();
 	void parseRangeHeaderValueBadData ();
 	
+	void parseHttpDateValue ();
+	void parseHttpDateValueBadData_data ();
+	void parseHttpDateValueBadData ();
+	
 	void correctHeaderKeyCase_data ();
 	void correctHeaderKeyCase ();
 	
@@ -59,6 +63,13 @@ private slots:
 	
 	void parseCookieFails_data ();
 	void parseCookieFails ();
+	
+	void parseRequestHeaderHappyPath ();
+	void parseRequestHeaderSplitAcrossReads ();
+	void parseRequestHeaderSkipsLeadingEmptyLines ();
+	void parseRequestHeaderBadData_data ();
+	void parseRequestHeaderBadData ();
+	void parseRequestHeaderLineTooLong ();
 };
 
 void HttpParserTest::removeTrailingNewline () {
@@ -218,6 +229,36 @@ void HttpParserTest::parseRangeHeaderValueOpenEnd () {
 	QCOMPARE(end, -1);
 }
 
+void HttpParserTest::parseHttpDateValue () {
+	HttpParser parser;
+	QDateTime result;
+	
+	QVERIFY(parser.parseHttpDateValue ("Sun, 06 Nov 1994 08:49:37 GMT", result));
+	QCOMPARE(result, QDateTime (QDate (1994, 11, 6), QTime (8, 49, 37), Qt::UTC));
+}
+
+void HttpParserTest::parseHttpDateValueBadData_data () {
+	QTest::addColumn< QString > ("date");
+	
+	QTest::newRow ("empty") << "";
+	QTest::newRow ("rfc850") << "Sunday, 06-Nov-94 08:49:37 GMT";
+	QTest::newRow ("asctime") << "Sun Nov  6 08:49:37 1994";
+	QTest::newRow ("bad month") << "Sun, 06 Foo 1994 08:49:37 GMT";
+	QTest::newRow ("month offset") << "Sun, 06 anF 1994 08:49:37 GMT";
+	QTest::newRow ("bad day") << "Sun, 32 Nov 1994 08:49:37 GMT";
+	QTest::newRow ("bad time") << "Sun, 06 Nov 1994 25:49:37 GMT";
+	QTest::newRow ("no GMT") << "Sun, 06 Nov 1994 08:49:37 UTC";
+	
+}
+
+void HttpParserTest::parseHttpDateValueBadData () {
+	QFETCH(QString, date);
+	
+	HttpParser parser;
+	QDateTime result;
+	QVERIFY(!parser.parseHttpDateValue (date.toLatin1 (), result));
+}
+
 void HttpParserTest::parseRangeHeaderValueBadData_data () {
 	QTest::addColumn< QString > ("range");
 	
@@ -357,5 +398,85 @@ void HttpParserTest::parseCookieFails () {
 	QVERIFY(!parser.parseCookies (data.toLatin1 (), map));
 }
 
+void HttpParserTest::parseRequestHeaderHappyPath () {
+	HttpParser parser;
+	HttpParser::RequestState state;
+	QByteArray data = "POST /foo/bar HTTP/1.1\r\n"
+	                  "Host: unit.test\r\n"
+	                  "Content-Length:  3 \r\n"
+	                  "\r\n"
+	                  "abc";
+	
+	QCOMPARE(parser.parseRequestHeader (data, state), HttpParser::HeaderComplete);
+	QCOMPARE(state.verb, HttpClient::POST);
+	QCOMPARE(state.version, HttpClient::Http1_1);
+	QCOMPARE(state.path.view (data), QByteArray ("/foo/bar"));
+	QCOMPARE(state.headers.length (), 2);
+	QCOMPARE(state.headers.at (0).name.view (data), QByteArray ("Host"));
+	QCOMPARE(state.headers.at (0).value.view (data), QByteArray ("unit.test"));
+	QCOMPARE(state.headers.at (1).name.view (data), QByteArray ("Content-Length"));
+	QCOMPARE(state.headers.at (1).value.view (data), QByteArray ("3"));
+	QCOMPARE(data.mid (state.offset), QByteArray ("abc"));
+}
+
+void HttpParserTest::parseRequestHeaderSplitAcrossReads () {
+	HttpParser parser;
+	HttpParser::RequestState state;
+	QByteArray request = "GET /index HTTP/1.0\r\nFoo: Bar\r\n\r\n";
+	QByteArray data;
+	
+	// Feed the request byte by byte
+	for (int i = 0; i < request.length () - 1; i++) {
+		data.append (request.at (i));
+		QCOMPARE(parser.parseRequestHeader (data, state), HttpParser::NeedMoreData);
+	}
+	
+	data.append (request.at (request.length () - 1));
+	QCOMPARE(parser.parseRequestHeader (data, state), HttpParser::HeaderComplete);
+	QCOMPARE(state.verb, HttpClient::GET);
+	QCOMPARE(state.path.view (data), QByteArray ("/index"));
+	QCOMPARE(state.headers.length (), 1);
+	QCOMPARE(state.headers.at (0).value.view (data), QByteArray ("Bar"));
+	QCOMPARE(state.offset, data.length ());
+}
+
+void HttpParserTest::parseRequestHeaderSkipsLeadingEmptyLines () {
+	HttpParser parser;
+	HttpParser::RequestState state;
+	QByteArray data = "\r\n\nGET / HTTP/1.0\n\n";
+	
+	QCOMPARE(parser.parseRequestHeader (data, state), HttpParser::HeaderComplete);
+	QCOMPARE(state.path.view (data), QByteArray ("/"));
+	QVERIFY(state.headers.isEmpty ());
+}
+
+void HttpParserTest::parseRequestHeaderBadData_data () {
+	QTest::addColumn< QString > ("data");
+	
+	QTest::newRow ("bad first line") << "GET /\r\n\r\n";
+	QTest::newRow ("bad verb") << "get / HTTP/1.0\r\n\r\n";
+	QTest::newRow ("bad version") << "GET / HTTP/2.0\r\n\r\n";
+	QTest::newRow ("no colon") << "GET / HTTP/1.0\r\nFoo=Bar\r\n\r\n";
+	QTest::newRow ("empty name") << "GET / HTTP/1.0\r\n: Bar\r\n\r\n";
+	QTest::newRow ("empty value") << "GET / HTTP/1.0\r\nFoo: \r\n\r\n";
+}
+
+void HttpParserTest::parseRequestHeaderBadData () {
+	QFETCH(QString, data);
+	
+	HttpParser parser;
+	HttpParser::RequestState state;
+	QCOMPARE(parser.parseRequestHeader (data.toLatin1 (), state), HttpParser::InvalidRequest);
+}
+
+void HttpParserTest::parseRequestHeaderLineTooLong () {
+	HttpParser parser;
+	HttpParser::RequestState state;
+	QByteArray data = "GET / HTTP/1.0\r\nFoo: ";
+	data.append (QByteArray (HttpParser::MaxLineLength, 'a'));
+	
+	QCOMPARE(parser.parseRequestHeader (data, state), HttpParser::InvalidRequest);
+}
+
 QTEST_MAIN(HttpParserTest)
 #include "tst_httpparser.moc"
@@ -0,0 +1,220 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest/QtTest>
+#include <QObject>
+
+#include "private/httpthread.hpp"
+#include <nuria/httpserver.hpp>
+#include <nuria/httpclient.hpp>
+#include <nuria/httpbackend.hpp>
+#include <nuria/httpnode.hpp>
+#include <QTcpSocket>
+#include <QThread>
+#include <QMutex>
+
+using namespace Nuria;
+
+enum {
+	Threads = 2,
+	SlowTime = 20,
+	Timeout = 2000
+};
+
+// Remembers which thread served each request.
+class RecordingNode : public HttpNode {
+	Q_OBJECT
+public:
+	
+	RecordingNode (QObject *parent) : HttpNode (parent) {}
+	
+	bool invokePath (const QString &path, const QStringList &, int, HttpClient *client) {
+		// "/record/<usec>" feeds a latency sample to the thread and keeps
+		// the connection open, so closing it doesn't add another one. The
+		// sample is there before the test sees the request.
+		if (path.startsWith ("/record/")) {
+			Internal::HttpThread *thread = qobject_cast< Internal::HttpThread * > (QThread::currentThread ());
+			thread->recordLatency (path.mid (8).toLongLong ());
+		}
+		
+		QMutexLocker lock (&this->mutex);
+		this->threads.append (QThread::currentThread ());
+		lock.unlock ();
+		
+		if (path == "/hold" || path.startsWith ("/record/")) {
+			client->setKeepConnectionOpen (true);
+			return true;
+		} else if (path == "/slow") {
+			QThread::msleep (SlowTime);
+		}
+		
+		client->write ("Done.");
+		return true;
+	}
+	
+	int requests () {
+		QMutexLocker lock (&this->mutex);
+		return this->threads.length ();
+	}
+	
+	QMutex mutex;
+	QVector< QThread * > threads;
+	
+};
+
+class HttpSchedulingTest : public QObject {
+	Q_OBJECT
+private slots:
+	
+	void init ();
+	void cleanup ();
+	
+	void schedulingPolicyDefault ();
+	void leastConnectionsSpreadsConnections ();
+	void leastRecentLatencyWithoutRecentSamples ();
+	void leastRecentLatencyPrefersLowestLatency ();
+	void powerOfTwoChoicesSpreadsConnections ();
+	
+private:
+	void request (const QByteArray &path);
+	int connectionsOfThread (QThread *thread, int from);
+	
+	HttpServer *server = nullptr;
+	RecordingNode *node = nullptr;
+	quint16 port = 0;
+	QVector< QTcpSocket * > sockets;
+	
+};
+
+void HttpSchedulingTest::init () {
+	this->server = new HttpServer;
+	this->node = new RecordingNode (this->server);
+	this->server->setRoot (this->node);
+	this->server->setMaxThreads (Threads);
+	QVERIFY(this->server->listen (QHostAddress::LocalHost, 0));
+	this->port = this->server->backends ().first ()->port ();
+}
+
+void HttpSchedulingTest::cleanup () {
+	for (QTcpSocket *socket : this->sockets) {
+		socket->abort ();
+	}
+	
+	qDeleteAll (this->sockets);
+	this->sockets.clear ();
+	
+	// Let the threads notice the closed connections
+	QTest::qWait (100);
+	delete this->server;
+	this->server = nullptr;
+}
+
+void HttpSchedulingTest::request (const QByteArray &path) {
+	int expected = this->node->requests () + 1;
+	
+	QTcpSocket *socket = new QTcpSocket;
+	this->sockets.append (socket);
+	socket->connectToHost (QHostAddress::LocalHost, this->port);
+	socket->waitForConnected (Timeout);
+	socket->write ("GET " + path + " HTTP/1.0\r\n\r\n");
+	socket->waitForBytesWritten (Timeout);
+	
+	// Wait for the request to reach the node
+	QTRY_VERIFY_WITH_TIMEOUT(this->node->requests () >= expected, Timeout);
+}
+
+int HttpSchedulingTest::connectionsOfThread (QThread *thread, int from) {
+	QMutexLocker lock (&this->node->mutex);
+	return this->node->threads.mid (from).count (thread);
+}
+
+void HttpSchedulingTest::schedulingPolicyDefault () {
+	QCOMPARE(this->server->schedulingPolicy (), HttpServer::RoundRobin);
+	
+	this->server->setSchedulingPolicy (HttpServer::PowerOfTwoChoices);
+	QCOMPARE(this->server->schedulingPolicy (), HttpServer::PowerOfTwoChoices);
+}
+
+void HttpSchedulingTest::leastConnectionsSpreadsConnections () {
+	this->server->setSchedulingPolicy (HttpServer::LeastConnections);
+	
+	for (int i = 0; i < 2 * Threads; i++) {
+		request ("/hold");
+	}
+	
+	QCOMPARE(this->node->requests (), 2 * Threads);
+	QThread *first = this->node->threads.first ();
+	QCOMPARE(connectionsOfThread (first, 0), Threads);
+}
+
+void HttpSchedulingTest::leastRecentLatencyWithoutRecentSamples () {
+	this->server->setSchedulingPolicy (HttpServer::LeastRecentLatency);
+	
+	// Only one thread has a latency sample now
+	request ("/slow");
+	QVERIFY(this->sockets.last ()->waitForDisconnected (Timeout));
+	QThread *sampled = this->node->threads.first ();
+	
+	// The other thread must not get all new connections just because it
+	// didn't serve any request yet.
+	for (int i = 0; i < 2 * Threads; i++) {
+		request ("/hold");
+	}
+	
+	QCOMPARE(this->node->requests (), 1 + 2 * Threads);
+	QVERIFY(connectionsOfThread (sampled, 1) > 0);
+	QVERIFY(connectionsOfThread (sampled, 1) < 2 * Threads);
+}
+
+void HttpSchedulingTest::leastRecentLatencyPrefersLowestLatency () {
+	this->server->setSchedulingPolicy (HttpServer::LeastRecentLatency);
+	
+	// Without samples, the first connection goes to the first thread and
+	// the second one to the thread without a connection.
+	request ("/record/80000");
+	request ("/record/0");
+	
+	QThread *slow = this->node->threads.at (0);
+	QThread *fast = this->node->threads.at (1);
+	QVERIFY(slow != fast);
+	
+	// Both threads have a recent sample now. The one with the lower latency
+	// is chosen, even once it serves more connections than the other one.
+	request ("/hold");
+	request ("/hold");
+	
+	QCOMPARE(this->node->requests (), 4);
+	QCOMPARE(connectionsOfThread (fast, 2), 2);
+}
+
+void HttpSchedulingTest::powerOfTwoChoicesSpreadsConnections () {
+	this->server->setSchedulingPolicy (HttpServer::PowerOfTwoChoices);
+	
+	// With two threads, both are always picked, so the one serving fewer
+	// connections wins. Only ties are decided at random.
+	for (int i = 0; i < 2 * Threads; i += 2) {
+		request ("/hold");
+		request ("/hold");
+		
+		QMutexLocker lock (&this->node->mutex);
+		QVERIFY(this->node->threads.at (i) != this->node->threads.at (i + 1));
+	}
+	
+	QCOMPARE(this->node->requests (), 2 * Threads);
+}
+
+QTEST_MAIN(HttpSchedulingTest)
+#include "tst_httpscheduling.moc"
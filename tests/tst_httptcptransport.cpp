@@ -36,12 +36,71 @@ public:
 	
 	TestNode (QObject *parent) : HttpNode (parent) {}
 	
-	bool invokePath (const QString &path, const QStringList &, int, HttpClient *client);
+	bool invokePath (const QString &path, const QStringList &parts, int, HttpClient *client);
+	
+	// Used by "/pipe"
+	QByteArray pipeData;
+	QAtomicInt maxPending;
+	
+	// Used by "/static/"
+	QAtomicInt filePos;
+	
 };
 
-bool TestNode::invokePath (const QString &path, const QStringList &, int, HttpClient *client) {
-	if (path == "/get") {
+bool TestNode::invokePath (const QString &path, const QStringList &parts, int, HttpClient *client) {
+	if (path.startsWith ("/static/")) {
+		bool result = sendStaticResource (parts, 1, client);
+		
+		// The file is only read from if the transport didn't take over
+		QFile *file = client->findChild< QFile * > ();
+		this->filePos.store ((file && file->isOpen ()) ? int (file->pos ()) : 0);
+		return result;
+	} else if (path == "/get") {
 		client->write ("Works.");
+	} else if (path == "/client") {
+		client->write (QByteArray::number (quintptr (client)));
+	} else if (path == "/later") {
+		client->setKeepConnectionOpen (true);
+		client->write ("Now.");
+		
+		QTimer *timer = new QTimer (client);
+		timer->setSingleShot (true);
+		timer->start (Timeout / 2);
+		connect (timer, &QTimer::timeout, [client]() {
+			client->write ("Later.");
+			client->close ();
+		});
+		
+	} else if (path == "/pipe") {
+		QBuffer *buffer = new QBuffer;
+		buffer->setData (this->pipeData);
+		buffer->open (QIODevice::ReadOnly);
+		
+		// Record how much data is waiting in the transport
+		connect (client, &QIODevice::bytesWritten, [this, client]() {
+			int pending = int (client->transport ()->bytesToWrite (client));
+			if (pending > this->maxPending.load ()) {
+				this->maxPending.store (pending);
+			}
+			
+		});
+		
+		client->pipeToClient (buffer);
+	} else if (path == "/pipe/close") {
+		QBuffer *buffer = new QBuffer;
+		buffer->setData (this->pipeData);
+		buffer->open (QIODevice::ReadOnly);
+		
+		// Close the device once the client is being throttled
+		connect (client, &QIODevice::bytesWritten, [buffer, client]() {
+			HttpTransport *transport = client->transport ();
+			if (buffer->isOpen () && transport->bytesToWrite (client) > transport->highWaterMark ()) {
+				buffer->close ();
+			}
+			
+		});
+		
+		client->pipeToClient (buffer);
 	} else if (path == "/post") {
 		auto func = [](HttpClient *client) {
 			QByteArray data = client->readAll ();
@@ -66,11 +125,22 @@ private slots:
 	
 	void verifyGetRequest ();
 	void verifyPostRequest ();
+	void verifyWriteOutsideOfRequest ();
+	void verifyLargePostRequest ();
+	void verifyPipelinedRequests ();
 	
 	void testConnectTimeout ();
 	void testDataTimeout ();
 	void testKeepAliveTimeout ();
 	
+	void verifyGetRequestReusePort ();
+	void verifyClientPooling ();
+	
+	void verifyFileTransfer ();
+	void verifyFileTransferRange ();
+	void verifyPipeBackpressure ();
+	void verifyPipeClosedWhileThrottled ();
+	
 private:
 	/*
 	HttpClient *createClient (const QByteArray &request) {
@@ -94,6 +164,18 @@ private:
 	TestNode *node = new TestNode (this);
 	quint16 port = 0;
 	
+	QTemporaryDir staticDir;
+	QByteArray fileData;
+	
+	QByteArray readResponse (QTcpSocket &socket) {
+		QByteArray response;
+		while (socket.waitForReadyRead (Timeout)) {
+			response.append (socket.readAll ());
+		}
+		
+		return response + socket.readAll ();
+	}
+	
 };
 
 void HttpTcpTransportTest::initTestCase () {
@@ -116,6 +198,18 @@ void HttpTcpTransportTest::initTestCase () {
 	this->server->setTimeout (HttpTransport::KeepAliveTimeout, Timeout);
 	this->server->setMinimalBytesReceived (4);
 	
+	// Large static file
+	for (int i = 0; i < 4 * 1024 * 1024; i++) {
+		this->fileData.append (char (i % 251));
+	}
+	
+	QFile file (this->staticDir.path () + "/large.bin");
+	QVERIFY(file.open (QIODevice::WriteOnly));
+	QCOMPARE(file.write (this->fileData), qint64 (this->fileData.length ()));
+	file.close ();
+	this->node->setStaticResourceDir (QDir (this->staticDir.path ()));
+	this->node->pipeData = this->fileData.repeated (4);
+	
 	// 
 	this->thread->start ();
 	this->server->moveToThread (this->thread);
@@ -150,6 +244,58 @@ void HttpTcpTransportTest::verifyPostRequest () {
 	
 }
 
+void HttpTcpTransportTest::verifyWriteOutsideOfRequest () {
+	QTcpSocket socket;
+	socket.connectToHost (QHostAddress::LocalHost, this->port);
+	QVERIFY(socket.waitForConnected (Timeout));
+	socket.write ("GET /later HTTP/1.0\r\n\r\n");
+	
+	// The first part is sent before the client is closed
+	QVERIFY(socket.waitForBytesWritten (Timeout));
+	QVERIFY(socket.waitForReadyRead (Timeout));
+	QCOMPARE(socket.readAll (), QByteArray("HTTP/1.0 200 OK\r\nConnection: close\r\n\r\nNow."));
+	
+	QVERIFY(socket.waitForReadyRead (Timeout));
+	QCOMPARE(socket.readAll (), QByteArray("Later."));
+}
+
+void HttpTcpTransportTest::verifyLargePostRequest () {
+	
+	// Larger than the receive buffer, with a large header
+	QByteArray body = this->fileData.left (100 * 1000);
+	QByteArray request = "POST /post HTTP/1.0\r\n"
+	                     "Content-Length: " + QByteArray::number (body.length ()) + "\r\n";
+	for (int i = 0; i < 8; i++) {
+		request += "X-Padding-" + QByteArray::number (i) + ": " + QByteArray (3000, 'a') + "\r\n";
+	}
+	
+	QTcpSocket socket;
+	socket.connectToHost (QHostAddress::LocalHost, this->port);
+	QVERIFY(socket.waitForConnected (Timeout));
+	socket.write (request + "\r\n" + body);
+	QVERIFY(socket.waitForBytesWritten (Timeout));
+	
+	std::reverse (body.begin (), body.end ());
+	QByteArray response = readResponse (socket);
+	QVERIFY(response.startsWith ("HTTP/1.0 200 OK\r\nConnection: close\r\n\r\n"));
+	QVERIFY(response.mid (response.indexOf ("\r\n\r\n") + 4) == body);
+}
+
+void HttpTcpTransportTest::verifyPipelinedRequests () {
+	QTcpSocket socket;
+	socket.connectToHost (QHostAddress::LocalHost, this->port);
+	QVERIFY(socket.waitForConnected (Timeout));
+	
+	// Both requests arrive at once, the second one is left in the buffer
+	socket.write ("GET /get HTTP/1.1\r\nHost: unit.test\r\nConnection: keep-alive\r\n\r\n"
+	              "GET /get HTTP/1.1\r\nHost: unit.test\r\nConnection: close\r\n\r\n");
+	QVERIFY(socket.waitForBytesWritten (Timeout));
+	
+	QByteArray response = readResponse (socket);
+	QCOMPARE(response.count ("HTTP/1.1 200 OK\r\n"), 2);
+	QCOMPARE(response.count ("Works."), 2);
+}
+
 void HttpTcpTransportTest::testConnectTimeout () {
 	QTcpSocket socket;
 	socket.connectToHost (QHostAddress::LocalHost, this->port);
@@ -210,5 +356,173 @@ void HttpTcpTransportTest::testKeepAliveTimeout () {
 	QCOMPARE(spy.at (0).at (1), QVariant::fromValue (HttpTransport::KeepAliveTimeout));
 }
 
+void HttpTcpTransportTest::verifyGetRequestReusePort () {
+	if (!Internal::TcpServer::reusePortSupported ()) {
+		QSKIP("SO_REUSEPORT is not supported on this platform");
+	}
+	
+	HttpServer reuseServer;
+	reuseServer.setRoot (new TestNode (&reuseServer));
+	reuseServer.setMaxThreads (2);
+	reuseServer.setReusePort (true);
+	QVERIFY(reuseServer.listen (QHostAddress::LocalHost, 0));
+	
+	// Connections are accepted by the server threads, no event loop needed.
+	int reusePort = reuseServer.backends ().first ()->port ();
+	QVERIFY(reusePort > 0);
+	
+	for (int i = 0; i < 4; i++) {
+		QTcpSocket socket;
+		socket.connectToHost (QHostAddress::LocalHost, reusePort);
+		QVERIFY(socket.waitForConnected (Timeout));
+		socket.write ("GET /get HTTP/1.0\r\n\r\n");
+		
+		QVERIFY(socket.waitForBytesWritten (Timeout));
+		QVERIFY(socket.waitForReadyRead (Timeout));
+		QCOMPARE(socket.readAll (), QByteArray("HTTP/1.0 200 OK\r\nConnection: close\r\n\r\nWorks."));
+	}
+	
+}
+
+void HttpTcpTransportTest::verifyClientPooling () {
+	QTcpSocket socket;
+	socket.connectToHost (QHostAddress::LocalHost, this->port);
+	QVERIFY(socket.waitForConnected (Timeout));
+	this->server->setClientPoolingEnabled (true);
+	
+	// The second request on the connection is served by the same instance
+	QList< QByteArray > clients;
+	for (int i = 0; i < 2; i++) {
+		socket.write ("GET /client HTTP/1.1\r\nHost: unit.test\r\nConnection: keep-alive\r\n\r\n");
+		QVERIFY(socket.waitForBytesWritten ());
+		QVERIFY(socket.waitForReadyRead (Timeout));
+		
+		QByteArray response = socket.readAll ();
+		QVERIFY(response.startsWith ("HTTP/1.1 200 OK\r\n"));
+		QVERIFY(response.endsWith ("\r\n0\r\n\r\n"));
+		
+		// Body is a single chunk
+		QList< QByteArray > lines = response.mid (response.indexOf ("\r\n\r\n") + 4).split ('\n');
+		clients.append (lines.value (1).trimmed ());
+	}
+	
+	this->server->setClientPoolingEnabled (false);
+	QVERIFY(!clients.first ().isEmpty ());
+	QCOMPARE(clients.at (0), clients.at (1));
+}
+
+void HttpTcpTransportTest::verifyFileTransfer () {
+	QTcpSocket socket;
+	socket.connectToHost (QHostAddress::LocalHost, this->port);
+	QVERIFY(socket.waitForConnected (Timeout));
+	socket.write ("GET /static/large.bin HTTP/1.0\r\n\r\n");
+	QVERIFY(socket.waitForBytesWritten (Timeout));
+	
+	QByteArray response = readResponse (socket);
+	int headerEnd = response.indexOf ("\r\n\r\n");
+	QVERIFY(headerEnd != -1);
+	
+	QByteArray header = response.left (headerEnd + 2);
+	QVERIFY(header.startsWith ("HTTP/1.0 200 OK\r\n"));
+	QVERIFY(header.contains ("Content-Length: " + QByteArray::number (this->fileData.length ()) + "\r\n"));
+	QVERIFY(response.mid (headerEnd + 4) == this->fileData);
+	
+#ifdef Q_OS_LINUX
+	// Sent using sendfile(), HttpClient didn't read from the file
+	QCOMPARE(this->node->filePos.load (), 0);
+#endif
+}
+
+void HttpTcpTransportTest::verifyFileTransferRange () {
+	QTcpSocket socket;
+	socket.connectToHost (QHostAddress::LocalHost, this->port);
+	QVERIFY(socket.waitForConnected (Timeout));
+	socket.write ("GET /static/large.bin HTTP/1.0\r\nRange: bytes=1000-2999999\r\n\r\n");
+	QVERIFY(socket.waitForBytesWritten (Timeout));
+	
+	QByteArray response = readResponse (socket);
+	int headerEnd = response.indexOf ("\r\n\r\n");
+	QVERIFY(headerEnd != -1);
+	
+	// Body must match the announced length
+	QByteArray header = response.left (headerEnd + 2);
+	int lengthBegin = header.indexOf ("Content-Length: ") + 16;
+	int lengthEnd = header.indexOf ("\r\n", lengthBegin);
+	int length = header.mid (lengthBegin, lengthEnd - lengthBegin).toInt ();
+	
+	QByteArray body = response.mid (headerEnd + 4);
+	QVERIFY(length > 0);
+	QCOMPARE(body.length (), length);
+	QVERIFY(body == this->fileData.mid (1000, length));
+}
+
+void HttpTcpTransportTest::verifyPipeBackpressure () {
+	enum { HighWaterMark = 64 * 1024, LowWaterMark = 16 * 1024, ChunkSize = 16 * 1024 };
+	
+	this->server->setHighWaterMark (HighWaterMark);
+	this->server->setLowWaterMark (LowWaterMark);
+	this->node->maxPending.store (0);
+	
+	// Slow reader with small buffers, so the data piles up in the server
+	QTcpSocket socket;
+	socket.setReadBufferSize (ChunkSize);
+	socket.connectToHost (QHostAddress::LocalHost, this->port);
+	QVERIFY(socket.waitForConnected (Timeout));
+	socket.setSocketOption (QAbstractSocket::ReceiveBufferSizeSocketOption, ChunkSize);
+	socket.write ("GET /pipe HTTP/1.0\r\n\r\n");
+	QVERIFY(socket.waitForBytesWritten (Timeout));
+	
+	QByteArray response;
+	while (socket.waitForReadyRead (Timeout)) {
+		response.append (socket.readAll ());
+		QThread::msleep (1);
+	}
+	
+	response.append (socket.readAll ());
+	this->server->setHighWaterMark (HttpTransport::DefaultHighWaterMark);
+	this->server->setLowWaterMark (HttpTransport::DefaultLowWaterMark);
+	
+	// The whole body arrived
+	int headerEnd = response.indexOf ("\r\n\r\n");
+	QVERIFY(headerEnd != -1);
+	QVERIFY(response.mid (headerEnd + 4) == this->node->pipeData);
+	
+	// The server buffered no more than one chunk above the high mark
+	int maxPending = this->node->maxPending.load ();
+	QVERIFY2(maxPending <= HighWaterMark + 2 * ChunkSize, qPrintable(QString::number (maxPending)));
+}
+
+void HttpTcpTransportTest::verifyPipeClosedWhileThrottled () {
+	enum { HighWaterMark = 64 * 1024, LowWaterMark = 16 * 1024, ChunkSize = 16 * 1024 };
+	
+	this->server->setHighWaterMark (HighWaterMark);
+	this->server->setLowWaterMark (LowWaterMark);
+	
+	// Slow reader, so the server gets throttled before the body is sent
+	QTcpSocket socket;
+	socket.setReadBufferSize (ChunkSize);
+	socket.connectToHost (QHostAddress::LocalHost, this->port);
+	QVERIFY(socket.waitForConnected (Timeout));
+	socket.setSocketOption (QAbstractSocket::ReceiveBufferSizeSocketOption, ChunkSize);
+	socket.write ("GET /pipe/close HTTP/1.0\r\n\r\n");
+	QVERIFY(socket.waitForBytesWritten (Timeout));
+	
+	QByteArray response;
+	while (socket.waitForReadyRead (Timeout)) {
+		response.append (socket.readAll ());
+	}
+	
+	response.append (socket.readAll ());
+	this->server->setHighWaterMark (HttpTransport::DefaultHighWaterMark);
+	this->server->setLowWaterMark (HttpTransport::DefaultLowWaterMark);
+	
+	// The rest of the device was sent when it was closed, and the
+	// connection was closed afterwards.
+	int headerEnd = response.indexOf ("\r\n\r\n");
+	QVERIFY(headerEnd != -1);
+	QVERIFY(response.mid (headerEnd + 4) == this->node->pipeData);
+	QCOMPARE(socket.state (), QAbstractSocket::UnconnectedState);
+}
+
 QTEST_MAIN(HttpTcpTransportTest)
 #include "tst_httptcptransport.moc"
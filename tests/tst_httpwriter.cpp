@@ -29,6 +29,7 @@ private slots:
 	
 	void writeResponseLineDefaultMessage ();
 	void writeResponseLineCustomMessage ();
+	void writeResponseLineUnknownCode ();
 	
 	void writeSetCookieValue_data ();
 	void writeSetCookieValue ();
@@ -37,7 +38,11 @@ private slots:
 	
 	void writeHttpHeaders ();
 	
+	void writeResponseHeader ();
+	void writeResponseHeaderWithFixedHeaders ();
+	
 	void dateTimeToHttpDateHeader ();
+	void currentHttpDate ();
 	
 	void buildRangeHeader ();
 	
@@ -83,6 +88,15 @@ void HttpWriterTest::writeResponseLineCustomMessage () {
 	QCOMPARE(result, QByteArray ("HTTP/1.0 200 Yay\r\n"));
 }
 
+void HttpWriterTest::writeResponseLineUnknownCode () {
+	HttpWriter writer;
+	
+	QCOMPARE(writer.writeResponseLine (HttpClient::Http1_1, 299, QByteArray ()),
+		 QByteArray ("HTTP/1.1 299 \r\n"));
+	QCOMPARE(writer.writeResponseLine (HttpClient::Http1_0, 700, QByteArray ()),
+		 QByteArray ("HTTP/1.0 700 \r\n"));
+}
+
 void HttpWriterTest::writeSetCookieValue_data () {
 	QTest::addColumn< QNetworkCookie > ("input");
 	QTest::addColumn< QString > ("result");
@@ -174,6 +188,45 @@ void HttpWriterTest::writeHttpHeaders () {
 	QCOMPARE(result, expected);
 }
 
+void HttpWriterTest::writeResponseHeader () {
+	HttpWriter writer;
+	
+	HttpClient::HeaderMap map {
+		{ "Foo", "Bar" },
+		{ "Nuria", "Project" }
+	};
+	
+	HttpClient::Cookies cookies { { "session", QNetworkCookie ("session", "foo") } };
+	
+	QByteArray expected = "HTTP/1.1 404 Not Found\r\n"
+			      "Foo: Bar\r\n"
+			      "Nuria: Project\r\n"
+			      "Set-Cookie: session=foo\r\n"
+			      "\r\n";
+	
+	// 
+	QByteArray result = writer.writeResponseHeader (HttpClient::Http1_1, 404, QByteArray (),
+							map, cookies);
+	QCOMPARE(result, expected);
+}
+
+void HttpWriterTest::writeResponseHeaderWithFixedHeaders () {
+	HttpWriter writer;
+	
+	HttpClient::HeaderMap map { { "Foo", "Bar" } };
+	QByteArray fixed = writer.writeHttpHeaders ({ { "Cache-Control", "no-cache" } });
+	
+	QByteArray expected = "HTTP/1.0 200 Yay\r\n"
+			      "Foo: Bar\r\n"
+			      "Cache-Control: no-cache\r\n"
+			      "\r\n";
+	
+	// 
+	QByteArray result = writer.writeResponseHeader (HttpClient::Http1_0, 200, "Yay", map,
+							HttpClient::Cookies (), fixed);
+	QCOMPARE(result, expected);
+}
+
 void HttpWriterTest::dateTimeToHttpDateHeader () {
 	HttpWriter writer;
 	QDateTime dateTime (QDate (2012, 11, 10), QTime (1, 2, 3));
@@ -183,6 +236,22 @@ void HttpWriterTest::dateTimeToHttpDateHeader () {
 	
 }
 
+void HttpWriterTest::currentHttpDate () {
+	HttpWriter writer;
+	
+	QDateTime before = QDateTime::currentDateTimeUtc ();
+	QByteArray result = writer.currentHttpDate ();
+	QDateTime after = QDateTime::currentDateTimeUtc ();
+	
+	QByteArray lower = writer.dateTimeToHttpDateHeader (before);
+	QByteArray upper = writer.dateTimeToHttpDateHeader (after);
+	QVERIFY(result == lower || result == upper);
+	
+	// Later calls return the cached value until the second changes
+	QByteArray second = writer.currentHttpDate ();
+	QVERIFY(second == result || second == writer.dateTimeToHttpDateHeader (QDateTime::currentDateTimeUtc ()));
+}
+
 void HttpWriterTest::buildRangeHeader () {
 	HttpWriter writer;
 	
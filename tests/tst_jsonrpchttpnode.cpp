@@ -0,0 +1,249 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <nuria/jsonrpchttpnode.hpp>
+
+#include <QtTest/QtTest>
+#include <QObject>
+
+#include "httpmemorytransport.hpp"
+#include <nuria/httpserver.hpp>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QThreadPool>
+
+using namespace Nuria;
+
+// 
+class JsonRpcHttpNodeTest : public QObject {
+	Q_OBJECT
+private slots:
+	
+	void initTestCase ();
+	void connectMethodChecksArguments ();
+	
+	void singleRequest_data ();
+	void singleRequest ();
+	
+	void notificationIsNotAnswered ();
+	void getIsRejected ();
+	void batchRequest ();
+	void batchIsDispatchedConcurrently ();
+	void batchRunsInClientThreadByDefault ();
+	void batchOfNotificationsIsNotAnswered ();
+	
+private:
+	
+	HttpClient *post (const QByteArray &body) {
+		HttpMemoryTransport *transport = new HttpMemoryTransport (this->server);
+		HttpClient *client = new HttpClient (transport, this->server);
+		
+		transport->process (client, "POST /rpc HTTP/1.0\r\n"
+		                            "Content-Length: " + QByteArray::number (body.length ()) +
+		                            "\r\n\r\n" + body);
+		return client;
+	}
+	
+	QByteArray output (HttpClient *client) {
+		return qobject_cast< HttpMemoryTransport * > (client->transport ())->outData;
+	}
+	
+	QByteArray responseBody (HttpClient *client) {
+		QByteArray data = output (client);
+		return data.mid (data.indexOf ("\r\n\r\n") + 4);
+	}
+	
+	HttpServer *server = new HttpServer (this);
+	JsonRpcHttpNode *node = new JsonRpcHttpNode ("rpc");
+	QAtomicInt notified;
+	QAtomicInt running;
+	
+};
+
+void JsonRpcHttpNodeTest::initTestCase () {
+	server->root ()->addNode (node);
+	
+	node->connectMethod ("add", { "a", "b" }, Callback::fromLambda ([](int a, int b) {
+		return a + b;
+	}));
+	
+	node->connectMethod ("echo", Callback::fromLambda ([](QVariantMap params) {
+		return params;
+	}));
+	
+	node->connectMethod ("notify", Callback::fromLambda ([this]() {
+		this->notified.ref ();
+	}));
+	
+	// Returns true if invoked in the thread of the test.
+	node->connectMethod ("inThread", Callback::fromLambda ([this]() {
+		return (QThread::currentThread () == thread ());
+	}));
+	
+	// Returns true if another invocation ran at the same time.
+	node->connectMethod ("meet", Callback::fromLambda ([this]() {
+		this->running.ref ();
+		
+		QElapsedTimer timer;
+		timer.start ();
+		while (this->running.load () < 2 && timer.elapsed () < 5000) {
+			QThread::msleep (1);
+		}
+		
+		return this->running.load () >= 2;
+	}));
+	
+}
+
+void JsonRpcHttpNodeTest::connectMethodChecksArguments () {
+	Callback cb = Callback::fromLambda ([](int, int) { });
+	
+	QVERIFY(!node->connectMethod ("bad", { "a" }, cb));
+	QVERIFY(!node->connectMethod ("bad", cb));
+	QVERIFY(!node->hasMethod ("bad"));
+	
+	QVERIFY(node->connectMethod ("good", { "a", "b" }, cb));
+	QVERIFY(node->hasMethod ("good"));
+	QVERIFY(node->disconnectMethod ("good"));
+	QVERIFY(!node->hasMethod ("good"));
+}
+
+void JsonRpcHttpNodeTest::singleRequest_data () {
+	QTest::addColumn< QByteArray > ("request");
+	QTest::addColumn< QByteArray > ("response");
+	
+	QTest::newRow ("add") << QByteArray ("{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":{\"a\":1,\"b\":2},\"id\":1}")
+	                      << QByteArray ("{\"id\":1,\"jsonrpc\":\"2.0\",\"result\":3}");
+	QTest::newRow ("echo") << QByteArray ("{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":{\"a\":\"b\"},\"id\":\"x\"}")
+	                       << QByteArray ("{\"id\":\"x\",\"jsonrpc\":\"2.0\",\"result\":{\"a\":\"b\"}}");
+	QTest::newRow ("missing param") << QByteArray ("{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":{\"a\":1},\"id\":2}")
+	                                << QByteArray ("{\"error\":{\"code\":-32602,\"message\":\"Invalid params\"},"
+	                                               "\"id\":2,\"jsonrpc\":\"2.0\"}");
+	QTest::newRow ("unknown method") << QByteArray ("{\"jsonrpc\":\"2.0\",\"method\":\"nope\",\"id\":3}")
+	                                 << QByteArray ("{\"error\":{\"code\":-32601,\"message\":\"Method not found\"},"
+	                                                "\"id\":3,\"jsonrpc\":\"2.0\"}");
+	QTest::newRow ("parse error") << QByteArray ("{\"jsonrpc\":")
+	                              << QByteArray ("{\"error\":{\"code\":-32700,\"message\":\"Parse error\"},"
+	                                             "\"id\":null,\"jsonrpc\":\"2.0\"}");
+	QTest::newRow ("empty batch") << QByteArray ("[]")
+	                              << QByteArray ("{\"error\":{\"code\":-32600,\"message\":\"Invalid Request\"},"
+	                                             "\"id\":null,\"jsonrpc\":\"2.0\"}");
+}
+
+void JsonRpcHttpNodeTest::singleRequest () {
+	QFETCH(QByteArray, request);
+	QFETCH(QByteArray, response);
+	
+	HttpClient *client = post (request);
+	QVERIFY(!client->isOpen ());
+	QVERIFY(output (client).startsWith ("HTTP/1.0 200"));
+	QVERIFY(output (client).contains ("Content-Type: application/json"));
+	QCOMPARE(responseBody (client), response);
+}
+
+void JsonRpcHttpNodeTest::notificationIsNotAnswered () {
+	int before = notified.load ();
+	HttpClient *client = post ("{\"jsonrpc\":\"2.0\",\"method\":\"notify\"}");
+	
+	QVERIFY(!client->isOpen ());
+	QCOMPARE(notified.load (), before + 1);
+	QVERIFY(output (client).startsWith ("HTTP/1.0 204"));
+	QCOMPARE(responseBody (client), QByteArray ());
+}
+
+void JsonRpcHttpNodeTest::getIsRejected () {
+	HttpMemoryTransport *transport = new HttpMemoryTransport (this->server);
+	HttpClient *client = new HttpClient (transport, this->server);
+	
+	transport->process (client, "GET /rpc HTTP/1.0\r\n\r\n");
+	QVERIFY(transport->outData.startsWith ("HTTP/1.0 405"));
+}
+
+void JsonRpcHttpNodeTest::batchRequest () {
+	HttpClient *client = post ("["
+	                           "{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":{\"a\":1,\"b\":2},\"id\":1},"
+	                           "{\"jsonrpc\":\"2.0\",\"method\":\"notify\"},"
+	                           "{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":{\"a\":3,\"b\":4},\"id\":2},"
+	                           "{\"jsonrpc\":\"2.0\",\"method\":\"nope\",\"id\":3},"
+	                           "5"
+	                           "]");
+	
+	QTRY_VERIFY(!client->isOpen ());
+	QVERIFY(output (client).startsWith ("HTTP/1.0 200"));
+	
+	// Responses are sent in order of completion
+	QJsonArray array = QJsonDocument::fromJson (responseBody (client)).array ();
+	QCOMPARE(array.size (), 4);
+	
+	QMap< int, QJsonObject > byId; // A null id is mapped to 0
+	for (const QJsonValue &value : array) {
+		QJsonObject object = value.toObject ();
+		byId.insert (object.value ("id").toInt (0), object);
+	}
+	
+	QCOMPARE(byId.value (1).value ("result").toInt (), 3);
+	QCOMPARE(byId.value (2).value ("result").toInt (), 7);
+	QCOMPARE(byId.value (3).value ("error").toObject ().value ("code").toInt (), -32601);
+	QCOMPARE(byId.value (0).value ("error").toObject ().value ("code").toInt (), -32600);
+}
+
+void JsonRpcHttpNodeTest::batchIsDispatchedConcurrently () {
+	QThreadPool pool;
+	pool.setMaxThreadCount (2);
+	node->setThreadPool (&pool);
+	running.store (0);
+	
+	HttpClient *client = post ("["
+	                           "{\"jsonrpc\":\"2.0\",\"method\":\"meet\",\"id\":1},"
+	                           "{\"jsonrpc\":\"2.0\",\"method\":\"meet\",\"id\":2}"
+	                           "]");
+	
+	QTRY_VERIFY_WITH_TIMEOUT(!client->isOpen (), 10000);
+	node->setThreadPool (nullptr);
+	
+	QCOMPARE(responseBody (client).count ("\"result\":true"), 2);
+	QVERIFY(!node->threadPool ());
+}
+
+void JsonRpcHttpNodeTest::batchRunsInClientThreadByDefault () {
+	QVERIFY(!node->threadPool ());
+	
+	HttpClient *client = post ("["
+	                           "{\"jsonrpc\":\"2.0\",\"method\":\"inThread\",\"id\":1},"
+	                           "{\"jsonrpc\":\"2.0\",\"method\":\"inThread\",\"id\":2}"
+	                           "]");
+	
+	// Answered right away, without going through the event loop
+	QVERIFY(!client->isOpen ());
+	QCOMPARE(responseBody (client).count ("\"result\":true"), 2);
+}
+
+void JsonRpcHttpNodeTest::batchOfNotificationsIsNotAnswered () {
+	int before = notified.load ();
+	HttpClient *client = post ("["
+	                           "{\"jsonrpc\":\"2.0\",\"method\":\"notify\"},"
+	                           "{\"jsonrpc\":\"2.0\",\"method\":\"notify\"}"
+	                           "]");
+	
+	QTRY_VERIFY(!client->isOpen ());
+	QCOMPARE(notified.load (), before + 2);
+	QVERIFY(output (client).startsWith ("HTTP/1.0 204"));
+	QCOMPARE(responseBody (client), QByteArray ());
+}
+
+QTEST_MAIN(JsonRpcHttpNodeTest)
+#include "tst_jsonrpchttpnode.moc"
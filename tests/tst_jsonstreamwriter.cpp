@@ -0,0 +1,141 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QtTest/QtTest>
+#include <QJsonDocument>
+#include <QObject>
+
+#include "private/jsonstreamwriter.hpp"
+
+using namespace Nuria::Internal;
+
+struct Custom {
+	int value;
+};
+
+Q_DECLARE_METATYPE(Custom)
+
+// Records each write as a chunk.
+class ChunkDevice : public QIODevice {
+public:
+	QList< QByteArray > chunks;
+	
+	ChunkDevice () { open (WriteOnly); }
+	
+protected:
+	qint64 readData (char *, qint64) override { return -1; }
+	qint64 writeData (const char *data, qint64 len) override {
+		chunks.append (QByteArray (data, int (len)));
+		return len;
+	}
+	
+};
+
+class JsonStreamWriterTest : public QObject {
+	Q_OBJECT
+private slots:
+	
+	void matchesQJsonDocument_data ();
+	void matchesQJsonDocument ();
+	
+	void escapeStrings ();
+	void writeNumbers ();
+	void customTypes ();
+	void topLevelFailure ();
+	void writesInChunks ();
+	
+};
+
+void JsonStreamWriterTest::matchesQJsonDocument_data () {
+	QTest::addColumn< QVariant > ("value");
+	
+	QVariantMap map;
+	map.insert ("string", "foo");
+	map.insert ("list", QVariantList { 1, true, QVariant (), "bar" });
+	map.insert ("nested", QVariantMap { { "a", QVariantList () }, { "b", QVariantMap () } });
+	
+	QTest::newRow ("map") << QVariant (map);
+	QTest::newRow ("list") << QVariant (QVariantList { "a", 2, false });
+	QTest::newRow ("string list") << QVariant (QStringList { "a", "b" });
+	QTest::newRow ("empty map") << QVariant (QVariantMap ());
+	QTest::newRow ("umlauts") << QVariant (QVariantList { QString::fromUtf8 ("\xC3\xA4\xC3\xB6") });
+}
+
+void JsonStreamWriterTest::matchesQJsonDocument () {
+	QFETCH(QVariant, value);
+	
+	QByteArray expected = QJsonDocument::fromVariant (value).toJson (QJsonDocument::Compact);
+	QCOMPARE(JsonStreamWriter::toJson (value), expected);
+}
+
+void JsonStreamWriterTest::escapeStrings () {
+	QString string = QString::fromLatin1 ("a\"b\\c\nd\te\x01", 10);
+	QCOMPARE(JsonStreamWriter::toJson (string), QByteArray ("\"a\\\"b\\\\c\\nd\\te\\u0001\""));
+	QCOMPARE(JsonStreamWriter::toJson (QByteArray ("x\ry")), QByteArray ("\"x\\ry\""));
+}
+
+void JsonStreamWriterTest::writeNumbers () {
+	QCOMPARE(JsonStreamWriter::toJson (Q_INT64_C(9007199254740993)), QByteArray ("9007199254740993"));
+	QCOMPARE(JsonStreamWriter::toJson (-5), QByteArray ("-5"));
+	QCOMPARE(JsonStreamWriter::toJson (0.1), QByteArray ("0.1"));
+	QCOMPARE(JsonStreamWriter::toJson (qInf ()), QByteArray ("null"));
+}
+
+void JsonStreamWriterTest::customTypes () {
+	auto converter = [](const QVariant &value) -> QVariant {
+		if (value.userType () == qMetaTypeId< Custom > ()) {
+			return QVariantMap { { "value", value.value< Custom > ().value } };
+		}
+		
+		return QVariant ();
+	};
+	
+	QVariantList list { QVariant::fromValue (Custom { 5 }), QVariant::fromValue (QPoint ()) };
+	QCOMPARE(JsonStreamWriter::toJson (list, converter), QByteArray ("[{\"value\":5},null]"));
+}
+
+void JsonStreamWriterTest::topLevelFailure () {
+	ChunkDevice device;
+	JsonStreamWriter writer (&device);
+	
+	QVERIFY(!writer.write (QVariant::fromValue (QPoint ())));
+	QVERIFY(!writer.flush ());
+	QVERIFY(device.chunks.isEmpty ());
+}
+
+void JsonStreamWriterTest::writesInChunks () {
+	QVariantList list;
+	for (int i = 0; i < 1000; i++) {
+		list.append (QString ("Element %1").arg (i));
+	}
+	
+	ChunkDevice device;
+	JsonStreamWriter writer (&device, 256);
+	QVERIFY(writer.write (list));
+	QVERIFY(writer.flush ());
+	
+	QVERIFY(device.chunks.length () > 10);
+	for (int i = 0; i < device.chunks.length () - 1; i++) {
+		QVERIFY(device.chunks.at (i).length () >= 256);
+		QVERIFY(device.chunks.at (i).length () < 256 + 64);
+	}
+	
+	QCOMPARE(device.chunks.join (), JsonStreamWriter::toJson (list));
+}
+
+QTEST_MAIN(JsonStreamWriterTest)
+#include "tst_jsonstreamwriter.moc"
@@ -0,0 +1,150 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QtTest/QtTest>
+#include <QObject>
+#include <QThread>
+
+#include "private/metrics.hpp"
+#include "httpmemorytransport.hpp"
+#include <nuria/metricshttpnode.hpp>
+#include <nuria/httpserver.hpp>
+#include <nuria/httpclient.hpp>
+
+using namespace Nuria::Internal;
+using namespace Nuria;
+
+enum { Threads = 4, Increments = 10000 };
+
+class CountingThread : public QThread {
+public:
+	void run () override {
+		for (int i = 0; i < Increments; i++) {
+			Metrics::add (Metrics::FastCgiRecordsSent);
+		}
+		
+		Metrics::requestFinished (299, 1000);
+	}
+	
+};
+
+class MetricsTest : public QObject {
+	Q_OBJECT
+private slots:
+	
+	void histogramBucketBounds ();
+	void histogramBucketsAreContiguous ();
+	void countersOfFinishedThreadsAreKept ();
+	void latencyPercentile ();
+	void gaugeCanBeDecremented ();
+	void nodeServesExposition ();
+	
+};
+
+void MetricsTest::histogramBucketBounds () {
+	for (quint64 value : { 0ULL, 1ULL, 15ULL, 16ULL, 17ULL, 33ULL, 1000ULL, 123456ULL, 987654321ULL }) {
+		int index = MetricsHistogram::bucketIndex (value);
+		QVERIFY(MetricsHistogram::lowerBound (index) <= value);
+		QVERIFY(MetricsHistogram::upperBound (index) >= value);
+		
+		// Relative error is bounded
+		quint64 width = MetricsHistogram::upperBound (index) - MetricsHistogram::lowerBound (index);
+		QVERIFY(width * MetricsHistogram::SubBuckets <= qMax (value, quint64 (MetricsHistogram::SubBuckets)));
+	}
+	
+	// Too large values end up in the last bucket
+	QCOMPARE(MetricsHistogram::bucketIndex (~0ULL), int (MetricsHistogram::Buckets) - 1);
+}
+
+void MetricsTest::histogramBucketsAreContiguous () {
+	for (int i = 1; i < MetricsHistogram::Buckets; i++) {
+		QCOMPARE(MetricsHistogram::lowerBound (i), MetricsHistogram::upperBound (i - 1) + 1);
+		QCOMPARE(MetricsHistogram::bucketIndex (MetricsHistogram::lowerBound (i)), i);
+		QCOMPARE(MetricsHistogram::bucketIndex (MetricsHistogram::upperBound (i)), i);
+	}
+	
+}
+
+void MetricsTest::countersOfFinishedThreadsAreKept () {
+	MetricsSnapshot before = Metrics::snapshot ();
+	
+	QVector< CountingThread * > threads;
+	for (int i = 0; i < Threads; i++) {
+		threads.append (new CountingThread);
+		threads.last ()->start ();
+	}
+	
+	for (CountingThread *thread : threads) {
+		QVERIFY(thread->wait (10000));
+	}
+	
+	qDeleteAll (threads);
+	
+	// 
+	MetricsSnapshot after = Metrics::snapshot ();
+	QCOMPARE(after.counters.at (Metrics::FastCgiRecordsSent) - before.counters.at (Metrics::FastCgiRecordsSent),
+	         quint64 (Threads * Increments));
+	QCOMPARE(after.counters.at (Metrics::RequestsTotal) - before.counters.at (Metrics::RequestsTotal),
+	         quint64 (Threads));
+	QCOMPARE(after.statusCodes.at (299 - Metrics::FirstStatusCode), quint64 (Threads));
+	QCOMPARE(after.latencyCount - before.latencyCount, quint64 (Threads));
+}
+
+void MetricsTest::latencyPercentile () {
+	MetricsSnapshot snapshot;
+	snapshot.latency.fill (0, MetricsHistogram::Buckets);
+	
+	// 99 fast and one slow value
+	snapshot.latency[MetricsHistogram::bucketIndex (100)] = 99;
+	snapshot.latency[MetricsHistogram::bucketIndex (100000)] = 1;
+	snapshot.latencyCount = 100;
+	
+	QCOMPARE(snapshot.latencyPercentile (50), MetricsHistogram::upperBound (MetricsHistogram::bucketIndex (100)));
+	QCOMPARE(snapshot.latencyPercentile (99), MetricsHistogram::upperBound (MetricsHistogram::bucketIndex (100)));
+	QCOMPARE(snapshot.latencyPercentile (100), MetricsHistogram::upperBound (MetricsHistogram::bucketIndex (100000)));
+}
+
+void MetricsTest::gaugeCanBeDecremented () {
+	qint64 before = qint64 (Metrics::snapshot ().counters.at (Metrics::OpenTransports));
+	
+	Metrics::add (Metrics::OpenTransports, 3);
+	Metrics::subtract (Metrics::OpenTransports, 5);
+	
+	QCOMPARE(qint64 (Metrics::snapshot ().counters.at (Metrics::OpenTransports)), before - 2);
+	Metrics::add (Metrics::OpenTransports, 2);
+}
+
+void MetricsTest::nodeServesExposition () {
+	HttpServer server;
+	server.root ()->addNode (new MetricsHttpNode ("metrics"));
+	
+	HttpMemoryTransport *transport = new HttpMemoryTransport (&server);
+	HttpClient *client = new HttpClient (transport, &server);
+	transport->process (client, "GET /metrics HTTP/1.0\r\n\r\n");
+	
+	QByteArray data = transport->outData;
+	QVERIFY(data.startsWith ("HTTP/1.0 200"));
+	QVERIFY(data.contains ("Content-Type: text/plain; version=0.0.4"));
+	QVERIFY(data.contains ("# TYPE nuria_http_requests_total counter\n"));
+	QVERIFY(data.contains ("nuria_http_responses_total{code=\"299\"} 4\n"));
+	QVERIFY(data.contains ("nuria_http_request_duration_seconds_bucket{le=\"+Inf\"}"));
+	QVERIFY(data.contains ("nuria_websocket_frames_total{direction=\"sent\"}"));
+	QVERIFY(data.contains ("nuria_fastcgi_records_total{direction=\"sent\"}"));
+}
+
+QTEST_MAIN(MetricsTest)
+#include "tst_metrics.moc"
@@ -34,9 +34,11 @@ private slots:
 	
 	void initTestCase ();
 	void registeringAHandler ();
+	void typedArguments ();
 	void returnFalseWhenPathNotFound ();
 	void allowAccessToClientsIsCalled ();
 	void invokeAnnotatedHandler ();
+	void invokeAnnotatedHandlerStreamed ();
 	
 	void invokeAnnotatedSpecificHandler_data ();
 	void invokeAnnotatedSpecificHandler ();
@@ -102,6 +104,35 @@ void RestfulHttpNodeTest::registeringAHandler () {
 	QCOMPARE(three, 3);
 }
 
+void RestfulHttpNodeTest::typedArguments () {
+	HttpClient *passedClient = nullptr;
+	qint64 integer = 0;
+	double real = 0;
+	bool boolean = true;
+	QByteArray bytes;
+	
+	Callback cb = Callback::fromLambda ([&](HttpClient *client_, qint64 integer_, double real_,
+	                                        bool boolean_, QByteArray bytes_) {
+		passedClient = client_;
+		integer = integer_;
+		real = real_;
+		boolean = boolean_;
+		bytes = bytes_;
+	});
+	
+	// 
+	reopenTransport ();
+	node->setRestfulHandler ("typed/{i}/{r}/{b}/{s}", { "i", "r", "b", "s" }, cb);
+	QVERIFY(node->invokeTest ("typed/-8589934592/1.5/FALSE/a/b", client));
+	
+	// 
+	QCOMPARE(passedClient, client);
+	QCOMPARE(integer, Q_INT64_C(-8589934592));
+	QCOMPARE(real, 1.5);
+	QCOMPARE(boolean, false);
+	QCOMPARE(bytes, QByteArray ("a/b"));
+}
+
 void RestfulHttpNodeTest::returnFalseWhenPathNotFound () {
 	reopenTransport ();
 	QVERIFY(!node->invokeTest ("does/not/exist", client));
@@ -125,6 +156,18 @@ void RestfulHttpNodeTest::invokeAnnotatedHandler () {
 	QCOMPARE(outData, QByteArray ("{\"boolean\":true,\"integer\":123,\"string\":\"foo\"}"));
 }
 
+void RestfulHttpNodeTest::invokeAnnotatedHandlerStreamed () {
+	client->setProperty ("someProperty", "abc");
+	QTest::ignoreMessage (QtDebugMsg, "foo 123 1 abc");
+	
+	reopenTransport ();
+	node->setStreamJsonResponses (true);
+	QVERIFY(node->invokeTest ("annotate/123/true/foo", client));
+	node->setStreamJsonResponses (false);
+	
+	QCOMPARE(transport->outData, QByteArray ("{\"boolean\":true,\"integer\":123,\"string\":\"foo\"}"));
+}
+
 void RestfulHttpNodeTest::invokeAnnotatedSpecificHandler_data () {
 	QTest::addColumn< QString > ("method");
 	
@@ -0,0 +1,211 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QtTest/QtTest>
+#include <QRegularExpression>
+#include <QObject>
+#include <algorithm>
+
+#include "private/restfulrouter.hpp"
+
+using namespace Nuria::Internal;
+
+enum { BenchmarkRoutes = 500 };
+
+class RestfulRouterTest : public QObject {
+	Q_OBJECT
+private slots:
+	
+	void insertRejectsRegexPatterns_data ();
+	void insertRejectsRegexPatterns ();
+	
+	void matchLiteral ();
+	void matchPlaceholder ();
+	void matchRest ();
+	void matchEmptyPath ();
+	void matchOverlappingRoutes ();
+	void capturedValues ();
+	
+	void benchmarkLookup_data ();
+	void benchmarkLookup ();
+	
+private:
+	
+	QVector< int > match (const RestfulRouter &router, const QString &path) {
+		RestfulRouter::Matches result;
+		router.match (path.split ('/'), 0, result);
+		
+		QVector< int > list;
+		for (int id : result) {
+			list.append (id);
+		}
+		
+		std::sort (list.begin (), list.end ());
+		return list;
+	}
+	
+};
+
+void RestfulRouterTest::insertRejectsRegexPatterns_data () {
+	QTest::addColumn< QString > ("pattern");
+	
+	QTest::newRow ("mixed segment") << "foo/{a}-{b}";
+	QTest::newRow ("prefixed placeholder") << "foo/x{a}";
+	QTest::newRow ("regex syntax") << "foo/ba.";
+	QTest::newRow ("bad name") << "foo/{a b}";
+	QTest::newRow ("empty name") << "foo/{}";
+	QTest::newRow ("duplicate name") << "{a}/{a}";
+}
+
+void RestfulRouterTest::insertRejectsRegexPatterns () {
+	QFETCH(QString, pattern);
+	
+	RestfulRouter router;
+	RestfulRouter::Captures captures;
+	QVERIFY(!router.insert (pattern, 0, captures));
+}
+
+void RestfulRouterTest::matchLiteral () {
+	RestfulRouter router;
+	RestfulRouter::Captures captures;
+	QVERIFY(router.insert ("foo/bar", 1, captures));
+	QVERIFY(router.insert ("foo/baz", 2, captures));
+	QVERIFY(captures.isEmpty ());
+	
+	QCOMPARE(match (router, "foo/bar"), QVector< int > { 1 });
+	QCOMPARE(match (router, "foo/baz"), QVector< int > { 2 });
+	QCOMPARE(match (router, "foo"), QVector< int > ());
+	QCOMPARE(match (router, "foo/bar/baz"), QVector< int > ());
+	QCOMPARE(match (router, "Foo/bar"), QVector< int > ());
+}
+
+void RestfulRouterTest::matchPlaceholder () {
+	RestfulRouter router;
+	RestfulRouter::Captures captures;
+	QVERIFY(router.insert ("user/{id}/name", 1, captures));
+	QCOMPARE(captures.length (), 1);
+	QCOMPARE(captures.first ().name, QString ("id"));
+	QCOMPARE(captures.first ().segment, 1);
+	QVERIFY(!captures.first ().rest);
+	
+	QCOMPARE(match (router, "user/42/name"), QVector< int > { 1 });
+	QCOMPARE(match (router, "user//name"), QVector< int > ());
+	QCOMPARE(match (router, "user/42"), QVector< int > ());
+}
+
+void RestfulRouterTest::matchRest () {
+	RestfulRouter router;
+	RestfulRouter::Captures captures;
+	QVERIFY(router.insert ("files/{path}", 1, captures));
+	QVERIFY(captures.first ().rest);
+	
+	QCOMPARE(match (router, "files/a"), QVector< int > { 1 });
+	QCOMPARE(match (router, "files/a/b/c"), QVector< int > { 1 });
+	QCOMPARE(match (router, "files//"), QVector< int > { 1 });
+	QCOMPARE(match (router, "files/"), QVector< int > ());
+	QCOMPARE(match (router, "files"), QVector< int > ());
+}
+
+void RestfulRouterTest::matchEmptyPath () {
+	RestfulRouter router;
+	RestfulRouter::Captures captures;
+	QVERIFY(router.insert ("", 1, captures));
+	
+	RestfulRouter::Matches result;
+	router.match (QStringList { "api" }, 1, result);
+	QCOMPARE(result.length (), 1);
+	QCOMPARE(match (router, ""), QVector< int > { 1 });
+}
+
+void RestfulRouterTest::matchOverlappingRoutes () {
+	RestfulRouter router;
+	RestfulRouter::Captures captures;
+	QVERIFY(router.insert ("item/{id}", 1, captures));
+	QVERIFY(router.insert ("item/{id}/{name}", 2, captures));
+	QVERIFY(router.insert ("item/new", 3, captures));
+	QVERIFY(router.insert ("item/{id}/edit", 4, captures));
+	
+	QCOMPARE(match (router, "item/new"), QVector< int > ({ 1, 3 }));
+	QCOMPARE(match (router, "item/5/edit"), QVector< int > ({ 1, 2, 4 }));
+	QCOMPARE(match (router, "item/5/foo"), QVector< int > ({ 1, 2 }));
+}
+
+void RestfulRouterTest::capturedValues () {
+	RestfulRouter router;
+	RestfulRouter::Captures captures;
+	QVERIFY(router.insert ("{a}/x/{b}", 1, captures));
+	
+	QStringList parts { "api", "1", "x", "2", "3" };
+	QCOMPARE(RestfulRouter::captured (captures, "a", parts, 1), QString ("1"));
+	QCOMPARE(RestfulRouter::captured (captures, "b", parts, 1), QString ("2/3"));
+	QCOMPARE(RestfulRouter::captured (captures, "c", parts, 1), QString ());
+}
+
+void RestfulRouterTest::benchmarkLookup_data () {
+	QTest::addColumn< bool > ("useRegex");
+	
+	QTest::newRow ("router") << false;
+	QTest::newRow ("regex") << true;
+}
+
+void RestfulRouterTest::benchmarkLookup () {
+	QFETCH(bool, useRegex);
+	
+	// Routes like RestfulHttpNode::compilePathRegEx() would create them
+	RestfulRouter router;
+	QMap< QString, QRegularExpression > regexes;
+	for (int i = 0; i < BenchmarkRoutes; i++) {
+		RestfulRouter::Captures captures;
+		QString resource = QString ("resource%1").arg (i);
+		
+		router.insert (resource + "/{id}", i * 2, captures);
+		router.insert (resource + "/{id}/items/{item}", i * 2 + 1, captures);
+		
+		QString a = "^" + resource + "/(?<id>.+)$";
+		QString b = "^" + resource + "/(?<id>[^/]+)/items/(?<item>.+)$";
+		regexes.insert (a, QRegularExpression (a));
+		regexes.insert (b, QRegularExpression (b));
+	}
+	
+	// Worst case for the regex walk
+	QStringList parts = QString ("api/resource0/123/items/456").split ('/');
+	
+	if (useRegex) {
+		QBENCHMARK {
+			QString path = QStringList (parts.mid (1)).join ('/');
+			for (auto it = regexes.constEnd (); it != regexes.constBegin (); ) {
+				--it;
+				if (it->match (path).hasMatch ()) {
+					break;
+				}
+				
+			}
+			
+		}
+		
+	} else {
+		QBENCHMARK {
+			RestfulRouter::Matches result;
+			router.match (parts, 1, result);
+		}
+		
+	}
+	
+}
+
+QTEST_MAIN(RestfulRouterTest)
+#include "tst_restfulrouter.moc"
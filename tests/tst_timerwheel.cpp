@@ -0,0 +1,172 @@
+/* Copyright (c) 2014-2015, The Nuria Project
+ * The NuriaProject Framework is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ * 
+ * The NuriaProject Framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with The NuriaProject Framework.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest/QtTest>
+#include <QObject>
+
+#include "private/timerwheel.hpp"
+
+using namespace Nuria::Internal;
+
+class TestEntry : public TimerWheel::Entry {
+public:
+	int expiredCount = 0;
+	int rearmInterval = -1;
+	
+	void expired () override {
+		this->expiredCount++;
+		if (this->rearmInterval >= 0) {
+			TimerWheel::current ()->arm (this, this->rearmInterval);
+		}
+		
+	}
+	
+};
+
+class TimerWheelTest : public QObject {
+	Q_OBJECT
+private slots:
+	
+	void entryExpiresAfterInterval ();
+	void cancelledEntryDoesntExpire ();
+	void rearmingPostponesExpiry ();
+	void destroyedEntryIsRemoved ();
+	void entryCanRearmItself ();
+	void manyEntriesInSameSlot ();
+	void finishedThreadShutsDownWheel ();
+	
+private:
+	
+	void eventLoopSleep (int msec) {
+		QEventLoop loop;
+		QTimer::singleShot (msec, &loop, SLOT(quit()));
+		loop.exec ();
+	}
+	
+};
+
+void TimerWheelTest::entryExpiresAfterInterval () {
+	TestEntry entry;
+	TimerWheel::current ()->arm (&entry, 100);
+	QVERIFY(entry.isArmed ());
+	QCOMPARE(TimerWheel::current ()->count (), 1);
+	
+	eventLoopSleep (50);
+	QCOMPARE(entry.expiredCount, 0);
+	
+	eventLoopSleep (100);
+	QCOMPARE(entry.expiredCount, 1);
+	QVERIFY(!entry.isArmed ());
+	QCOMPARE(TimerWheel::current ()->count (), 0);
+}
+
+void TimerWheelTest::cancelledEntryDoesntExpire () {
+	TestEntry entry;
+	TimerWheel::current ()->arm (&entry, 50);
+	TimerWheel::cancel (&entry);
+	QVERIFY(!entry.isArmed ());
+	
+	eventLoopSleep (100);
+	QCOMPARE(entry.expiredCount, 0);
+}
+
+void TimerWheelTest::rearmingPostponesExpiry () {
+	TestEntry entry;
+	TimerWheel::current ()->arm (&entry, 100);
+	
+	eventLoopSleep (60);
+	TimerWheel::current ()->arm (&entry, 100);
+	QCOMPARE(TimerWheel::current ()->count (), 1);
+	
+	eventLoopSleep (60);
+	QCOMPARE(entry.expiredCount, 0);
+	
+	eventLoopSleep (100);
+	QCOMPARE(entry.expiredCount, 1);
+}
+
+void TimerWheelTest::destroyedEntryIsRemoved () {
+	TestEntry *entry = new TestEntry;
+	TimerWheel::current ()->arm (entry, 20);
+	delete entry;
+	
+	QCOMPARE(TimerWheel::current ()->count (), 0);
+	eventLoopSleep (50);
+}
+
+void TimerWheelTest::entryCanRearmItself () {
+	TestEntry entry;
+	entry.rearmInterval = 20;
+	TimerWheel::current ()->arm (&entry, 20);
+	
+	eventLoopSleep (150);
+	TimerWheel::cancel (&entry);
+	
+	QVERIFY(entry.expiredCount >= 2);
+	QVERIFY(entry.expiredCount <= 7);
+}
+
+void TimerWheelTest::manyEntriesInSameSlot () {
+	enum { Count = 100 };
+	TestEntry entries[Count];
+	
+	// Half of them one round of the wheel later
+	int interval = TimerWheel::Slots * TimerWheel::TickInterval;
+	for (int i = 0; i < Count; i++) {
+		TimerWheel::current ()->arm (&entries[i], (i % 2) ? 30 : 30 + interval);
+	}
+	
+	eventLoopSleep (100);
+	for (int i = 0; i < Count; i++) {
+		QCOMPARE(entries[i].expiredCount, (i % 2) ? 1 : 0);
+	}
+	
+	QCOMPARE(TimerWheel::current ()->count (), Count / 2);
+	for (int i = 0; i < Count; i++) {
+		TimerWheel::cancel (&entries[i]);
+	}
+	
+	QCOMPARE(TimerWheel::current ()->count (), 0);
+}
+
+void TimerWheelTest::finishedThreadShutsDownWheel () {
+	QThread thread;
+	TestEntry entry;
+	int countAtFinish = -1;
+	bool armedAtFinish = true;
+	
+	// Runs in the thread. The wheel connects to finished() first.
+	connect (&thread, &QThread::started, [&]() {
+		TimerWheel::current ()->arm (&entry, 10000);
+		
+		connect (&thread, &QThread::finished, [&]() {
+			countAtFinish = TimerWheel::current ()->count ();
+			armedAtFinish = entry.isArmed ();
+		});
+		
+		thread.quit ();
+	});
+	
+	thread.start ();
+	QVERIFY(thread.wait (5000));
+	
+	QCOMPARE(countAtFinish, 0);
+	QVERIFY(!armedAtFinish);
+	QCOMPARE(entry.expiredCount, 0);
+}
+
+QTEST_MAIN(TimerWheelTest)
+#include "tst_timerwheel.moc"